@@ -26,6 +26,8 @@
 #
 # Authors: Lisa Hsu
 
+import multiprocessing
+
 import m5
 from m5.defines import buildEnv
 from m5.objects import *
@@ -133,6 +135,61 @@ def addCommonOptions(parser):
                help="file to read input for fi_system")
     parser.add_option("-M","--exit-on-first-checkpoint",action="store",type="int",dest="exit_on_checkpoint",default=0,
 		help="Exit simulation after first checkpoint")
+    parser.add_option("--fi-campaign", action="store_true", default=False,
+               help="run the golden execution once and fork one child per fault")
+    parser.add_option("--fi-max-children", action="store", type="int",
+               default=multiprocessing.cpu_count(),
+               help="maximum number of fault injection children running at once")
+    parser.add_option("--fi-digest-interval", action="store", type="int", default=0,
+               help="hash the architectural state every this many instruction events (0: off)")
+    parser.add_option("--fi-golden-digests", action="store", type="string", default="",
+               help="digests of the golden run, a faulty run that converges to them exits as masked")
+    parser.add_option("--fi-record-digests", action="store_true", default=False,
+               help="record the digests of this run (to --fi-golden-digests in the output directory)")
+    parser.add_option("--fi-snapshot-interval", action="store", type="int", default=0,
+               help="snapshot the golden run every this many instruction events (0: off)")
+    parser.add_option("--fi-max-snapshots", action="store", type="int", default=4,
+               help="snapshots the golden run of a campaign keeps alive")
+    parser.add_option("--fi-snapshot-budget", action="store", type="string", default="0B",
+               help="memory the snapshots may take (0B: no limit)")
+    parser.add_option("--fi-snapshot-spill", action="store_true", default=False,
+               help="write the snapshots as checkpoints (cpt.fi.<tick>) instead")
+    parser.add_option("--fi-auto-switch", action="store_true", default=False,
+               help="run atomic and switch to --cpu-type only around the faults")
+    parser.add_option("--fi-switch-warmup", action="store", type="int", default=1000000,
+               help="instruction events before a fault the detailed cpu starts")
+    parser.add_option("--fi-switch-warmup-ticks", action="store", type="int", default=500000000,
+               help="ticks before a fault the detailed cpu starts")
+    parser.add_option("--fi-lockstep-lanes", action="store", type="int", default=0,
+               help="register faults of a campaign carried along the golden run until they diverge")
+    parser.add_option("--fi-liveness-profile", action="store", type="string", default="",
+               help="profile the register liveness of the golden run to this file (atomic cpu), see util/fi_prune.py")
+    parser.add_option("--fi-mem-uses", action="store", type="string", default="",
+               help="only observe the faults and write the next access of each memory fault byte to this file, see util/fi_collapse.py")
+    parser.add_option("--fi-mem-timeline", action="store", type="string", default="",
+               help="memory access timelines of the golden run, a campaign skips the memory faults they show are masked")
+    parser.add_option("--fi-record-mem-timeline", action="store_true", default=False,
+               help="record the memory access timelines of this run to --fi-mem-timeline")
+    parser.add_option("--fi-golden-totals", action="store", type="string", default="",
+               help="per thread instruction and tick totals of the golden run, for the hang watchdog")
+    parser.add_option("--fi-record-golden-totals", action="store_true", default=False,
+               help="record the totals of this run to --fi-golden-totals")
+    parser.add_option("--fi-hang-factor", action="store", type="float", default=0.0,
+               help="end a faulty run as a hang once it runs this many times the golden totals")
+    parser.add_option("--fi-watch-interval", action="store", type="int", default=100000,
+               help="instruction events between two checks of the hang watchdog and the loop detector")
+    parser.add_option("--fi-loop-samples", action="store", type="int", default=0,
+               help="end a faulty run as a hang after this many sample bursts in a row see the same pc and registers twice")
+    parser.add_option("--fi-loop-window", action="store", type="int", default=64,
+               help="committed instructions a loop detector burst samples, the longest loop period it catches")
+    parser.add_option("--fi-warm", action="store_true", default=False,
+               help="train the predictor of the switch cpus from the atomic cpu and hand the TLBs over on switches")
+    parser.add_option("--delta-checkpoints", action="store_true", default=False,
+               help="after the first checkpoint save only the memory pages written since")
+    parser.add_option("--raw-checkpoints", action="store_true", default=False,
+               help="save the memory uncompressed so restores map it copy on write")
+    parser.add_option("--chunked-checkpoints", action="store_true", default=False,
+               help="save the memory as chunks compressed in parallel, leaving out zero pages")
                 
                 
 def addSEOptions(parser):
@@ -64,7 +64,12 @@ def setCPUClass(options):
     test_mem_mode = 'atomic'
 
     if not atomic:
-        if options.checkpoint_restore != None:
+        if getattr(options, 'fi_auto_switch', False):
+            # start atomic, the fault injection system asks for the
+            # detailed cpu around the faults
+            CPUClass = TmpClass
+            class TmpClass(AtomicSimpleCPU): pass
+        elif options.checkpoint_restore != None:
             if options.restore_with_cpu != options.cpu_type:
                 CPUClass = TmpClass
                 class TmpClass(AtomicSimpleCPU): pass
@@ -97,6 +102,37 @@ def setWorkCountOptions(system, options):
     if options.work_cpus_checkpoint_count != None:
         system.work_cpus_ckpt_count = options.work_cpus_checkpoint_count
 
+# Runs with the atomic cpus, switching to the detailed ones (and back) when
+# the fault injection system asks for it. The checkpoint the fault injection
+# system asks for before it starts (check_before_init) is taken as in run()
+def fiAutoSwitch(testsys, switch_cpu_list, maxtick, cptdir, exit_on_checkpoint):
+    back_cpu_list = [(new, old) for (old, new) in switch_cpu_list]
+    exit_event = m5.simulate(maxtick - m5.curTick())
+    exit_cause = exit_event.getCause()
+    while exit_cause in ("fi switch detailed", "fi switch atomic",
+                         "fi snapshot", "checkpoint"):
+        if exit_cause == "fi switch detailed":
+            print "Switching to the detailed cpus @ tick %i" % m5.curTick()
+            m5.changeToTiming(testsys)
+            m5.switchCpus(switch_cpu_list)
+            m5.resume(testsys)
+        elif exit_cause == "fi switch atomic":
+            print "Switching to the atomic cpus @ tick %i" % m5.curTick()
+            m5.changeToAtomic(testsys)
+            m5.switchCpus(back_cpu_list)
+            m5.resume(testsys)
+        elif exit_cause == "checkpoint":
+            m5.checkpoint(joinpath(cptdir, "cpt.%d"))
+            if exit_on_checkpoint:
+                exit_cause = "fault injection checkpoint dropped"
+                break
+        else:
+            m5.checkpoint(joinpath(cptdir, "cpt.fi.%d"))
+        exit_event = m5.simulate(maxtick - m5.curTick())
+        exit_cause = exit_event.getCause()
+    print "Fault Injection System stopped"
+    print "Exiting @ tick %i because %s" % (m5.curTick(), exit_cause)
+
 def run(options, root, testsys, cpu_class):
     if options.maxtick:
         maxtick = options.maxtick
@@ -148,6 +184,12 @@ def run(options, root, testsys, cpu_class):
             # Add checker cpu if selected
             if options.checker:
                 switch_cpus[i].addCheckerCpu()
+            # keep the predictor and TLBs of the detailed cpu warm
+            if getattr(options, 'fi_warm', False):
+                if isinstance(testsys.cpu[i], AtomicSimpleCPU):
+                    testsys.cpu[i].warm_cpu = switch_cpus[i]
+                testsys.cpu[i].takeover_tlbs = True
+                switch_cpus[i].takeover_tlbs = True
 
         testsys.switch_cpus = switch_cpus
         switch_cpu_list = [(testsys.cpu[i], switch_cpus[i]) for i in xrange(np)]
@@ -277,6 +319,11 @@ def run(options, root, testsys, cpu_class):
             print "Switch at instruction count:%s" % \
                     str(testsys.cpu[0].max_insts_any_thread)
             exit_event = m5.simulate()
+        elif getattr(options, 'fi_auto_switch', False):
+            print "Using Fault Injection Method with a detailed window"
+            fiAutoSwitch(testsys, switch_cpu_list, maxtick, cptdir,
+                         options.exit_on_checkpoint)
+            return
         else:
             print "Using Fault Injection Method"
             print "1) Simulate with Detailed"
@@ -409,9 +456,19 @@ def run(options, root, testsys, cpu_class):
         print "**** REAL SIMULATION ****"
         exit_event = m5.simulate(maxtick)
 
-        while exit_event.getCause() == "checkpoint":
+        while exit_event.getCause() in ("checkpoint", "fi snapshot"):
+            if exit_event.getCause() == "fi snapshot":
+                # a snapshot of the fault injection golden run, it does
+                # not count as a checkpoint
+                m5.checkpoint(joinpath(cptdir, "cpt.fi.%d"))
+                exit_event = m5.simulate(maxtick - m5.curTick())
+                exit_cause = exit_event.getCause()
+                continue
             m5.checkpoint(joinpath(cptdir, "cpt.%d"))
             num_checkpoints += 1
+            if options.exit_on_checkpoint:
+                exit_cause = "fault injection checkpoint dropped"
+                break
             if num_checkpoints == max_checkpoints:
                 exit_cause = "maximum %d checkpoints dropped" % max_checkpoints
                 break
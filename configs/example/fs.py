@@ -186,7 +186,32 @@ if options.timesync:
 if options.frame_capture:
     VncServer.frame_capture = True
 
-test_sys.fi_system=Fi_System(input_fi=options.fi_input,check_before_init=options.exit_on_checkpoint)
+test_sys.fi_system=Fi_System(input_fi=options.fi_input,check_before_init=options.exit_on_checkpoint,
+                             campaign=options.fi_campaign,max_children=options.fi_max_children,
+                             digest_interval=options.fi_digest_interval,
+                             golden_digests=options.fi_golden_digests,
+                             record_digests=options.fi_record_digests,
+                             snapshot_interval=options.fi_snapshot_interval,
+                             max_snapshots=options.fi_max_snapshots,
+                             snapshot_budget=options.fi_snapshot_budget,
+                             snapshot_spill=options.fi_snapshot_spill,
+                             auto_switch=options.fi_auto_switch,
+                             switch_warmup=options.fi_switch_warmup,
+                             switch_warmup_ticks=options.fi_switch_warmup_ticks,
+                             lockstep_lanes=options.fi_lockstep_lanes,
+                             liveness_profile=options.fi_liveness_profile,
+                             mem_uses=options.fi_mem_uses,
+                             mem_timeline=options.fi_mem_timeline,
+                             record_mem_timeline=options.fi_record_mem_timeline,
+                             golden_totals=options.fi_golden_totals,
+                             record_golden_totals=options.fi_record_golden_totals,
+                             hang_factor=options.fi_hang_factor,
+                             watch_interval=options.fi_watch_interval,
+                             loop_samples=options.fi_loop_samples,
+                             loop_window=options.fi_loop_window)
+test_sys.physmem.delta_checkpoints = options.delta_checkpoints
+test_sys.physmem.raw_checkpoints = options.raw_checkpoints
+test_sys.physmem.chunked_checkpoints = options.chunked_checkpoints
 
 m5.disableAllListeners()
 Simulation.setWorkCountOptions(test_sys, options)
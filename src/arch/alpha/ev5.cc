@@ -39,6 +39,7 @@
 #include "cpu/base.hh"
 #include "cpu/simple_thread.hh"
 #include "cpu/thread_context.hh"
+#include "fi/fi_system.hh"
 #include "sim/sim_exit.hh"
 
 namespace AlphaISA {
@@ -256,6 +257,11 @@ ISA::setIpr(int idx, uint64_t val, ThreadContext *tc)
         if (tc->getKernelStats())
             tc->getKernelStats()->context(ipr[idx], val, tc);
         ipr[idx] = val;
+        //ALTERCODE
+        // context switch, find if the new thread injects faults
+        if (FI_ON && fi_system)
+            fi_system->update_fi_thread(tc, val);
+        //~ALTERCODE
         break;
 
       case IPR_DTB_PTE:
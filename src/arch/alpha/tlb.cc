@@ -286,6 +286,35 @@ TLB::flushAll()
     nlu = 0;
 }
 
+//ALTERCODE
+void
+TLB::takeOverFrom(BaseTLB *old)
+{
+    TLB *other = dynamic_cast<TLB *>(old);
+    if (!other || other == this)
+        return;
+
+    flushAll();
+    // oldest entry first, so a smaller TLB keeps the most recent ones
+    for (int i = 0; i < other->size; i++) {
+        TlbEntry &entry = other->table[(other->nlu + i) % other->size];
+        if (!entry.valid)
+            continue;
+        if (table[nlu].valid) {
+            PageTable::iterator j = lookupTable.find(table[nlu].tag);
+            while (j->second != nlu)
+                ++j;
+            lookupTable.erase(j);
+        }
+        table[nlu] = entry;
+        lookupTable.insert(make_pair(entry.tag, nlu));
+        nextnlu();
+    }
+    DPRINTF(TLB, "took over %d entries from %s\n", lookupTable.size(),
+            other->name());
+}
+//~ALTERCODE
+
 void
 TLB::flushProcesses()
 {
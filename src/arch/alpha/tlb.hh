@@ -95,6 +95,9 @@ class TLB : public BaseTLB
     void insert(Addr vaddr, TlbEntry &entry);
 
     void flushAll();
+    //ALTERCODE
+    void takeOverFrom(BaseTLB *old);
+    //~ALTERCODE
     void flushProcesses();
     void flushAddr(Addr addr, uint8_t asn);
 
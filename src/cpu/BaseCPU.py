@@ -144,6 +144,8 @@ class BaseCPU(MemObject):
 
     defer_registration = Param.Bool(False,
         "defer registration with system (for sampling)")
+    takeover_tlbs = Param.Bool(False,
+        "copy the TLB entries of the cpu this one takes over from")
 
     clock = Param.Clock('1t', "clock speed")
     phase = Param.Latency('0ns', "clock phase")
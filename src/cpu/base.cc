@@ -59,6 +59,9 @@
 #include "cpu/profile.hh"
 #include "cpu/thread_context.hh"
 #include "debug/SyscallVerbose.hh"
+//ALTERCODE
+#include "fi/fi_system.hh"
+//~ALTERCODE
 #include "params/BaseCPU.hh"
 #include "sim/full_system.hh"
 #include "sim/process.hh"
@@ -116,6 +119,7 @@ CPUProgressEvent::description() const
 
 BaseCPU::BaseCPU(Params *p, bool is_checker)
     : MemObject(p), clock(p->clock), instCnt(0), _cpuId(p->cpu_id),
+      _fiCoreId(-1),
       _instMasterId(p->system->getMasterId(name() + ".inst")),
       _dataMasterId(p->system->getMasterId(name() + ".data")),
       interrupts(p->interrupts),
@@ -384,6 +388,12 @@ BaseCPU::takeOverFrom(BaseCPU *oldCPU)
     assert(threadContexts.size() == oldCPU->threadContexts.size());
 
     _cpuId = oldCPU->cpuId();
+    //ALTERCODE
+    if (FI_ON && fi_system && fi_system->switch_keeps_core()) {
+        _fiCoreId = oldCPU->fiCoreId();
+        fi_system->switch_core(_fiCoreId, this);
+    }
+    //~ALTERCODE
 
     ThreadID size = threadContexts.size();
     for (ThreadID i = 0; i < size; ++i) {
@@ -391,6 +401,13 @@ BaseCPU::takeOverFrom(BaseCPU *oldCPU)
         ThreadContext *oldTC = oldCPU->threadContexts[i];
 
         newTC->takeOverFrom(oldTC);
+        //ALTERCODE
+        newTC->setFiThread(oldTC->getFiThread());
+        if (params()->takeover_tlbs) {
+            newTC->getITBPtr()->takeOverFrom(oldTC->getITBPtr());
+            newTC->getDTBPtr()->takeOverFrom(oldTC->getDTBPtr());
+        }
+        //~ALTERCODE
 
         CpuEvent::replaceThreadContext(oldTC, newTC);
 
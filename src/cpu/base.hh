@@ -61,6 +61,9 @@
 struct BaseCPUParams;
 class BranchPred;
 class CheckerCPU;
+//ALTERCODE
+class LockstepLanes;
+//~ALTERCODE
 class ThreadContext;
 class System;
 
@@ -98,6 +101,11 @@ class BaseCPU : public MemObject
     // therefore no setCpuId() method is provided
     int _cpuId;
 
+    //ALTERCODE
+    // dense id given to the core by the fault injection system at startup
+    int _fiCoreId;
+    //~ALTERCODE
+
     /** instruction side request id that must be placed in all requests */
     MasterID _instMasterId;
 
@@ -157,6 +165,18 @@ class BaseCPU : public MemObject
     /** Reads this CPU's ID. */
     int cpuId() { return _cpuId; }
 
+    //ALTERCODE
+    /** Reads the id of this core in the fault injection counters. */
+    int fiCoreId() const { return _fiCoreId; }
+    void setFiCoreId(int v) { _fiCoreId = v; }
+    /**
+     * True if the cpu services the PC events of an instruction before
+     * its fault injection hooks, so the Addr timed faults can wait for
+     * their PC event instead of being looked up on every instruction.
+     */
+    virtual bool fiServicesPcEvents() const { return false; }
+    //~ALTERCODE
+
     /** Reads this CPU's unique data requestor ID */
     MasterID dataMasterId() { return _dataMasterId; }
     /** Reads this CPU's unique instruction requestor ID */
@@ -306,6 +326,23 @@ class BaseCPU : public MemObject
     /// sampling.
     virtual void takeOverFrom(BaseCPU *);
 
+    //ALTERCODE
+    /**
+     * Trains the branch predictor of this cpu with a branch another cpu
+     * has executed, so it is warm when it takes over. Cpus without a
+     * predictor ignore it.
+     * @param branch The pc of the branch, its npc is the next pc.
+     * @param taken Whether the branch left the sequential path.
+     */
+    virtual void warmBranch(ThreadID tid, const StaticInstPtr &inst,
+                            const TheISA::PCState &branch, bool taken)
+    {}
+
+    /** Lockstep lanes the cpu carries register faults in, NULL if the
+     * cpu model has none. */
+    virtual LockstepLanes *getLanes() { return NULL; }
+    //~ALTERCODE
+
     /**
      *  Number of threads we're actually simulating (<= SMT_MAX_THREADS).
      * This is a constant for the duration of the simulation.
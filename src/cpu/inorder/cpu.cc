@@ -73,6 +73,9 @@
 #include "sim/process.hh"
 #include "sim/stat_control.hh"
 #include "sim/system.hh"
+//ALTERCODE
+#include "fi/fi_system.hh"
+//~ALTERCODE
 
 #if THE_ISA == ALPHA_ISA
 #include "arch/alpha/osfpal.hh"
@@ -730,6 +733,12 @@ InOrderCPU::tick()
 
     ++numCycles;
 
+    //ALTERCODE
+    for (list<ThreadID>::iterator t = activeThreads.begin();
+         t != activeThreads.end(); ++t)
+        FiHooks::increaseTicks(tcBase(*t), fiCoreId(), ticks(1));
+    //~ALTERCODE
+
     checkForInterrupts();
 
     bool pipes_idle = true;
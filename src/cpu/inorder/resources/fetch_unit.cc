@@ -47,6 +47,9 @@
 #include "debug/RefCount.hh"
 #include "debug/ThreadModel.hh"
 #include "mem/request.hh"
+//ALTERCODE
+#include "fi/fi_system.hh"
+//~ALTERCODE
 
 using namespace std;
 using namespace TheISA;
@@ -109,10 +112,20 @@ FetchUnit::createMachInst(std::list<FetchBlock*>::iterator fetch_it,
     MachInst mach_inst =
         TheISA::gtoh(fetchInsts[fetch_offset]);
 
+    //ALTERCODE
+    //register, pc and memory faults, then fetch faults
+    ThreadContext *tc = cpu->thread[tid]->getTC();
+    FiHooks::main_fault(tc);
+    mach_inst = FiHooks::fetch_fault(tc, mach_inst);
+    //~ALTERCODE
+
     decoder[tid]->setTC(cpu->thread[tid]->getTC());
     decoder[tid]->moreBytes(instPC, inst->instAddr(), mach_inst);
     assert(decoder[tid]->instReady());
-    inst->setStaticInst(decoder[tid]->decode(instPC));
+    //ALTERCODE
+    //decode faults
+    inst->setStaticInst(FiHooks::decode_fault(tc, decoder[tid]->decode(instPC)));
+    //~ALTERCODE
     inst->pcState(instPC);
 }
 
@@ -102,6 +102,19 @@ class BPredUnit
      */
     bool predict(DynInstPtr &inst, TheISA::PCState &pc, ThreadID tid);
 
+    //ALTERCODE
+    /**
+     * Trains the predictor, BTB and RAS with a branch whose outcome is
+     * already known, as if it had been predicted and committed. Used to
+     * warm the unit while another CPU executes.
+     * @param inst The branch instruction.
+     * @param branch The branch's PC, its next PC is the actual target.
+     * @param taken Whether the branch was taken or not.
+     */
+    void warm(ThreadID tid, const StaticInstPtr &inst,
+              const TheISA::PCState &branch, bool taken);
+    //~ALTERCODE
+
     // @todo: Rename this function.
     void BPUncond(void * &bp_history);
 
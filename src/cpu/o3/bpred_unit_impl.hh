@@ -437,6 +437,39 @@ BPredUnit<Impl>::BPUncond(void * &bp_history)
     }
 }
 
+//ALTERCODE
+template <class Impl>
+void
+BPredUnit<Impl>::warm(ThreadID tid, const StaticInstPtr &inst,
+                      const TheISA::PCState &branch, bool taken)
+{
+    Addr pc = branch.instAddr();
+    void *bp_history = NULL;
+
+    // A misprediction is repaired the way a squash does, a correct
+    // prediction is committed.
+    if (inst->isUncondCtrl()) {
+        BPUncond(bp_history);
+        BPUpdate(pc, true, bp_history, false);
+    } else {
+        bool pred_taken = BPLookup(pc, bp_history);
+        BPUpdate(pc, taken, bp_history, pred_taken != taken);
+    }
+
+    if (!taken)
+        return;
+    if (inst->isReturn()) {
+        RAS[tid].pop();
+    } else {
+        if (inst->isCall())
+            RAS[tid].pushCall(branch);
+        TheISA::PCState target = branch;
+        target.advance();
+        BTB.update(pc, target, tid);
+    }
+}
+//~ALTERCODE
+
 template <class Impl>
 void
 BPredUnit<Impl>::BPSquash(void *bp_history)
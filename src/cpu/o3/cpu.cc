@@ -63,6 +63,9 @@
 #include "sim/process.hh"
 #include "sim/stat_control.hh"
 #include "sim/system.hh"
+//ALTERCODE
+#include "fi/fi_system.hh"
+//~ALTERCODE
 
 #if THE_ISA == ALPHA_ISA
 #include "arch/alpha/osfpal.hh"
@@ -600,6 +603,13 @@ FullO3CPU<Impl>::tick()
 
     commit.tick();
 
+    //ALTERCODE
+    //faults in the structures of the core, between two cycles
+    for (list<ThreadID>::iterator t = activeThreads.begin();
+         t != activeThreads.end(); ++t)
+        FiHooks::struct_fault(tcBase(*t));
+    //~ALTERCODE
+
     if (!FullSystem)
         doContextSwitch();
 
@@ -1728,5 +1738,96 @@ FullO3CPU<Impl>::updateThreadPriority()
     }
 }
 
+//ALTERCODE
+// applies the value model of the fault to a value of the width of T
+template <class T>
+static void
+fiManifestBytes(char *data, InjectedFault *f)
+{
+    T v;
+    memcpy(&v, data, sizeof(v));
+    v = f->manifest(v);
+    memcpy(data, &v, sizeof(v));
+}
+
+template <class Impl>
+bool
+FullO3CPU<Impl>::fiCorrupt(FiStructure s, ThreadID tid, unsigned entry,
+                           int field, InjectedFault *f)
+{
+    switch (s) {
+      case FiIntPhysReg:
+        // a register on the free list holds nothing that is read again
+        if (entry >= regFile.numPhysicalIntRegs || freeList.isFree(entry))
+            return false;
+        if (f)
+            regFile.intRegFile[entry] = f->manifest(regFile.intRegFile[entry]);
+        return true;
+
+      case FiFloatPhysReg:
+        if (entry >= regFile.numPhysicalFloatRegs ||
+            freeList.isFree(regFile.numPhysicalIntRegs + entry))
+            return false;
+        if (f)
+            regFile.floatRegFile[entry].q =
+                f->manifest(regFile.floatRegFile[entry].q);
+        return true;
+
+      case FiROB: {
+        // the pc the entry commits, traps and redirects with
+        DynInstPtr inst = rob.fiEntry(tid, entry);
+        if (!inst)
+            return false;
+        if (f) {
+            TheISA::PCState pc = inst->pcState();
+            pc.pc(f->manifest(pc.pc()));
+            inst->pcState(pc);
+        }
+        return true;
+      }
+
+      case FiIQ: {
+        // the tag of a source operand, it stays within its register file
+        DynInstPtr inst = iew.instQueue.fiEntry(tid, entry);
+        if (!inst || field < 0 || field >= inst->numSrcRegs())
+            return false;
+        PhysRegIndex tag = inst->renamedSrcRegIdx(field);
+        PhysRegIndex base = 0;
+        unsigned size = regFile.numPhysicalIntRegs;
+        if (tag >= regFile.numPhysicalIntRegs) {
+            base = regFile.numPhysicalIntRegs;
+            size = regFile.numPhysicalFloatRegs;
+        }
+        if (tag >= base + size)
+            return false;
+        if (f)
+            inst->renameSrcReg(field,
+                base + f->manifest((uint16_t)(tag - base)) % size);
+        return true;
+      }
+
+      case FiLSQ: {
+        unsigned size;
+        char *data = iew.ldstQueue.fiStoreData(tid, entry, size);
+        if (!data)
+            return false;
+        if (f) {
+            switch (size) {
+              case 1: fiManifestBytes<uint8_t>(data, f); break;
+              case 2: fiManifestBytes<uint16_t>(data, f); break;
+              case 4: fiManifestBytes<uint32_t>(data, f); break;
+              case 8: fiManifestBytes<uint64_t>(data, f); break;
+              default: fiManifestBytes<uint8_t>(data, f); break;
+            }
+        }
+        return true;
+      }
+
+      default:
+        return false;
+    }
+}
+//~ALTERCODE
+
 // Forward declaration of FullO3CPU.
 template class FullO3CPU<O3CPUImpl>;
@@ -76,6 +76,9 @@ class O3ThreadContext;
 class Checkpoint;
 class MemObject;
 class Process;
+//ALTERCODE
+class InjectedFault;
+//~ALTERCODE
 
 struct BaseCPUParams;
 
@@ -86,6 +89,28 @@ class BaseO3CPU : public BaseCPU
     BaseO3CPU(BaseCPUParams *params);
 
     void regStats();
+
+    //ALTERCODE
+    /** Structures of the core the fault injection system corrupts in place. */
+    enum FiStructure {
+        FiIntPhysReg,
+        FiFloatPhysReg,
+        FiROB,
+        FiIQ,
+        FiLSQ,
+        NumFiStructures
+    };
+
+    /**
+     * Applies the fault f to an entry of a structure (of thread tid for
+     * the queues), field is the source operand of an IQ entry. Returns
+     * false and leaves the entry alone if it holds nothing live this
+     * cycle; with f NULL only tells whether it does.
+     */
+    virtual bool fiCorrupt(FiStructure s, ThreadID tid, unsigned entry,
+                           int field, InjectedFault *f)
+    { return false; }
+    //~ALTERCODE
 };
 
 /**
@@ -444,6 +469,15 @@ class FullO3CPU : public BaseO3CPU
     /** Takes over from another CPU. */
     virtual void takeOverFrom(BaseCPU *oldCPU);
 
+    //ALTERCODE
+    virtual void warmBranch(ThreadID tid, const StaticInstPtr &inst,
+                            const TheISA::PCState &branch, bool taken)
+    { fetch.warmBranch(tid, inst, branch, taken); }
+
+    virtual bool fiCorrupt(FiStructure s, ThreadID tid, unsigned entry,
+                           int field, InjectedFault *f);
+    //~ALTERCODE
+
     /** Get the current instruction sequence number, and increment it. */
     InstSeqNum getAndIncrementInstSeq()
     { return globalSeqNum++; }
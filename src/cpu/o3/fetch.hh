@@ -238,6 +238,13 @@ class DefaultFetch
     /** Takes over from another CPU's thread. */
     void takeOverFrom();
 
+    //ALTERCODE
+    /** Trains the branch predictor with a branch of another CPU. */
+    void warmBranch(ThreadID tid, const StaticInstPtr &inst,
+                    const TheISA::PCState &branch, bool taken)
+    { branchPred.warm(tid, inst, branch, taken); }
+    //~ALTERCODE
+
     /** Checks if the fetch stage is switched out. */
     bool isSwitchedOut() { return switchedOut; }
 
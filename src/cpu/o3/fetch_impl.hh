@@ -1109,10 +1109,6 @@ DefaultFetch<Impl>::fetch(bool &status_change)
     
     ThreadID tid = getFetchingThread(fetchPolicy);
     
-    //ALTERCODE
-    Addr _tmpAddr;
-    //~ALTERCODE
-
     if (tid == InvalidThreadID || drainPending) {
         // Breaks looping condition in tick()
         threadFetched = numFetchingThreads;
@@ -1188,11 +1184,7 @@ DefaultFetch<Impl>::fetch(bool &status_change)
     ++fetchCycles;
     
      //ALTERCODE
-    if(FullSystem && (TheISA::inUserMode(cpu->getContext(tid)))){
-      _tmpAddr = cpu->getContext(tid)->readMiscReg(AlphaISA::IPR_PALtemp23);
-       if((fi_system->fi_activation.find(_tmpAddr) != fi_system->fi_activation.end()) && (fi_system->fi_activation.find(_tmpAddr)->second != -1))
-	 fi_system->increaseTicks(cpu->name(),fi_system->threadList[fi_system->fi_activation[_tmpAddr]],cpu->ticks(1));
-    }
+    FiHooks::increaseTicks(cpu->getContext(tid),cpu->fiCoreId(),cpu->ticks(1));
     //~ALTERCODE
 
     TheISA::PCState nextPC = thisPC;
@@ -1224,7 +1216,7 @@ DefaultFetch<Impl>::fetch(bool &status_change)
       
       //ALTERCODE
       //inject faults to PC address Memory and Registers
-	fi_system->main_fault(cpu->getContext(tid));
+	FiHooks::main_fault(cpu->getContext(tid));
       //~ALTERCODE
       
 	// We need to process more memory if we aren't going to get a
@@ -1261,7 +1253,7 @@ DefaultFetch<Impl>::fetch(bool &status_change)
 	
 	    //ALTERCODE
 	    //inject faults on fetch stage (opcode--whole instruction)
-	    inst = fi_system -> fetch_fault(cpu->getContext(tid),inst);
+	    inst = FiHooks::fetch_fault(cpu->getContext(tid),inst);
 	    //~ALTERCODE
 	    
             decoder[tid]->setTC(cpu->thread[tid]->getTC());
@@ -1313,7 +1305,7 @@ DefaultFetch<Impl>::fetch(bool &status_change)
             
             //ALTERCODE
 	    //inject fault on decoded instruction
-	    staticInst = fi_system -> decode_fault(cpu->getContext(tid),staticInst);
+	    staticInst = FiHooks::decode_fault(cpu->getContext(tid),staticInst);
 	    //~ALTERCODE
             
             
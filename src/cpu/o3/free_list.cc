@@ -70,3 +70,16 @@ SimpleFreeList::name() const
 {
     return "cpu.freelist";
 }
+
+//ALTERCODE
+bool
+SimpleFreeList::isFree(PhysRegIndex reg) const
+{
+    std::queue<PhysRegIndex> regs =
+        reg < numPhysicalIntRegs ? freeIntRegs : freeFloatRegs;
+    for (; !regs.empty(); regs.pop())
+        if (regs.front() == reg)
+            return true;
+    return false;
+}
+//~ALTERCODE
@@ -125,6 +125,11 @@ class SimpleFreeList
     /** Returns the number of free fp registers. */
     int numFreeFloatRegs()
     { return freeFloatRegs.size(); }
+
+    //ALTERCODE
+    /** True if the register is free, a linear walk of the list. */
+    bool isFree(PhysRegIndex reg) const;
+    //~ALTERCODE
 };
 
 inline PhysRegIndex
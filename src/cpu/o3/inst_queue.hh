@@ -457,6 +457,12 @@ class InstructionQueue
      */
     int countInsts();
 
+    //ALTERCODE
+    /** The idx-th oldest instruction of the thread waiting to issue, NULL
+     *  if there are not as many (for the fault injection system). */
+    DynInstPtr fiEntry(ThreadID tid, unsigned idx);
+    //~ALTERCODE
+
     /** Debugging function to dump all the list sizes, as well as print
      *  out the list of nonspeculative instructions.  Should not be used
      *  in any other capacity, but it has no harmful sideaffects.
@@ -942,6 +942,19 @@ InstructionQueue<Impl>::commit(const InstSeqNum &inst, ThreadID tid)
     assert(freeEntries == (numEntries - countInsts()));
 }
 
+//ALTERCODE
+template <class Impl>
+typename Impl::DynInstPtr
+InstructionQueue<Impl>::fiEntry(ThreadID tid, unsigned idx)
+{
+    // the list keeps the instructions until they commit
+    for (ListIt it = instList[tid].begin(); it != instList[tid].end(); ++it)
+        if (!(*it)->isIssued() && !(*it)->isSquashed() && idx-- == 0)
+            return *it;
+    return NULL;
+}
+//~ALTERCODE
+
 template <class Impl>
 int
 InstructionQueue<Impl>::wakeDependents(DynInstPtr &completed_inst)
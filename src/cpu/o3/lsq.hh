@@ -247,6 +247,12 @@ class LSQ {
     bool hasStoresToWB(ThreadID tid)
     { return thread[tid].hasStoresToWB(); }
 
+    //ALTERCODE
+    /** Store data of a thread for the fault injection system. */
+    char *fiStoreData(ThreadID tid, unsigned idx, unsigned &size)
+    { return thread[tid].fiStoreData(idx, size); }
+    //~ALTERCODE
+
     /** Returns the number of stores a specific thread has to write back. */
     int numStoresToWB(ThreadID tid)
     { return thread[tid].numStoresToWB(); }
@@ -213,6 +213,13 @@ class LSQUnit {
     /** Returns the number of instructions in the LSQ. */
     unsigned getCount() { return loads + stores; }
 
+    //ALTERCODE
+    /** Data of the idx-th oldest store that has it and has not sent it
+     *  to memory yet, and its size; NULL if there are not as many (for
+     *  the fault injection system). */
+    char *fiStoreData(unsigned idx, unsigned &size);
+    //~ALTERCODE
+
     /** Returns if there are any stores to writeback. */
     bool hasStoresToWB() { return storesToWB; }
 
@@ -394,6 +394,24 @@ LSQUnit<Impl>::insertStore(DynInstPtr &store_inst)
     ++stores;
 }
 
+//ALTERCODE
+template <class Impl>
+char *
+LSQUnit<Impl>::fiStoreData(unsigned idx, unsigned &size)
+{
+    for (int i = storeHead; i != storeTail; incrStIdx(i)) {
+        SQEntry &e = storeQueue[i];
+        if (!e.inst || !e.size || e.committed || e.inst->isSquashed())
+            continue;
+        if (idx-- == 0) {
+            size = e.size;
+            return e.data;
+        }
+    }
+    return NULL;
+}
+//~ALTERCODE
+
 template <class Impl>
 typename Impl::DynInstPtr
 LSQUnit<Impl>::getMemDepViolator()
@@ -260,6 +260,12 @@ class ROB
      */
     int countInsts(ThreadID tid);
 
+    //ALTERCODE
+    /** The idx-th oldest instruction of the thread that is not squashed,
+     *  NULL if there are not as many (for the fault injection system). */
+    DynInstPtr fiEntry(ThreadID tid, unsigned idx);
+    //~ALTERCODE
+
     /** Registers statistics. */
     void regStats();
 
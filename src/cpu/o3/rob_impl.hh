@@ -199,6 +199,18 @@ ROB<Impl>::countInsts(ThreadID tid)
     return instList[tid].size();
 }
 
+//ALTERCODE
+template <class Impl>
+typename Impl::DynInstPtr
+ROB<Impl>::fiEntry(ThreadID tid, unsigned idx)
+{
+    for (InstIt it = instList[tid].begin(); it != instList[tid].end(); ++it)
+        if (!(*it)->isSquashed() && idx-- == 0)
+            return *it;
+    return NULL;
+}
+//~ALTERCODE
+
 template <class Impl>
 void
 ROB<Impl>::insertInst(DynInstPtr &inst)
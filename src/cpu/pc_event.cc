@@ -76,8 +76,12 @@ PCEventQueue::remove(PCEvent *event)
 bool
 PCEventQueue::schedule(PCEvent *event)
 {
-    pc_map.push_back(event);
-    sort(pc_map.begin(), pc_map.end(), MapCompare());
+    //ALTERCODE
+    // the fault injection system sets an event per Addr timed fault,
+    // keep the map sorted without sorting it all again every time
+    pc_map.insert(upper_bound(pc_map.begin(), pc_map.end(), event->pc(),
+                              MapCompare()), event);
+    //~ALTERCODE
 
     DPRINTF(PCEvent, "PC based event scheduled for %#x: %s\n",
             event->pc(), event->descr());
@@ -59,6 +59,16 @@ ReturnAddrStack::push(const TheISA::PCState &return_addr)
     }
 }
 
+//ALTERCODE
+void
+ReturnAddrStack::pushCall(const TheISA::PCState &call)
+{
+    TheISA::PCState return_addr = call;
+    return_addr.npc(call.pc() + sizeof(TheISA::MachInst));
+    push(return_addr);
+}
+//~ALTERCODE
+
 void
 ReturnAddrStack::pop()
 {
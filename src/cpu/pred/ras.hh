@@ -64,6 +64,13 @@ class ReturnAddrStack
     /** Pushes an address onto the RAS. */
     void push(const TheISA::PCState &return_addr);
 
+    //ALTERCODE
+    /** Pushes a call that has already executed, whose npc is the call
+     *  target; the entry keeps the fall through the way fetch pushes it.
+     */
+    void pushCall(const TheISA::PCState &call);
+    //~ALTERCODE
+
     /** Pops the top address from the RAS. */
     void pop();
 
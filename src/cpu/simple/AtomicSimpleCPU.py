@@ -47,3 +47,5 @@ class AtomicSimpleCPU(BaseSimpleCPU):
     simulate_data_stalls = Param.Bool(False, "Simulate dcache stall cycles")
     simulate_inst_stalls = Param.Bool(False, "Simulate icache stall cycles")
     fastmem = Param.Bool(False, "Access memory directly")
+    warm_cpu = Param.BaseCPU(NULL,
+        "cpu whose branch predictor is trained with the executed branches")
@@ -44,6 +44,7 @@
 #include "arch/mmapped_ipr.hh"
 #include "arch/utility.hh"
 #include "base/bigint.hh"
+#include "base/time.hh"
 #include "config/the_isa.hh"
 #include "cpu/simple/atomic.hh"
 #include "cpu/exetrace.hh"
@@ -64,6 +65,7 @@
 #include "fi/o3cpu_injfault.hh"
 #include "fi/cpu_injfault.hh"
 #include "fi/cpu_threadInfo.hh"
+#include "fi/lockstep.hh"
 //~ALTERCODE
 
 using namespace std;
@@ -116,10 +118,59 @@ AtomicSimpleCPU::AtomicSimpleCPU(AtomicSimpleCPUParams *p)
       simulate_inst_stalls(p->simulate_inst_stalls),
       icachePort(name() + "-iport", this), dcachePort(name() + "-iport", this),
       fastmem(p->fastmem)
+      //ALTERCODE
+      , warmCPU(p->warm_cpu), warmCount(0), lanes(this, thread)
+      //~ALTERCODE
 {
     _status = Idle;
 }
 
+//ALTERCODE
+void
+AtomicSimpleCPU::regStats()
+{
+    BaseSimpleCPU::regStats();
+
+    warmedBranches
+        .name(name() + ".warmedBranches")
+        .desc("Number of branches the warm cpu predictor was trained with")
+        ;
+
+    warmSeconds
+        .name(name() + ".warmSeconds")
+        .desc("Estimated host seconds spent warming the warm cpu")
+        ;
+
+    warmNsPerInst
+        .name(name() + ".warmNsPerInst")
+        .desc("Host nanoseconds spent warming per instruction")
+        .precision(3)
+        ;
+    warmNsPerInst = warmSeconds * 1e9 / numInsts;
+}
+
+// Trains the predictor of warmCPU with the branch just executed. Its npc
+// is the pc advancePC is about to move to.
+void
+AtomicSimpleCPU::warmBranch()
+{
+    bool timed = warmCount++ % warmSample == 0;
+    Time start;
+    if (timed)
+        start.setTimer();
+
+    TheISA::PCState branch = thread->pcState();
+    warmCPU->warmBranch(0, curStaticInst, branch, branch.branching());
+    warmedBranches++;
+
+    if (timed) {
+        Time end;
+        end.setTimer();
+        warmSeconds += (double)(end - start) * warmSample;
+    }
+}
+//~ALTERCODE
+
 
 AtomicSimpleCPU::~AtomicSimpleCPU()
 {
@@ -170,6 +221,10 @@ void
 AtomicSimpleCPU::switchOut()
 {
     assert(_status == Running || _status == Idle);
+    //ALTERCODE
+    // the cpu taking over carries no lane
+    lanes.splitAll();
+    //~ALTERCODE
     _status = SwitchedOut;
 
     tickEvent.squash();
@@ -251,6 +306,11 @@ Fault
 AtomicSimpleCPU::readMem(Addr addr, uint8_t * data,
                          unsigned size, unsigned flags)
 {
+    //ALTERCODE
+    if (lanes.isProbing())
+        return lanes.probeRead(addr, data, size, flags);
+    //~ALTERCODE
+
     // use the CPU's statically allocated read request and packet objects
     Request *req = &data_read_req;
 
@@ -339,6 +399,11 @@ Fault
 AtomicSimpleCPU::writeMem(uint8_t *data, unsigned size,
                           Addr addr, unsigned flags, uint64_t *res)
 {
+    //ALTERCODE
+    if (lanes.isProbing())
+        return lanes.probeWrite(data, size, addr, flags, res);
+    //~ALTERCODE
+
     // use the CPU's statically allocated write request and packet objects
     Request *req = &data_write_req;
 
@@ -442,10 +507,6 @@ void
 AtomicSimpleCPU::tick()
 {
   
-    //ALTERCODE  
-    Addr _tmpAddr;
-    //~ALTERCODE
-    
     DPRINTF(SimpleCPU, "Tick\n");
 
     Tick latency = 0;
@@ -457,6 +518,11 @@ AtomicSimpleCPU::tick()
         if (!curStaticInst || !curStaticInst->isDelayedCommit())
             checkForInterrupts();
 
+        //ALTERCODE
+        if (!lanes.empty())
+            lanes.pcEvent(thread->instAddr());
+        FiHooks::profile_pc(thread->getTC(), thread->instAddr());
+        //~ALTERCODE
         checkPcEventQueue();
         // We must have just got suspended by a PC event
         if (_status == Idle)
@@ -466,7 +532,7 @@ AtomicSimpleCPU::tick()
 	
 	//ALTERCODE
 	//register faults
-	fi_system->main_fault(thread->getTC());
+	FiHooks::main_fault(thread->getTC());
 	//~ALTERCODE
 	
 
@@ -511,20 +577,29 @@ AtomicSimpleCPU::tick()
             
             //ALTERCODE
 	    //fetch faults
-	    inst = fi_system->fetch_fault(thread->getTC(),inst);
+	    inst = FiHooks::fetch_fault(thread->getTC(),inst);
 	    //~ALTERCODE
             preExecute();
 
 	    
 	    //ALTERCODE
 	    //decode faults
-	    curStaticInst = fi_system ->decode_fault(thread->getTC(),curStaticInst);
+	    curStaticInst = FiHooks::decode_fault(thread->getTC(),curStaticInst);
 	    //ALTERCODE
 	    
 	     //~ALTERCODE
 	    
             if (curStaticInst) {
+                //ALTERCODE
+                if (!lanes.empty())
+                    lanes.before(curStaticInst);
+                //~ALTERCODE
                 fault = curStaticInst->execute(this, traceData);
+                //ALTERCODE
+                if (!lanes.empty())
+                    lanes.after(fault);
+                FiHooks::profile_regs(thread->getTC(), curStaticInst, fault);
+                //~ALTERCODE
 
                 // keep an instruction count
                 if (fault == NoFault)
@@ -535,6 +610,11 @@ AtomicSimpleCPU::tick()
                 }
 
                 postExecute();
+
+                //ALTERCODE
+                if (warmCPU && fault == NoFault && curStaticInst->isControl())
+                    warmBranch();
+                //~ALTERCODE
             }
             // @todo remove me after debugging with legion done
             if (curStaticInst && (!curStaticInst->isMicroop() ||
@@ -568,11 +648,7 @@ AtomicSimpleCPU::tick()
         latency = ticks(1);
     
     //ALTERCODE
-    if(FullSystem && (TheISA::inUserMode(thread->getTC()))){
-	_tmpAddr = thread->getTC()->readMiscRegNoEffect(AlphaISA::IPR_PALtemp23);
-	if((fi_system->fi_activation.find(_tmpAddr) != fi_system->fi_activation.end()) && (fi_system->fi_activation.find(_tmpAddr)->second != -1))
-	  fi_system->increaseTicks(name(),fi_system->threadList[fi_system->fi_activation[_tmpAddr]],latency);
-    }
+    FiHooks::increaseTicks(thread->getTC(),fiCoreId(),latency);
     //ALTERCODE
     
     if (_status != Idle)
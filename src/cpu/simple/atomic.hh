@@ -44,6 +44,9 @@
 #define __CPU_SIMPLE_ATOMIC_HH__
 
 #include "cpu/simple/base.hh"
+//ALTERCODE
+#include "fi/lockstep.hh"
+//~ALTERCODE
 #include "params/AtomicSimpleCPU.hh"
 
 class AtomicSimpleCPU : public BaseSimpleCPU
@@ -54,6 +57,9 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     virtual ~AtomicSimpleCPU();
 
     virtual void init();
+    //ALTERCODE
+    virtual void regStats();
+    //~ALTERCODE
 
   private:
 
@@ -110,6 +116,24 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     bool dcache_access;
     Tick dcache_latency;
 
+    //ALTERCODE
+    /** Cpu trained with the branches executed here, NULL if none. */
+    BaseCPU *warmCPU;
+    /** Warmed branches, one in warmSample of them is timed. */
+    uint64_t warmCount;
+    static const uint64_t warmSample = 64;
+
+    void warmBranch();
+
+    Stats::Scalar warmedBranches;
+    /** Estimated host seconds spent warming. */
+    Stats::Scalar warmSeconds;
+    Stats::Formula warmNsPerInst;
+
+    /** Register faults carried along the golden thread. */
+    LockstepLanes lanes;
+    //~ALTERCODE
+
   protected:
 
     /** Return a reference to the data port. */
@@ -127,6 +151,11 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     void switchOut();
     void takeOverFrom(BaseCPU *oldCPU);
 
+    //ALTERCODE
+    LockstepLanes *getLanes() { return &lanes; }
+    virtual bool fiServicesPcEvents() const { return true; }
+    //~ALTERCODE
+
     virtual void activateContext(ThreadID thread_num, int delay);
     virtual void suspendContext(ThreadID thread_num);
 
@@ -56,6 +56,9 @@
 #include "sim/faults.hh"
 #include "sim/full_system.hh"
 #include "sim/system.hh"
+//ALTERCODE
+#include "fi/fi_system.hh"
+//~ALTERCODE
 
 using namespace std;
 using namespace TheISA;
@@ -93,6 +96,9 @@ TimingSimpleCPU::TimingSimpleCPU(TimingSimpleCPUParams *p)
     ifetch_pkt = dcache_pkt = NULL;
     drainEvent = NULL;
     previousTick = 0;
+    //ALTERCODE
+    fiTick = 0;
+    //~ALTERCODE
     changeState(SimObject::Running);
     system->totalNumInsts = 0;
 }
@@ -183,6 +189,9 @@ TimingSimpleCPU::takeOverFrom(BaseCPU *oldCPU)
     }
     assert(threadContexts.size() == 1);
     previousTick = curTick();
+    //ALTERCODE
+    fiTick = curTick();
+    //~ALTERCODE
 }
 
 
@@ -198,6 +207,10 @@ TimingSimpleCPU::activateContext(ThreadID thread_num, int delay)
 
     notIdleFraction++;
     _status = Running;
+    //ALTERCODE
+    // the ticks spent suspended are not charged to the fault threads
+    fiTick = curTick();
+    //~ALTERCODE
 
     // kick things off by initiating the fetch of the next instruction
     schedule(fetchEvent, nextCycle(curTick() + ticks(delay)));
@@ -550,6 +563,11 @@ TimingSimpleCPU::fetch()
     if (_status == Idle)
         return;
 
+    //ALTERCODE
+    //register, pc and memory faults, after the PC events of the instruction
+    FiHooks::main_fault(thread->getTC());
+    //~ALTERCODE
+
     TheISA::PCState pcState = thread->pcState();
     bool needToFetch = !isRomMicroPC(pcState.microPC()) && !curMacroStaticInst;
 
@@ -658,7 +676,17 @@ TimingSimpleCPU::completeIfetch(PacketPtr pkt)
         return;
     }
 
+    //ALTERCODE
+    FiHooks::increaseTicks(thread->getTC(), fiCoreId(), curTick() - fiTick);
+    fiTick = curTick();
+    //fetch faults
+    inst = FiHooks::fetch_fault(thread->getTC(), inst);
+    //~ALTERCODE
     preExecute();
+    //ALTERCODE
+    //decode faults
+    curStaticInst = FiHooks::decode_fault(thread->getTC(), curStaticInst);
+    //~ALTERCODE
     if (curStaticInst && curStaticInst->isMemRef()) {
         // load or store: just send to dcache
         Fault fault = curStaticInst->initiateAcc(this, traceData);
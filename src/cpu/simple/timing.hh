@@ -235,6 +235,11 @@ class TimingSimpleCPU : public BaseSimpleCPU
 
     Tick previousTick;
 
+    //ALTERCODE
+    /** Last tick charged to the fault injection threads. */
+    Tick fiTick;
+    //~ALTERCODE
+
   protected:
 
      /** Return a reference to the data port. */
@@ -254,6 +259,10 @@ class TimingSimpleCPU : public BaseSimpleCPU
     void switchOut();
     void takeOverFrom(BaseCPU *oldCPU);
 
+    //ALTERCODE
+    virtual bool fiServicesPcEvents() const { return true; }
+    //~ALTERCODE
+
     virtual void activateContext(ThreadID thread_num, int delay);
     virtual void suspendContext(ThreadID thread_num);
 
@@ -292,6 +292,15 @@ class SimpleThread : public ThreadState
                 reg_idx, flatIndex, val, floatRegs.f[flatIndex]);
     }
 
+    //ALTERCODE
+    /** Access the registers by flattened index, as the lockstep lanes
+     * of the fault injection keep them. */
+    uint64_t readIntRegFlat(int idx) { return intRegs[idx]; }
+    void setIntRegFlat(int idx, uint64_t val) { intRegs[idx] = val; }
+    FloatRegBits readFloatRegBitsFlat(int idx) { return floatRegs.i[idx]; }
+    void setFloatRegBitsFlat(int idx, FloatRegBits val) { floatRegs.i[idx] = val; }
+    //~ALTERCODE
+
     TheISA::PCState
     pcState()
     {
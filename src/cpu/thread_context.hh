@@ -67,6 +67,9 @@ class FSTranslatingPortProxy;
 class PortProxy;
 class Process;
 class System;
+//ALTERCODE
+class ThreadEnabledFault;
+//~ALTERCODE
 namespace TheISA {
     namespace Kernel {
         class Statistics;
@@ -115,6 +118,23 @@ class ThreadContext
         Halted
     };
 
+    //ALTERCODE
+  protected:
+    /**
+     * Fault injection state of the software thread running on this
+     * context, NULL if it has not activated fault injection. Refreshed
+     * by Fi_System whenever the PCB register is written, so the fault
+     * hooks only test this pointer.
+     */
+    ThreadEnabledFault *fiThread;
+
+  public:
+    ThreadContext() : fiThread(NULL) { }
+
+    ThreadEnabledFault *getFiThread() const { return fiThread; }
+    void setFiThread(ThreadEnabledFault *v) { fiThread = v; }
+    //~ALTERCODE
+
     virtual ~ThreadContext() { };
 
     virtual BaseCPU *getCpuPtr() = 0;
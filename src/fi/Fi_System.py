@@ -5,5 +5,33 @@ class Fi_System(MemObject):
   type='Fi_System'
   input_fi=Param.String("","Input File Name")
   check_before_init=Param.Bool(False, "create CheckPoint before initialize of fault injection system")
+  inst_window=Param.UInt64(10000000, "faults of a binary fault list are created this many instructions before they are due")
+  tick_window=Param.UInt64(10000000000, "faults of a binary fault list are created this many ticks before they are due")
+  campaign=Param.Bool(False, "run the golden execution once and fork a child that applies each fault")
+  max_children=Param.Int(1, "maximum number of campaign experiments running at the same time, across the golden run and its snapshots")
+  campaign_results=Param.String("fi_campaign.txt", "file in the output directory the campaign children append their outcome to")
   
   
+  digest_interval=Param.UInt64(0, "hash the architectural state every this many instruction events, 0 disables the digests")
+  golden_digests=Param.String("", "digests of the golden run to compare with (written in the output directory when recording)")
+  record_digests=Param.Bool(False, "record the digests of this run as the golden ones")
+  snapshot_interval=Param.UInt64(0, "take a snapshot every this many instruction events, 0 disables the snapshots")
+  max_snapshots=Param.Int(4, "snapshots a campaign keeps alive")
+  snapshot_budget=Param.MemorySize("0B", "memory the copied pages of the snapshots may take, 0 for no limit")
+  snapshot_spill=Param.Bool(False, "write the snapshots as checkpoints instead of keeping them in memory")
+  auto_switch=Param.Bool(False, "run with the atomic cpus and switch to the detailed ones only around the faults")
+  switch_warmup=Param.UInt64(1000000, "switch to the detailed cpus this many instruction events before a fault may trigger")
+  switch_warmup_ticks=Param.UInt64(500000000, "switch to the detailed cpus this many ticks before a fault may trigger")
+  lockstep_lanes=Param.Int(0, "transient register faults a campaign carries along the golden run of an atomic cpu until they diverge, 0 disables the lanes")
+  liveness_profile=Param.String("", "file in the output directory the register liveness profile of this run is written to, empty disables the profiling")
+  mem_uses=Param.String("", "only observe the faults of this run and write the next access of the byte of every memory fault to this file in the output directory")
+  mem_timeline=Param.String("", "memory access timelines of the golden run, a campaign does not fork the memory faults they show are masked")
+  record_mem_timeline=Param.Bool(False, "record the memory access timelines of this run to mem_timeline in the output directory")
+  golden_totals=Param.String("", "instruction events and ticks of every thread of the golden run (written in the output directory when recording)")
+  record_golden_totals=Param.Bool(False, "record the totals of this run as the golden ones")
+  hang_factor=Param.Float(0.0, "end a run that applied a fault as a hang once it runs this many times the golden totals, 0 disables the watchdog")
+  watch_interval=Param.UInt64(100000, "check the watchdog and start a loop detector burst every this many instruction events")
+  loop_samples=Param.Int(0, "end a run that applied a fault as a hang once this many sample bursts in a row find a thread back at the same pc with the same registers, 0 disables the loop detector")
+  loop_window=Param.Int(64, "committed instructions a sample burst of the loop detector covers, the longest loop period it catches")
+  crash_symbols=Param.VectorString(["panic", "die_if_kernel"], "guest kernel functions that end a run that applied a fault as a crash")
+  outcome=Param.String("fi_outcome.txt", "file in the output directory a run that applied faults outside a campaign writes its outcome to")
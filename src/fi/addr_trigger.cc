@@ -0,0 +1,26 @@
+#include "cpu/thread_context.hh"
+#include "fi/addr_trigger.hh"
+#include "fi/fi_system.hh"
+
+AddrTriggerEvent::AddrTriggerEvent(PCEventQueue *q, ThreadEnabledFault *t, Addr pc)
+  : PCEvent(q, "fi_addr_trigger", pc), thread(t)
+{
+}
+
+void
+AddrTriggerEvent::process(ThreadContext *tc)
+{
+  if (tc->getFiThread() == thread)
+    fi_system->addr_hit(tc);
+}
+
+bool
+AddrTriggerEvent::othersAt(PCEventQueue &q, Addr pc)
+{
+  PCEventQueue::iterator i = q.equal_range(pc).first;
+  PCEventQueue::iterator end = q.equal_range(pc).second;
+  for (; i != end; ++i)
+    if (!dynamic_cast<AddrTriggerEvent *>(*i))
+      return true;
+  return false;
+}
@@ -0,0 +1,32 @@
+#ifndef __FI_ADDR_TRIGGER_HH__
+#define __FI_ADDR_TRIGGER_HH__
+
+#include "base/types.hh"
+#include "cpu/pc_event.hh"
+
+class ThreadContext;
+class ThreadEnabledFault;
+
+/*
+ * Breakpoint of the system PC event queue where Addr timed faults are
+ * due for a thread: at their offset from the magic instruction of the
+ * thread. Only the thread it was set for is let through, every other
+ * process running the same virtual address is ignored. The cpus that
+ * service the PC events before their fault injection hooks look for
+ * Addr timed faults only once one of these went off (Fi_System::addr_hit).
+ */
+class AddrTriggerEvent : public PCEvent
+{
+  protected:
+    ThreadEnabledFault *thread;
+
+  public:
+    AddrTriggerEvent(PCEventQueue *q, ThreadEnabledFault *t, Addr pc);
+
+    virtual void process(ThreadContext *tc);
+
+    /* true if an event other than an Addr trigger is set at pc */
+    static bool othersAt(PCEventQueue &q, Addr pc);
+};
+
+#endif // __FI_ADDR_TRIGGER_HH__
@@ -6,13 +6,18 @@
 #include <fstream>
 
 using namespace std;
-CPUInjectedFault::CPUInjectedFault(  ifstream &os)
+CPUInjectedFault::CPUInjectedFault(  std::istream &os)
   :InjectedFault(os){
   int t;
   os>>t;
   setTContext(t);
 }
 
+CPUInjectedFault::CPUInjectedFault(const FaultRecord &r, int whereId)
+  :InjectedFault(r, whereId){
+  setTContext(r.tcontext);
+}
+
 
 CPUInjectedFault::~CPUInjectedFault()
 {
@@ -52,12 +57,8 @@ CPUInjectedFault:: check4reschedule(){
     getQueue()->remove(this);
     return;
   }else{
-    Tick cycles = getTiming() + getCPU()->ticks(1);
-    int insts = getTiming() + 1;
-    Addr addr = getTiming() + (getCPU()->getContext(getTContext())->pcState().nextInstAddr() - getCPU()->getContext(getTContext())->pcState().instAddr());
-    increaseTiming(cycles,insts,addr);
-    decreaseOccurrence();
-    setManifested(false);
+    ThreadContext *tc = getCPU()->getContext(getTContext());
+    rearm(getCPU()->ticks(1), tc->pcState().nextInstAddr() - tc->pcState().instAddr());
   }
 
   
@@ -20,7 +20,8 @@ private:
   
 
 public:
-  CPUInjectedFault( ifstream &os); //initialize faults from the input fstream
+  CPUInjectedFault( std::istream &os); //initialize faults from the input fstream
+  CPUInjectedFault(const FaultRecord &r, int whereId);
   ~CPUInjectedFault();
 
   void setTContext(int v) { _tcontext = v;}  //set hardware thread
@@ -2,6 +2,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstdlib>
+#include <new>
 
 #include "fi/cpu_threadInfo.hh"
 #include "cpu/o3/cpu.hh"
@@ -11,19 +13,19 @@
 
 
 //Set all the counters to the correct value
-cpuExecutedTicks:: cpuExecutedTicks(std:: string name)
+cpuExecutedTicks:: cpuExecutedTicks()
 {
-  setName(name);
   setInstrFetched(0);
   setInstrDecoded(0);
   setInstrExecuted(0);
   setTicks(0);
+  setPresent(false);
 }
 
 
-void cpuExecutedTicks:: dump(){
+void cpuExecutedTicks:: dump(const std::string &name) const{
     if (DTRACE(FaultInjection)) {
-    std::cout<<"================\t"<<"CpuExecutedTicks :"<<getName()<<" \t==========================\n"; 
+    std::cout<<"================\t"<<"CpuExecutedTicks :"<<name<<" \t==========================\n"; 
     std::cout << "CpuFetchedInstr: " <<getInstrFetched() <<"\n";
     std::cout << "CpuDecodedInstr: " <<getInstrExecuted() <<  "\n";
     std::cout << "CpuExecutedInstr: "<<getInstrExecuted() <<  "\n";
@@ -33,159 +35,41 @@ void cpuExecutedTicks:: dump(){
 }
 
 //a new thread has enabled fault injection get the id and set all the information
+//the cores are known to Fi_System by now, so one flat array holds all their counters
 ThreadEnabledFault::ThreadEnabledFault(int threadId)
 {
+  void *p = NULL;
+
   setThreaId(threadId);
   setMyid();
   setMagicInstVirtualAddr(-1);
-}
-
-
-
 
-
-void ThreadEnabledFault::dump(){
-
-  if (DTRACE(FaultInjection)) {
-    std::cout<<"================\t"<<"ThreadEnabledFault "<<getMyId()<<" \t==========================\n"; 
-    std::cout << "ThreadEnabledInfo  MagicInstVirtualAddr : "<<getMagicInstVirtualAddr()<<" ThreadId :"<<getThreaId() <<"\n";
-    std::cout<<"================\t~ThreadEnabledFault~\t==========================\n";
+  numCores = fi_system->get_num_cores();
+  cores = NULL;
+  if (numCores > 0) {
+    if (posix_memalign(&p, sizeof(cpuExecutedTicks), numCores * sizeof(cpuExecutedTicks)) != 0)
+      panic("ThreadEnabledFault: unable to allocate the core counters\n");
+    cores = static_cast<cpuExecutedTicks *>(p);
+    for (int i = 0; i < numCores; i++)
+      new (&cores[i]) cpuExecutedTicks();
   }
 }
 
-//This thread has executed one more cycle increase it
-
-int ThreadEnabledFault:: increaseTicks(std:: string curCpu, uint64_t ticks)
-{
- 
-  //find the core where i am being executed
-  itcores=cores.find(curCpu);
-  if(itcores == cores.end()){
-      //First time I execute on this core add it to my map
-      cores.insert(pair<string,cpuExecutedTicks*>(curCpu,new cpuExecutedTicks(curCpu)));
-  }
-  else{
-      itcores->second->increaseTicks(ticks);
-  }
-  return 1;
-}
-
-
-//This thread has fethed one more instruction.
-
-
-int ThreadEnabledFault:: increaseFetchedInstr(std:: string curCpu)
-{
-  //have I fetch instruction from this core before?
-  itcores =cores.find(curCpu);
-  if(itcores == cores.end()){
-    //no
-      cores.insert(pair<string,cpuExecutedTicks*>(curCpu,new cpuExecutedTicks(curCpu)));
-  }
-  else{
-      //yes
-      itcores->second->increaseFetchInstr();
-  }
-  return 1;
-}
-
-//This thread has decode one more instruction.
-
-int ThreadEnabledFault:: increaseDecodedInstr(std:: string curCpu)
-{
-  //have I decoded instructions from this core before?
-  itcores=cores.find(curCpu);
-  if(itcores == cores.end()){
-      cores.insert(pair<string,cpuExecutedTicks*>(curCpu,new cpuExecutedTicks(curCpu)));
-  }
-  else{
-      itcores->second->increaseDecodeInstr();
-  }
-  return 1;
-}
-
-//This thread has executed one more instruction.
-
-int ThreadEnabledFault:: increaseExecutedInstr(std:: string curCpu)
+ThreadEnabledFault::~ThreadEnabledFault()
 {
-  itcores=cores.find(curCpu);
-  //have I executed instructions from this core before?
-  if(itcores == cores.end()){
-      cores.insert(pair<string,cpuExecutedTicks*>(curCpu,new cpuExecutedTicks(curCpu)));
-  }
-  else{
-      itcores->second->increaseExecInstr();
-  }
-  return 1;
-  
+  free(cores);
 }
 
 
-//how many instruction has this thread fetched  untill now on this core or on all cores?
 
-void ThreadEnabledFault:: CalculateFetchedTime(std::string curCpu , uint64_t *fetched_instr , uint64_t *fetched_time )
-{
-
-  *fetched_time = 0;
-  *fetched_instr = 0;
-  //Do i want to find the fetched instructions for this core or for all cores?
-  if(curCpu.compare("all")==0){
-    //ALL
-    for(itcores = cores.begin(); itcores!=cores.end() ; ++itcores){
-      *fetched_time  +=  itcores->second->getTicks();
-      *fetched_instr +=  itcores->second->getInstrFetched();
-    }
-  }
-  else{
-    //SPECIFIC core
-    itcores=cores.find(curCpu);
-    if(itcores!=cores.end()){
-      *fetched_time = itcores->second->getTicks();
-      *fetched_instr = itcores->second->getInstrFetched();
-      return;
-    }
-  }
-}
 
 
-void ThreadEnabledFault:: CalculateDecodedTime(std::string curCpu , uint64_t *decoded_instr , uint64_t *decoded_time )
-{
-  
-  *decoded_time = 0;
-  *decoded_instr = 0;
-  if(curCpu.compare("all")==0){
-    for(itcores = cores.begin(); itcores!=cores.end() ; ++itcores){
-      *decoded_time  +=  itcores->second->getTicks();
-      *decoded_instr +=  itcores->second->getInstrDecoded();
-    }
-  }
-  else{
-    itcores=cores.find(curCpu);
-    if(itcores!=cores.end()){
-      *decoded_time = itcores->second->getTicks();
-      *decoded_instr = itcores->second->getInstrDecoded();
-      return;
-    }
-  }
-}
+void ThreadEnabledFault::dump(){
 
-void ThreadEnabledFault:: CalculateExecutedTime(std::string curCpu  , uint64_t *exec_instr , uint64_t *exec_time)
-{
-  *exec_time = 0;
-  *exec_instr = 0;
-  if(curCpu.compare("all")==0){
-    for(itcores = cores.begin(); itcores!=cores.end() ; ++itcores){
-      *exec_time  +=  itcores->second->getTicks();
-      *exec_instr +=  itcores->second->getInstrExecuted();
-    }
-  }
-  else{
-    itcores=cores.find(curCpu);
-    if(itcores!=cores.end()){
-      *exec_time = itcores->second->getTicks();
-      *exec_instr = itcores->second->getInstrExecuted();
-      return;
-    }
+  if (DTRACE(FaultInjection)) {
+    std::cout<<"================\t"<<"ThreadEnabledFault "<<getMyId()<<" \t==========================\n"; 
+    std::cout << "ThreadEnabledInfo  MagicInstVirtualAddr : "<<getMagicInstVirtualAddr()<<" ThreadId :"<<getThreaId() <<"\n";
+    std::cout<<"================\t~ThreadEnabledFault~\t==========================\n";
   }
 }
 
@@ -195,19 +79,79 @@ void ThreadEnabledFault:: CalculateExecutedTime(std::string curCpu  , uint64_t *
 void ThreadEnabledFault:: print_time(){
   if (DTRACE(FaultInjection)){
     std::cout<<"THREAD ID: "<<getMyId()<<"\n";
-    for(itcores = cores.begin(); itcores!=cores.end() ; ++itcores){
-      std::cout<<"CORE:"<<itcores->second->getName()<<"\n";
-      std::cout<<"Fetched Instr: "<< itcores->second->getInstrFetched() <<"\n";
-      std::cout<<"Decoded Instr: "<< itcores->second->getInstrDecoded() <<"\n";
-      std::cout<<"Executed Instr: "<< itcores->second->getInstrExecuted() <<"\n";
-      std::cout<<"Ticks : "<< itcores->second->getTicks() <<"\n";
+    for(int i = 0; i < numCores; i++){
+      if (!cores[i].isPresent())
+	continue;
+      std::cout<<"CORE:"<<fi_system->get_core_name(i)<<"\n";
+      std::cout<<"Fetched Instr: "<< cores[i].getInstrFetched() <<"\n";
+      std::cout<<"Decoded Instr: "<< cores[i].getInstrDecoded() <<"\n";
+      std::cout<<"Executed Instr: "<< cores[i].getInstrExecuted() <<"\n";
+      std::cout<<"Ticks : "<< cores[i].getTicks() <<"\n";
     }
     
   }
 }
 
 
+void
+ThreadEnabledFault::serialize(std::ostream &os)
+{
+  std::vector<std::string> core;
+  std::vector<uint64_t> fetched, decoded, executed, ticks;
+
+  core.push_back("all");
+  fetched.push_back(allCores.getInstrFetched());
+  decoded.push_back(allCores.getInstrDecoded());
+  executed.push_back(allCores.getInstrExecuted());
+  ticks.push_back(allCores.getTicks());
+  for (int i = 0; i < numCores; i++) {
+    if (!cores[i].isPresent())
+      continue;
+    core.push_back(fi_system->get_core_name(i));
+    fetched.push_back(cores[i].getInstrFetched());
+    decoded.push_back(cores[i].getInstrDecoded());
+    executed.push_back(cores[i].getInstrExecuted());
+    ticks.push_back(cores[i].getTicks());
+  }
+
+  SERIALIZE_SCALAR(threadId);
+  SERIALIZE_SCALAR(MagicInstVirtualAddr);
+  arrayParamOut(os, "core", core);
+  arrayParamOut(os, "fetched", fetched);
+  arrayParamOut(os, "decoded", decoded);
+  arrayParamOut(os, "executed", executed);
+  arrayParamOut(os, "ticks", ticks);
+}
 
-
-
-
+void
+ThreadEnabledFault::unserialize(Checkpoint *cp, const std::string &section)
+{
+  std::vector<std::string> core;
+  std::vector<uint64_t> fetched, decoded, executed, ticks;
+
+  UNSERIALIZE_SCALAR(threadId);
+  UNSERIALIZE_SCALAR(MagicInstVirtualAddr);
+  arrayParamIn(cp, section, "core", core);
+  arrayParamIn(cp, section, "fetched", fetched);
+  arrayParamIn(cp, section, "decoded", decoded);
+  arrayParamIn(cp, section, "executed", executed);
+  arrayParamIn(cp, section, "ticks", ticks);
+
+  for (size_t i = 0; i < core.size(); i++) {
+    int id = fi_system->get_core_id(core[i]);
+    cpuExecutedTicks *c;
+    if (id == AllCores)
+      c = &allCores;
+    else if (id < numCores)
+      c = &cores[id];
+    else {
+      warn("ThreadEnabledFault: counters of unknown core %s dropped\n", core[i]);
+      continue;
+    }
+    c->setInstrFetched(fetched[i]);
+    c->setInstrDecoded(decoded[i]);
+    c->setInstrExecuted(executed[i]);
+    c->setTicks(ticks[i]);
+    c->setPresent(true);
+  }
+}
@@ -3,6 +3,7 @@
 
 
 #include <map>
+#include <string>
 
 #include "config/the_isa.hh"
 #include "base/types.hh"
@@ -27,8 +28,8 @@ class InjectedFaultQueue;
 
 /*
  * class cpuExecutedTicks in reallity is a simple counter class which count how many
- * instructions/ticks has a thread executed on a specific core
- * 
+ * instructions/ticks has a thread executed on a specific core.
+ * Every instance takes a whole cache line so the counters of different cores never share one.
  */
 
 class cpuExecutedTicks {
@@ -42,29 +43,31 @@ class cpuExecutedTicks {
      * a thread owns the pipeline even if only one instruction is inside the pipeline
     */
     uint64_t _ticks; // how many ticks has a thread been executing on this core
-    
-    std::string _name; // The name of this core (e.g. system.cpu1)
+
+    /*
+     * The first event of a thread on a core only registers the core
+     * (this is how the counters always behaved), so the fault timings
+     * of existing campaigns stay the same.
+     */
+    bool _present;
   public:
     
-    cpuExecutedTicks(std:: string name);
-    ~cpuExecutedTicks();
-    
-    void setName(std:: string v){_name = v;} 
+    cpuExecutedTicks();
         
     void setInstrFetched(uint64_t v){instrFetched = v;  }
     void setInstrDecoded(uint64_t v){instrDecoded = v;  }
     void setInstrExecuted(uint64_t v){instrExexuted = v; }
     
     void setTicks(uint64_t v){_ticks=v;}
+    void setPresent(bool v){_present=v;}
     
-    uint64_t getInstrFetched(){return instrFetched;}
-    uint64_t getInstrDecoded(){return instrDecoded;}
-    uint64_t getInstrExecuted(){return instrExexuted;}
+    uint64_t getInstrFetched() const {return instrFetched;}
+    uint64_t getInstrDecoded() const {return instrDecoded;}
+    uint64_t getInstrExecuted() const {return instrExexuted;}
        
     
-    uint64_t getTicks(){return _ticks;}
-    
-    std::string getName() {return _name;}
+    uint64_t getTicks() const {return _ticks;}
+    bool isPresent() const {return _present;}
     
     
     void increaseFetchInstr() { instrFetched++;}
@@ -73,8 +76,8 @@ class cpuExecutedTicks {
     
     void increaseTicks(uint64_t ticks) {_ticks+=ticks;}
     
-    void dump();
-};
+    void dump(const std::string &name) const;
+} __attribute__((aligned(64)));
 
 /*
  * This class represents a software thread (pthread,applciation)
@@ -90,11 +93,33 @@ class ThreadEnabledFault {
     int threadId; // Given when fi_activate_inst is executed 
     int myId; // different for all threads something like hash id used only for debugging purposes.
   protected :
-    std::map<string,cpuExecutedTicks*> cores; // Store all cores which this thread as ever execute an instruction
-    std::map<string,cpuExecutedTicks*>::iterator itcores;
+    /*
+     * Counters of every core this thread may execute on, indexed by the
+     * core id given by Fi_System, and their running sum over all cores.
+     */
+    cpuExecutedTicks *cores;
+    int numCores;
+    cpuExecutedTicks allCores;
+
+    /* returns the counters of the core, registering the core on its first event
+     * (NULL if the core is not known to this thread)
+     */
+    cpuExecutedTicks *
+    touchCore(int core)
+    {
+      if (core < 0 || core >= numCores)
+	return NULL;
+      if (!cores[core].isPresent()) {
+	cores[core].setPresent(true);
+	return NULL;
+      }
+      return &cores[core];
+    }
    
   public:
 
+    //core id that stands for the sum of all cores
+    static const int AllCores = -1;
     
     ThreadEnabledFault( int threadId );
     ~ThreadEnabledFault();
@@ -118,20 +143,95 @@ class ThreadEnabledFault {
     void findThreadFaults(int ThreadsId);
     
     
-    int increaseFetchedInstr(std:: string curCpu);
-    int increaseDecodedInstr(std:: string curCpu);
-    int increaseExecutedInstr(std:: string curCpu);
-    
-    int increaseTicks(std :: string curCpu , uint64_t ticks);
+    int
+    increaseFetchedInstr(int curCpu)
+    {
+      cpuExecutedTicks *c = touchCore(curCpu);
+      if (c) {
+	c->increaseFetchInstr();
+	allCores.increaseFetchInstr();
+      }
+      return 1;
+    }
+
+    int
+    increaseDecodedInstr(int curCpu)
+    {
+      cpuExecutedTicks *c = touchCore(curCpu);
+      if (c) {
+	c->increaseDecodeInstr();
+	allCores.increaseDecodeInstr();
+      }
+      return 1;
+    }
+
+    int
+    increaseExecutedInstr(int curCpu)
+    {
+      cpuExecutedTicks *c = touchCore(curCpu);
+      if (c) {
+	c->increaseExecInstr();
+	allCores.increaseExecInstr();
+      }
+      return 1;
+    }
     
+    int
+    increaseTicks(int curCpu , uint64_t ticks)
+    {
+      cpuExecutedTicks *c = touchCore(curCpu);
+      if (c) {
+	c->increaseTicks(ticks);
+	allCores.increaseTicks(ticks);
+      }
+      return 1;
+    }
     
-    void CalculateFetchedTime(std:: string curCpu , uint64_t *fetched_instr,uint64_t *fetched_time);
-    void CalculateDecodedTime(std::string curCpu , uint64_t *fetched_instr, uint64_t *fetched_time  );
-    void CalculateExecutedTime(std:: string curCpu , uint64_t *exec_instr ,uint64_t *exec_time);
+    /* how many instructions/ticks has this thread spent on this core or on all cores (AllCores)?
+     */
+    const cpuExecutedTicks *
+    getCounters(int curCpu) const
+    {
+      if (curCpu == AllCores)
+	return &allCores;
+      if (curCpu >= numCores || !cores[curCpu].isPresent())
+	return NULL;
+      return &cores[curCpu];
+    }
+
+    void
+    CalculateFetchedTime(int curCpu , uint64_t *fetched_instr,uint64_t *fetched_time)
+    {
+      const cpuExecutedTicks *c = getCounters(curCpu);
+      *fetched_instr = c ? c->getInstrFetched() : 0;
+      *fetched_time = c ? c->getTicks() : 0;
+    }
+
+    void
+    CalculateDecodedTime(int curCpu , uint64_t *decoded_instr, uint64_t *decoded_time)
+    {
+      const cpuExecutedTicks *c = getCounters(curCpu);
+      *decoded_instr = c ? c->getInstrDecoded() : 0;
+      *decoded_time = c ? c->getTicks() : 0;
+    }
+
+    void
+    CalculateExecutedTime(int curCpu , uint64_t *exec_instr ,uint64_t *exec_time)
+    {
+      const cpuExecutedTicks *c = getCounters(curCpu);
+      *exec_instr = c ? c->getInstrExecuted() : 0;
+      *exec_time = c ? c->getTicks() : 0;
+    }
     
     
     void print_time();
 
+    /* the counters are saved by core name ("all" for the sum of all cores)
+     * so they land on the right core even if the ids are given in a different order
+     */
+    void serialize(std::ostream &os);
+    void unserialize(Checkpoint *cp, const std::string &section);
+
 };
 
 #endif //  __CPU_THREAD_FAULT_INFO__
@@ -0,0 +1,14 @@
+#include "cpu/thread_context.hh"
+#include "fi/crash_event.hh"
+#include "fi/fi_system.hh"
+
+CrashEvent::CrashEvent(PCEventQueue *q, const std::string &symbol, Addr pc)
+  : PCEvent(q, symbol, pc)
+{
+}
+
+void
+CrashEvent::process(ThreadContext *tc)
+{
+  fi_system->guest_crash(tc, descr());
+}
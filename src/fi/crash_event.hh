@@ -0,0 +1,24 @@
+#ifndef __FI_CRASH_EVENT_HH__
+#define __FI_CRASH_EVENT_HH__
+
+#include <string>
+
+#include "base/types.hh"
+#include "cpu/pc_event.hh"
+
+class ThreadContext;
+
+/*
+ * Breakpoint on a guest kernel function that only runs when the guest
+ * crashes (panic, oops). A run that applied a fault is ended there and
+ * classified as a crash (Fi_System::guest_crash).
+ */
+class CrashEvent : public PCEvent
+{
+  public:
+    CrashEvent(PCEventQueue *q, const std::string &symbol, Addr pc);
+
+    virtual void process(ThreadContext *tc);
+};
+
+#endif // __FI_CRASH_EVENT_HH__
@@ -0,0 +1,113 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/misc.hh"
+#include "fi/fault_list.hh"
+
+using namespace std;
+
+FaultList::FaultList()
+  : base(NULL), size(0), header(NULL), coreNames(NULL), records(NULL)
+{
+}
+
+FaultList::~FaultList()
+{
+  close();
+}
+
+bool
+FaultList::isFaultList(const string &path)
+{
+  char magic[sizeof(FaultListMagic)];
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+  bool ret = read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+    memcmp(magic, FaultListMagic, sizeof(magic)) == 0;
+  ::close(fd);
+  return ret;
+}
+
+void
+FaultList::open(const string &path)
+{
+  struct stat st;
+
+  close();
+  fileName = path;
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    fatal("FaultList: unable to open %s: %s\n", path, strerror(errno));
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(FaultListHeader))
+    fatal("FaultList: %s is not a fault list\n", path);
+
+  size = st.st_size;
+  base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    base = NULL;
+    fatal("FaultList: unable to map %s: %s\n", path, strerror(errno));
+  }
+  //the records are read in order once, let the kernel read ahead
+  madvise(base, size, MADV_SEQUENTIAL);
+
+  header = static_cast<const FaultListHeader *>(base);
+  if (memcmp(header->magic, FaultListMagic, sizeof(FaultListMagic)) != 0)
+    fatal("FaultList: %s is not a fault list\n", path);
+  if (header->version != FaultListVersion)
+    fatal("FaultList: %s has version %d, expected %d\n", path,
+          header->version, FaultListVersion);
+
+  coreNames = static_cast<const char *>(base) + sizeof(FaultListHeader);
+  records = reinterpret_cast<const FaultRecord *>(coreNames +
+      header->numCores * FaultListCoreNameLen);
+  if ((const char *)(records + header->numRecords) > (const char *)base + size ||
+      header->addrRecords + header->instRecords > header->numRecords)
+    fatal("FaultList: %s is truncated\n", path);
+}
+
+void
+FaultList::close()
+{
+  if (base)
+    munmap(base, size);
+  base = NULL;
+  size = 0;
+  header = NULL;
+  coreNames = NULL;
+  records = NULL;
+}
+
+string
+FaultList::coreName(int core) const
+{
+  if (core < 0)
+    return "all";
+  if ((uint32_t)core >= header->numCores)
+    fatal("FaultList: %s has no core %d\n", fileName, core);
+  const char *name = coreNames + core * FaultListCoreNameLen;
+  return string(name, strnlen(name, FaultListCoreNameLen));
+}
+
+void
+FaultList::check(const FaultRecord &r) const
+{
+  if (r.type >= FaultRecord::NumTypes)
+    fatal("FaultList: %s has a record of unknown type %d\n", fileName, r.type);
+  if (r.timingType < 1 || r.timingType > 3)
+    fatal("FaultList: %s has a record of unknown timing %d\n", fileName, r.timingType);
+  if (r.valueType < 1 || r.valueType > 4)
+    fatal("FaultList: %s has a record of unknown value %d\n", fileName, r.valueType);
+  if (r.core >= 0 && (uint32_t)r.core >= header->numCores)
+    fatal("FaultList: %s has no core %d\n", fileName, r.core);
+  if (r.type == FaultRecord::Register && r.regType > 2)
+    fatal("FaultList: %s has a record of unknown register type %d\n", fileName, r.regType);
+  if (r.type == FaultRecord::O3Struct && r.regType > 4)
+    fatal("FaultList: %s has a record of unknown structure %d\n", fileName, r.regType);
+}
@@ -0,0 +1,103 @@
+#ifndef __FI_FAULT_LIST_HH__
+#define __FI_FAULT_LIST_HH__
+
+#include <string>
+
+#include "base/types.hh"
+
+/*
+ * Binary fault list, written by util/fi_faultlist.py from the text format
+ * of src/fi/description. The file is mapped read only and the faults are
+ * created from their records only when their time comes close.
+ *
+ * Layout: FaultListHeader, numCores core names of FaultListCoreNameLen
+ * bytes, numRecords FaultRecord. The Addr timed records come first, then
+ * the Inst timed and then the Tick timed ones, each sorted by timing.
+ * All values are little endian.
+ */
+
+static const char FaultListMagic[8] = {'M', '5', 'F', 'I', 'L', 'S', 'T', '\0'};
+static const uint32_t FaultListVersion = 1;
+static const int FaultListCoreNameLen = 64;
+
+struct FaultListHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t numCores;
+  uint64_t numRecords;
+  uint64_t addrRecords;  // records [0, addrRecords) are Addr timed
+  uint64_t instRecords;  // the next instRecords are Inst timed, the rest Tick timed
+};
+
+struct FaultRecord
+{
+  //fault classes, in the order of src/fi/description
+  enum Type {
+    GeneralFetch = 0,
+    IEWStage,
+    Memory,
+    OpCode,
+    PC,
+    Register,
+    RegisterDecoding,
+    CPU,
+    Plain,
+    O3CPU,
+    O3Struct,
+    NumTypes
+  };
+
+  uint64_t timing;
+  uint64_t value;
+  int64_t arg0;        // Register/Memory: register, RegisterDecoding: register to change
+  int64_t arg1;        // Memory: offset, RegisterDecoding: register to change to
+  int32_t thread;      // -1 for all threads
+  int32_t core;        // index in the core names, -1 for all cores
+  int32_t occurrence;
+  int32_t tcontext;
+  uint8_t type;        // FaultRecord::Type
+  uint8_t timingType;  // InjectedFault::TickTiming, InstructionTiming, VirtualAddrTiming
+  uint8_t valueType;   // InjectedFault::ImmediateValue ... AllValue (value 0 or 1)
+  uint8_t regType;     // Register: 0 int 1 float 2 misc, RegisterDecoding: 0 Src 1 Dst,
+                       // O3Struct: BaseO3CPU::FiStructure (arg0 entry, arg1 field)
+  uint8_t pad[4];
+};
+
+class FaultList
+{
+  private:
+    std::string fileName;
+    void *base;
+    size_t size;
+    const FaultListHeader *header;
+    const char *coreNames;
+    const FaultRecord *records;
+
+  public:
+    FaultList();
+    ~FaultList();
+
+    /* true if the file starts with the fault list magic
+     */
+    static bool isFaultList(const std::string &path);
+
+    void open(const std::string &path);
+    void close();
+    bool isOpen() const { return base != NULL; }
+
+    uint32_t numCores() const { return header->numCores; }
+    uint64_t numRecords() const { return header->numRecords; }
+    uint64_t addrRecords() const { return header->addrRecords; }
+    uint64_t instRecords() const { return header->instRecords; }
+
+    const FaultRecord &record(uint64_t i) const { return records[i]; }
+    std::string coreName(int core) const;
+
+    /* fatal() on a record with a field out of its range, the faults
+     * are created straight from the checked fields
+     */
+    void check(const FaultRecord &r) const;
+};
+
+#endif // __FI_FAULT_LIST_HH__
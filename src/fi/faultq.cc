@@ -3,6 +3,7 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include "cpu/o3/cpu.hh"
 #include "fi/faultq.hh"
 #include "fi/cpu_threadInfo.hh"
@@ -11,11 +12,14 @@ using namespace std;
 
 
 
+uint64_t InjectedFault::faultCnt = 0;
+
 // Insert faults
-InjectedFault::InjectedFault(ifstream &os)
+InjectedFault::InjectedFault(std::istream &os)
 {
 	std:: string _when, _what, _thread, _where ;
 	int _occ;
+	_queue = NULL;
 	os>>_when;
 	os>>_what;
 	os>>_thread;
@@ -33,19 +37,41 @@ InjectedFault::InjectedFault(ifstream &os)
 	setThread(_thread);
 	setWhen(_when);
 	setWhere(_where);
+	_whereId = fi_system->get_core_id(_where);
 	setWhat(_what);
 	parseWhat(_what);
 	parseWhen(_when);
 	setFaultID();
 	setOccurrence(_occ);
 	setManifested(false);
+	setServicedAt(0);
+	setQueue(NULL);
 }
 
 
 
+InjectedFault::InjectedFault(const FaultRecord &r, int whereId)
+{
+	_queue = NULL;
+	_whereId = whereId;
+	_where = whereId == ThreadEnabledFault::AllCores ? "all" : fi_system->get_core_name(whereId);
+	_threadId = r.thread < 0 ? -1 : r.thread;
+	setTimingType(r.timingType);
+	setTiming(r.timing);
+	setValueType(r.valueType);
+	_value = r.value;
+	setMasks();
+	setFaultID();
+	setOccurrence(r.occurrence);
+	setManifested(false);
+	setServicedAt(0);
+}
+
 InjectedFault::~InjectedFault()
 {
-  getQueue()->remove(this);
+  //a fault may already have been taken out of its queue
+  if (getQueue() && getQueue()->contains(this))
+    getQueue()->remove(this);
 }
 
 
@@ -80,28 +106,113 @@ InjectedFault::parseWhen(std::string s)
   return 0;
 }
 
+// splitmix64, util/fi_faultlist.py draws the same bits
+static uint64_t
+next_random(uint64_t &state)
+{
+  uint64_t z = (state += ULL(0x9e3779b97f4a7c15));
+  z = (z ^ (z >> 30)) * ULL(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * ULL(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+// k adjacent bits from bit (counted from 1 as for Flip)
+static uint64_t
+burst_mask(uint64_t bit, uint64_t k)
+{
+  uint64_t mask = 0;
+  for (uint64_t i = 0; bit && i < k && bit - 1 + i < 64; i++)
+    mask |= ULL(1) << (bit - 1 + i);
+  return mask;
+}
+
+// k distinct bits out of the n low ones
+static uint64_t
+random_mask(uint64_t k, uint64_t n, uint64_t seed)
+{
+  uint64_t mask = 0;
+  n = std::min<uint64_t>(n, 64);
+  k = std::min(k, n);
+  for (uint64_t set = 0; set < k;) {
+    uint64_t bit = ULL(1) << (next_random(seed) % n);
+    if (!(mask & bit)) {
+      mask |= bit;
+      set++;
+    }
+  }
+  return mask;
+}
+
+void
+InjectedFault::setMasks()
+{
+  _andMask = ~ULL(0);
+  _xorMask = 0;
+  switch (_valueType) {
+  case ImmediateValue:
+    _andMask = 0;
+    _xorMask = _value;
+    break;
+  case MaskValue:
+    _xorMask = _value;
+    break;
+  case FlipBit:
+    _xorMask = burst_mask(_value, 1);
+    break;
+  case AllValue:
+    _andMask = 0;
+    _xorMask = _value ? ~ULL(0) : 0;
+    break;
+  }
+}
+
 int
 InjectedFault::parseWhat(std::string s)
 {
+  uint64_t arg[3] = { 0, 0, 0 };
+  size_t colon = s.find(':');
+  if (colon != std::string::npos) {
+    std::istringstream in(s.substr(colon + 1));
+    char sep;
+    for (int i = 0; i < 3 && in >> arg[i]; i++)
+      in >> sep;
+  }
+
+  //the masks of (in & and) ^ xor
   if (s.compare(0,4,"Immd",0,4) == 0) {
     setValueType(InjectedFault::ImmediateValue);
     setValue(s.substr(5));
+    setMasks();
   }
   else if (s.compare(0,4,"Mask",0,4) == 0) {
     setValueType(InjectedFault::MaskValue);
     setValue(s.substr(5));
+    setMasks();
   }
   else if (s.compare(0,4,"Flip",0,4) == 0) {
     setValueType(InjectedFault::FlipBit);
     setValue(s.substr(5));
+    setMasks();
   }
   else if (s.compare(0,4,"All0",0,4) == 0) {
     setValueType(InjectedFault::AllValue);
     setValue(0);
+    setMasks();
   }
   else if (s.compare(0,4,"All1",0,4) == 0) {
     setValueType(InjectedFault::AllValue);
     setValue(1);
+    setMasks();
+  }
+  else if (s.compare(0,6,"Burst:",0,6) == 0) {
+    setValueType(InjectedFault::BurstBits);
+    _xorMask = burst_mask(arg[0], arg[1]);
+    _value = _xorMask;
+  }
+  else if (s.compare(0,5,"Rand:",0,5) == 0) {
+    setValueType(InjectedFault::RandomBits);
+    _xorMask = random_mask(arg[0], arg[1], arg[2]);
+    _value = _xorMask;
   }
   else {
     std::cout << "InjectedFault::parseWhat() - Error Unsupported type " << s << "\n";
@@ -112,6 +223,15 @@ InjectedFault::parseWhat(std::string s)
   return 0;
 }
 
+void
+InjectedFault::rearm(Tick cycle, Addr instSize)
+{
+  uint64_t now = std::max<uint64_t>(getTiming(), getServicedAt());
+  increaseTiming(now + cycle, now + 1, getTiming() + instSize);
+  decreaseOccurrence();
+  setManifested(false);
+}
+
 void 
 InjectedFault::increaseTiming(uint64_t cycles, uint64_t insts, uint64_t addr)
 {
@@ -119,12 +239,12 @@ InjectedFault::increaseTiming(uint64_t cycles, uint64_t insts, uint64_t addr)
     {
     case (InjectedFault::TickTiming):
       {
-	setTiming(cycles);
+	getQueue()->retime(this, cycles);
 	break;
       }
     case (InjectedFault::InstructionTiming):
       {
-	  setTiming(insts);
+	  getQueue()->retime(this, insts);
 	  break;
       }
     case (InjectedFault::VirtualAddrTiming):
@@ -164,7 +284,7 @@ InjectedFault::dump() const
     std::cout << "\tWhere: " << getWhere() << "\n";
     std::cout << "\tWhen: " << getWhen() << "\n";
     std::cout << "\tWhat: " << getWhat() << "\n";
-    std::cout << "\tthreadID: " << getThread() << "\n";
+    std::cout << "\tthreadID: " << getThreadId() << "\n";
     std::cout << "\tfaultID: " << getFaultID() << "\n";
     std::cout << "\tfaultType: " << getFaultType() << "\n";
     std::cout << "\ttimingType: " << getTimingType() << "\n";
@@ -177,17 +297,101 @@ InjectedFault::dump() const
 }
 
 InjectedFaultQueue::InjectedFaultQueue()
-:objName(""), head(NULL),tail(NULL)
+:objName(""), stage(InjectedFaultQueue::MainStage),
+ instMark(0), tickMark(0), pcLow(MaxAddr), pcHigh(0), head(NULL),tail(NULL)
 {
   //
 }
 
 InjectedFaultQueue::InjectedFaultQueue(const string &n)
-  : objName(n), head(NULL), tail(NULL)
+  : objName(n), stage(InjectedFaultQueue::MainStage),
+    instMark(0), tickMark(0), pcLow(MaxAddr), pcHigh(0), head(NULL), tail(NULL)
 {
-  
+  setName(n);
 }
 
+void
+InjectedFaultQueue::setName(string v)
+{
+  objName = v;
+  if (objName.compare("IEWStageFaultQueue") == 0)
+    stage = InjectedFaultQueue::IEWStage;
+  else if (objName.compare("DecodeStageFaultQueue") == 0)
+    stage = InjectedFaultQueue::DecodeStage;
+  else if (objName.compare("FetchStageFaultQueue") == 0)
+    stage = InjectedFaultQueue::FetchStage;
+  else
+    stage = InjectedFaultQueue::MainStage;
+}
+
+//find the trigger bucket that has the same timing type and scope as the fault
+InjectedFaultTrigger *
+InjectedFaultQueue::findTrigger(InjectedFault *f, bool create)
+{
+  for (size_t i = 0; i < triggers.size(); i++) {
+    InjectedFaultTrigger *t = triggers[i];
+    if (t->timingType == f->getTimingType() && t->thread == f->getThreadId() &&
+	t->where == f->getWhereId())
+      return t;
+  }
+  if (!create)
+    return NULL;
+  triggers.push_back(new InjectedFaultTrigger(f->getTimingType(), f->getWhereId(), f->getThreadId()));
+  return triggers.back();
+}
+
+void
+InjectedFaultQueue::index(InjectedFault *f)
+{
+  invalidateMarks();
+  if (f->getTimingType() == InjectedFault::VirtualAddrTiming) {
+    std::vector<InjectedFault *> &v = addrTriggers[f->getTiming()];
+    if (v.empty())
+      fi_system->add_addr_offset(f->getTiming());
+    v.push_back(f);
+    //the range only grows, removed offsets keep it conservative
+    pcLow = std::min(pcLow, (Addr)f->getTiming());
+    pcHigh = std::max(pcHigh, (Addr)f->getTiming());
+  }
+  else {
+    findTrigger(f, true)->pending.insert(f);
+  }
+}
+
+//returns false if the fault was not indexed in this queue
+bool
+InjectedFaultQueue::unindex(InjectedFault *f)
+{
+  invalidateMarks();
+  if (f->getTimingType() == InjectedFault::VirtualAddrTiming) {
+    AddrTriggerMap::iterator it = addrTriggers.find(f->getTiming());
+    if (it == addrTriggers.end())
+      return false;
+    std::vector<InjectedFault *> &v = it->second;
+    std::vector<InjectedFault *>::iterator p = std::find(v.begin(), v.end(), f);
+    if (p == v.end())
+      return false;
+    v.erase(p);
+    if (v.empty()) {
+      addrTriggers.erase(it);
+      fi_system->remove_addr_offset(f->getTiming());
+    }
+    return true;
+  }
+
+  InjectedFaultTrigger *t = findTrigger(f, false);
+  return t && t->pending.erase(f);
+}
+
+//the timing is part of the ordering key so the fault is reinserted in its bucket
+void
+InjectedFaultQueue::retime(InjectedFault *f, uint64_t timing)
+{
+  bool queued = unindex(f);
+  f->setTiming(timing);
+  if (queued)
+    index(f);
+}
 
 void
 InjectedFaultQueue::insert(InjectedFault *f)
@@ -196,8 +400,8 @@ InjectedFaultQueue::insert(InjectedFault *f)
 
   InjectedFault *p;
 
-  p = head;
-  
+  index(f);
+
   if (empty()) {//queue is empty
     head = f;
     tail = f;
@@ -209,27 +413,31 @@ InjectedFaultQueue::insert(InjectedFault *f)
     return;
   }
   else {//queue is not empty
-    while ((p!=NULL) && (p->getTiming() < f->getTiming())) {//travel queue elements to find the one before which our element will be inserted
-      p = p->nxt;
+    //faults are usually read in ascending order so travel the queue from its end
+    p = tail;
+    while ((p!=NULL) && (p->getTiming() > f->getTiming())) {//find the element after which our element will be inserted
+      p = p->prv;
     }
     
-    if (p==NULL) {//element inserted at the end
+    if (p==tail) {//element inserted at the end
       tail->nxt = f;
       f->prv = tail;
+      f->nxt = NULL;
       tail = f;
       return;
     }
-    else if (p==head) {//element inserted in the beginning
+    else if (p==NULL) {//element inserted in the beginning
       head->prv = f;
       f->nxt = head;
+      f->prv = NULL;
       head = f;
       return;
     }
     else {//element inserted between two other elements
-      p->prv->nxt = f;
-      f->prv = p->prv;
-      p->prv =f;
-      f->nxt = p;
+      p->nxt->prv = f;
+      f->nxt = p->nxt;
+      p->nxt = f;
+      f->prv = p;
       return;
     }
   }
@@ -239,19 +447,12 @@ InjectedFaultQueue::insert(InjectedFault *f)
 void
 InjectedFaultQueue::remove(InjectedFault *f)
 {
-  InjectedFault *p;
-
-
   if ((head==NULL) & (tail==NULL)) {//queue is empty
     return;
   }
 
-  p = head;
-  while ((p!=NULL) && (p!=f)) {//search if event exists
-    p = p->nxt;
-  }
-
-  if (p==NULL) {//event was not found
+  //every fault of the queue is indexed, so the index tells us if it exists
+  if (!unindex(f)) {//event was not found
     std::cout << "InjectedFaultQueue:remove() -- Fault was not found on the queue\n";
     assert(0);
   }
@@ -274,76 +475,74 @@ InjectedFaultQueue::remove(InjectedFault *f)
 
 }
 
+bool
+InjectedFaultQueue::contains(InjectedFault *f)
+{
+  if (f->getTimingType() == InjectedFault::VirtualAddrTiming) {
+    AddrTriggerMap::iterator it = addrTriggers.find(f->getTiming());
+    return it != addrTriggers.end() &&
+      std::find(it->second.begin(), it->second.end(), f) != it->second.end();
+  }
+
+  InjectedFaultTrigger *t = findTrigger(f, false);
+  if (!t)
+    return false;
+  std::set<InjectedFault *, InjectedFaultTimingOrder>::iterator p = t->pending.find(f);
+  return p != t->pending.end() && *p == f;
+}
+
 // Check if on this cycle/isntruction a fault is going to manifest.
+// Only the earliest fault of every trigger bucket is compared against the
+// counter of its scope, so the cost does not depend on the queue length.
 
-InjectedFault *InjectedFaultQueue::scan(std::string s , ThreadEnabledFault &thisThread , Addr vaddr){
+InjectedFault *InjectedFaultQueue::scan(int s , ThreadEnabledFault &thisThread , Addr vaddr){
 
-  InjectedFault *p;
-  int i;
   uint64_t exec_time = 0;
   uint64_t exec_instr = 0;
-  
-  p = head;
-  //pass the list and check if a fault meets the conditions
-  while(p){
-    if(!p->isManifested()){
-      exec_time = 0;
-      exec_instr = 0;
-      
-      //find how much time do I run.
-      if(name().compare("IEWStageFaultQueue") == 0 ){
-	i = fi_system->get_fi_exec_counters( p , thisThread, s , &exec_instr , &exec_time );
-      }
-      else if (name().compare("DecodeStageFaultQueue") == 0 ){
-	i = fi_system->get_fi_decode_counters( p , thisThread, s , &exec_instr , &exec_time );
-      }
-      else{
-	i = fi_system->get_fi_fetch_counters( p , thisThread, s , &exec_instr , &exec_time );
-      }
+  uint64_t now;
+  InjectedFault *p;
 
-      if(DTRACE(FaultInjection)){
-	// if((exec_instr % 10000) == 1)
-	//    std::cout << i <<" InjectedFault "<<	s <<" :: SCAN TICKS  :" << exec_time <<" INSTR: " << exec_instr << "\n";
-	  }
-      if(i){
-	  switch( p->getTimingType() ){
-	    case (InjectedFault ::TickTiming):
-	    {   
-	      if(exec_time == p->getTiming()){ //correct time so intend to manifest
-		p->setServicedAt(exec_time);
-		return(p);
-	      }
-	    }
-	    break;
-	    case (InjectedFault ::InstructionTiming):
-	    {
-	      if(exec_instr == p->getTiming() ){
-		p->setServicedAt(exec_instr);
-		return(p);
-	      }
-	    }
-	    break;
-	    case (InjectedFault ::VirtualAddrTiming):
-	    {
-	      if(vaddr == p->getTiming() + thisThread.getMagicInstVirtualAddr() ){
-		  p->setServicedAt(vaddr);
-		  p->dump();
-		  return(p);
-	      }
-	    }
-	    break;
-	    default:
-	      {
-		std::cout << "InjectedFaultQueue::scan() - getTimingType default type error\n";
-		assert(0);
-		break;
-	      }
-	  
-	  
-	  }
-	}
+  for (size_t i = 0; i < triggers.size(); i++) {
+    InjectedFaultTrigger *t = triggers[i];
+    if (t->pending.empty() || !t->covers(s, thisThread.getThreaId()))
+      continue;
+
+    //find how much time do I run.
+    fi_system->get_fi_counters(getStage(), t->where, t->thread, thisThread, s, &exec_instr, &exec_time);
+    if (!(exec_time | exec_instr))
+      continue;
+
+    now = (t->timingType == InjectedFault::TickTiming) ? exec_time : exec_instr;
+    p = t->next();
+    if (now >= p->getTiming()) { //threshold crossed so intend to manifest
+      fi_system->set_fault_cpu(p, s);
+      p->setServicedAt(now);
+      return(p);
+    }
+  }
+
+  if (addrTriggers.empty())
+    return(NULL);
+
+  AddrTriggerMap::iterator it = addrTriggers.find(vaddr - thisThread.getMagicInstVirtualAddr());
+  if (it == addrTriggers.end())
+    return(NULL);
+
+  for (size_t i = 0; i < it->second.size(); i++) {
+    p = it->second[i];
+    if (p->isManifested())
+      continue;
+    if (p->getThreadId() != -1 && p->getThreadId() != thisThread.getThreaId())
+      continue;
+    if (p->getWhereId() != ThreadEnabledFault::AllCores && p->getWhereId() != s)
+      continue;
+    fi_system->get_fi_counters(getStage(), p->getWhereId(), p->getThreadId(), thisThread, s, &exec_instr, &exec_time);
+    if (exec_time | exec_instr) {
+      fi_system->set_fault_cpu(p, s);
+      p->setServicedAt(vaddr);
+      p->dump();
+      return(p);
     }
-    p = p->nxt;
   }
   return(NULL);
   
@@ -354,6 +553,74 @@ InjectedFault *InjectedFaultQueue::scan(std::string s , ThreadEnabledFault &this
 
 
 
+void
+InjectedFaultQueue::serialize(std::ostream &os)
+{
+  std::vector<uint64_t> fault_id, timing;
+  std::vector<int> timing_type, occurrence, manifested;
+  std::vector<Tick> serviced_at;
+  uint64_t base = fi_system->get_fault_base();
+
+  for (InjectedFault *p = head; p != NULL; p = p->nxt) {
+    fault_id.push_back(p->getFaultID() - base);
+    timing.push_back(p->getTiming());
+    timing_type.push_back(p->getTimingType());
+    occurrence.push_back(p->getOccurrence());
+    manifested.push_back(p->isManifested());
+    serviced_at.push_back(p->getServicedAt());
+  }
+
+  arrayParamOut(os, "fault_id", fault_id);
+  arrayParamOut(os, "timing", timing);
+  arrayParamOut(os, "timing_type", timing_type);
+  arrayParamOut(os, "occurrence", occurrence);
+  arrayParamOut(os, "manifested", manifested);
+  arrayParamOut(os, "serviced_at", serviced_at);
+}
+
+void
+InjectedFaultQueue::unserialize(Checkpoint *cp, const std::string &section)
+{
+  std::vector<uint64_t> fault_id, timing;
+  std::vector<int> timing_type, occurrence, manifested;
+  std::vector<Tick> serviced_at;
+  uint64_t base = fi_system->get_fault_base();
+
+  arrayParamIn(cp, section, "fault_id", fault_id);
+  arrayParamIn(cp, section, "timing", timing);
+  arrayParamIn(cp, section, "timing_type", timing_type);
+  arrayParamIn(cp, section, "occurrence", occurrence);
+  arrayParamIn(cp, section, "manifested", manifested);
+  arrayParamIn(cp, section, "serviced_at", serviced_at);
+
+  std::map<uint64_t, size_t> saved;
+  for (size_t i = 0; i < fault_id.size(); i++)
+    saved[fault_id[i]] = i;
+
+  //take every fault out and put back the pending ones with their saved state
+  std::vector<InjectedFault *> faults;
+  while (!empty()) {
+    faults.push_back(head);
+    remove(head);
+  }
+
+  for (size_t i = 0; i < faults.size(); i++) {
+    InjectedFault *f = faults[i];
+    std::map<uint64_t, size_t>::iterator it = saved.find(f->getFaultID() - base);
+    if (it == saved.end()) {
+      delete f; //already serviced when the checkpoint was taken
+      continue;
+    }
+    size_t j = it->second;
+    f->setTimingType(timing_type[j]);
+    f->setTiming(timing[j]);
+    f->setOccurrence(occurrence[j]);
+    f->setManifested(manifested[j] != 0);
+    f->setServicedAt(serviced_at[j]);
+    insert(f);
+  }
+}
+
 void
 InjectedFaultQueue::dump() const
 {
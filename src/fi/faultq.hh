@@ -2,14 +2,18 @@
 #define __INJECTED_FAULT_QUEUE_HH__
 
 #include <map>
+#include <set>
+#include <vector>
 #include <utility> // make_pair
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
 
 #include "config/the_isa.hh"
 #include "base/types.hh"
+#include "base/hashmap.hh"
 #include "arch/types.hh"
 #include "base/trace.hh"
 #include "debug/FaultInjection.hh"
@@ -29,26 +33,25 @@ using namespace TheISA;
 class InjectedFaultQueue; // forward declaration
 class InjectedFault; //forward declaration
 class ThreadEnabledFault; //forward declaration
+struct FaultRecord; //forward declaration
 
 
 
-static const unsigned char singlebit_mask[] = {0x01,
-					       0x02,
-					       0x04,
-					       0x08,
-					       0x10,
-					       0x20,
-					       0x40,
-					       0x80};
-
-static const unsigned char all_mask[] = {0x00,
-					 0xFF};
+/*
+ * Unsigned word as wide as a structure the faults manifest on, the value
+ * models are applied on it with a single operation.
+ */
+template <int Bytes> struct FaultWord;
+template <> struct FaultWord<1> { typedef uint8_t Type; };
+template <> struct FaultWord<2> { typedef uint16_t Type; };
+template <> struct FaultWord<4> { typedef uint32_t Type; };
+template <> struct FaultWord<8> { typedef uint64_t Type; };
 
 class InjectedFault 
 {
   friend class InjectedFaultQueue;
   friend class ThreadEnabledFault;
-//  friend class Fi_System;
+  friend class Fi_System;
 
 public:
   //Fault Types (WHERE) -- Location of the injection
@@ -60,6 +63,7 @@ public:
   static const InjectedFaultType OpCodeInjectedFault           = 5;
   static const InjectedFaultType RegisterDecodingInjectedFault = 6;
   static const InjectedFaultType ExecutionInjectedFault        = 7;
+  static const InjectedFaultType O3StructInjectedFault         = 8;
   InjectedFault *nxt;
   InjectedFault *prv;
 protected:
@@ -75,6 +79,8 @@ protected:
   static const InjectedFaultValueType MaskValue = 2;
   static const InjectedFaultValueType FlipBit = 3;
   static const InjectedFaultValueType AllValue = 4;
+  static const InjectedFaultValueType BurstBits = 5;
+  static const InjectedFaultValueType RandomBits = 6;
 
 
 protected: 
@@ -84,9 +90,11 @@ protected:
 
   
   std::string _where;// contains the name of the module that we will inject with the fault (e.g. 'system.cpu')
+  int _whereId; // core id of _where given by Fi_System (ThreadEnabledFault::AllCores for "all")
   std::string _when;// contains information about the timing of the injection
   std::string _what;// contains information about the nature and the value of the injection (how the structures value will be affected)
   std::string _thread; //contains  information about the software thread that the fault will be injected
+  int _threadId; // _thread parsed once at load time (-1 stands for "all")
   
   InjectedFaultQueue  *_queue;//the queue in which the fault has been scheduled
 
@@ -95,6 +103,13 @@ protected:
   InjectedFaultValueType _valueType;//method used for corrupting the injected structures content (XOR, OR, Immediate value)
   uint64_t _timing;// when the fault should manifest
   uint64_t _value;// what value should be used together with the corruption method
+  /*
+   * Every value model is applied as (in & _andMask) ^ _xorMask, bit 0 of
+   * the masks is bit 0 of the structure (a narrower one takes the low
+   * bits). parseWhat() computes them when the fault is read.
+   */
+  uint64_t _andMask;
+  uint64_t _xorMask;
   int servicedFrom;
 
   int _occurrence;//how many times the fault should manifest (1:transient fault, 0: permanent fault, >0: intermittent fault)
@@ -111,9 +126,9 @@ protected:
 
   /* The setXXX functions are used to assign values at the above described variable
    */
+  static uint64_t faultCnt; // ids given so far, faults are numbered in the order they are read
   void setFaultID()
   {
-    static uint64_t faultCnt = 0;
     _faultID = faultCnt++; 
   }
   void setFaultID(int id){
@@ -138,7 +153,11 @@ protected:
   void setWhen(std::string v) { _when = v;}
   void setWhere(std::string v) { _where = v;}
   void setWhat(std::string v) { _what = v;}
-  void setThread(std::string v){_thread = v; }
+  void setThread(std::string v)
+  {
+    _thread = v;
+    _threadId = (v.compare("all") == 0) ? -1 : atoi(v.c_str());
+  }
 
   void setOccurrence(int v) { _occurrence = v;}
   void setManifested(bool v) { manifested = v;}
@@ -159,14 +178,32 @@ protected:
    */
   int parseWhen(std::string _when);
   int parseWhat(std::string _what);
+
+  /* the masks of the Immd, Mask, Flip and All value models from _valueType and _value
+   */
+  void setMasks();
   
 	
 	
 	
 public:
 
-  InjectedFault(ifstream &os);
-  ~InjectedFault();
+  InjectedFault(std::istream &os);
+  /* a fault of a binary fault list, whereId is the core id of its record
+   */
+  InjectedFault(const FaultRecord &r, int whereId);
+  virtual ~InjectedFault();
+
+  /* id that the next fault read is going to get
+   */
+  static uint64_t nextFaultID() { return faultCnt; }
+
+  /* re-arms an intermittent/permanent fault one step (cycle ticks, an
+   * instruction or instSize bytes) after the counter it was serviced at,
+   * not after its old timing, so a hook applies it at most once even when
+   * the counter jumped several steps since the previous hook
+   */
+  void rearm(Tick cycle, Addr instSize);
   
   virtual const char *description() const;
   virtual void dump() const;
@@ -175,7 +212,7 @@ public:
  
 
 
-  bool isLittleEndian()
+  static bool isLittleEndian()
   {
       static bool little_endian ;
       static bool endian_checked = false ;
@@ -191,7 +228,7 @@ public:
   }
  
   template <class T>
-  std::string type_to_hex( const T arg )
+  static std::string type_to_hex( const T arg )
   {
       std::ostringstream hexstr ;
       const char* addr = reinterpret_cast<const char*>(&arg) ;
@@ -216,196 +253,21 @@ public:
       return hexstr.str() ;
   }
   
-  template <class T> inline T
-  XOR(T in, uint64_t out)
-  {
-    int i = sizeof(T) - 1;
-    int j = sizeof(uint64_t) - 1;
-
-    unsigned char *inP = (unsigned char *)&in;
-    unsigned char *outP = (unsigned char *)&out;
-
-    while(i>=0) {
-	inP[i] = inP[i] ^ outP[j];
-	j--;
-	i--;
-      }
-
-    return in;
-  }
- 
-  //AND's the two given values and returns the result
-  template <class T> inline T
-  AND(T in, uint64_t out)
-  {
-    int i = sizeof(T) - 1;
-    int j = sizeof(uint64_t) - 1;
-
-    unsigned char *inP = (unsigned char *)&in;
-    unsigned char *outP = (unsigned char *)&out;
-
-    while(i>=0) {
-	inP[i] = inP[i] & outP[j];
-	j--;
-	i--;
-      }
-
-    return in;
-  }
-
-  //OR's the two given values and returns the result
-  template <class T> inline T
-  OR(T in, uint64_t out)
-  {
-    int i = sizeof(T) - 1;
-    int j = sizeof(uint64_t) - 1;
-
-    unsigned char *inP = (unsigned char *)&in;
-    unsigned char *outP = (unsigned char *)&out;
-
-    while(i>=0) {
-      inP[i] = inP[i] | outP[j];
-	j--;
-	i--;
-      }
-
-    return in;
-  }
-
-  //Set the value of 'out' at 'in'
-  template <class T>
-  inline
-  T
-  IMMD(T in, uint64_t out)
-  {
-    int i = sizeof(T) - 1;
-    int j = sizeof(uint64_t) - 1;
-
-    unsigned char *inP = (unsigned char *)&in;
-    unsigned char *outP = (unsigned char *)&out;
-
-    while(i>=0) {
-	inP[i] = outP[j];
-	j--;
-	i--;
-      }
-
-    return in;
-  }
-
-  template <class T> inline T
-  FLIP(T in, uint64_t out)
-  {
-    int i = sizeof(T) - 1;
-
-    int j_quotient;
-    int j_remainder;
-
-    if (!out)//we do not flip a bit
-      return in;
-
-    j_quotient = (out-1) / 8;
-    j_remainder = (out-1) % 8;
-
-    //assert(i >= j_quotient);//this shouldn't be an assertion
-    if (j_quotient > i) {
-      std::cout << "Structure is not affected by the fault\n";
-      return in;
-    }
-
-    unsigned char *inP = (unsigned char *)&in;
-    
-    inP[j_quotient] = inP[j_quotient] ^ singlebit_mask[j_remainder];
-
-    return in;
-  }
-
-  template <class T> inline T
-  ALL(T in, uint64_t out)
-  {
-    int i = sizeof(T) - 1;
-
-    unsigned char *inP = (unsigned char *)&in;
-    
-    assert(out==0 || out==1);
-
-    while(i>=0) {
-      inP[i] = all_mask[out];
-      i--;
-    }
-    
-    return in;
-  }
-
   template <class T>
   T
-  manifest(T in, uint64_t out, InjectedFaultValueType type)
+  manifest(T in) const
   {
+    typedef typename FaultWord<sizeof(T)>::Type Word;
+    Word w;
+    memcpy(&w, &in, sizeof(T));
+    w = (w & (Word)_andMask) ^ (Word)_xorMask;
     T retVal;
+    memcpy(&retVal, &w, sizeof(T));
+
     if (DTRACE(FaultInjection)) {
       std::cout << "HEX:Value before FI: " << type_to_hex(in) << "\n";
+      std::cout << "HEX:Value after FI: " << type_to_hex(retVal) << "\n";
     }
-    switch (type)
-      {
-      case (InjectedFault::ImmediateValue) :
-	{
-	  if (DTRACE(FaultInjection)) {
-	    std::cout <<  "\tImmediate Value\n";
-	    std::cout << "Value before FI: " << in << "\n";
-	  }
-	  retVal = IMMD(in, out);
-	  if (DTRACE(FaultInjection)) {
-	    std::cout << "Value after FI: " << retVal << "\n";
-	  }
-	  break;
-	}
-      case (InjectedFault::MaskValue) :
-	{
-	  if (DTRACE(FaultInjection)) {
-	    std::cout <<  "\t\tMask Value\n";
-	    std::cout << "\t\tValue before FI: " << in << "\n";
-	  }
-	  retVal =XOR(in, out);
-	  if (DTRACE(FaultInjection)) {
-	    std::cout << "\t\tValue after FI: " << retVal << "\n";
-	  }
-	  break;
-	}
-      case (InjectedFault::FlipBit) :
-	{
-	  if (DTRACE(FaultInjection)) {
-	    std::cout <<  "\t\tFlipBit Value\n";
-	    std::cout << "\t\tValue before FI: " << in << "\n";
-	  }
-	  retVal = FLIP(in, out);
-	  if (DTRACE(FaultInjection)) {
-	    std::cout << "\t\tValue after FI: " << retVal << "\n";
-	  }
-	  break;
-	}
-      case (InjectedFault::AllValue) :
-	{
-	  if (DTRACE(FaultInjection)) {
-	    std::cout <<  "\t\tAll Value\n";
-	    std::cout << "\t\tValue before FI: " << in << "\n";
-	  }
-	  retVal = ALL(in, out);
-	  if (DTRACE(FaultInjection)) {
-	    std::cout << "\t\tValue after FI: " << retVal << "\n";
-	  }
-	  break;
-	}
-      default:
-	{
-	   retVal = in;
-	  std::cout << "InjectedFault::manifest -- InjectedFaultValueType Error\n";
-	  assert(0);
-	  break;
-	}
-      }
-    if (DTRACE(FaultInjection)) {
-	std::cout << "HEX:Value after FI: " << type_to_hex(retVal) << "\n";
-    }  
     return retVal;
   }
   
@@ -431,14 +293,22 @@ public:
   getValueType() const { return _valueType;}
   uint64_t
   getValue() const { return _value;}
+  uint64_t
+  getAndMask() const { return _andMask;}
+  uint64_t
+  getXorMask() const { return _xorMask;}
   std::string
   getWhen() const { return _when;}
   std::string
   getWhere() const { return _where;}
+  int
+  getWhereId() const { return _whereId;}
   std::string
   getWhat() const { return _what;}
   std::string
   getThread() const {return _thread;}
+  int
+  getThreadId() const {return _threadId;}
   InjectedFaultQueue *
   getQueue() const {return _queue;}
 
@@ -450,23 +320,99 @@ public:
 
 
 
+/*
+ * Orders faults by their timing value. The fault id breaks the ties so
+ * faults with the same timing are serviced in the order they were read.
+ */
+struct InjectedFaultTimingOrder
+{
+  bool
+  operator()(const InjectedFault *a, const InjectedFault *b) const
+  {
+    if (a->getTiming() != b->getTiming())
+      return a->getTiming() < b->getTiming();
+    return a->getFaultID() < b->getFaultID();
+  }
+};
+
+/*
+ * All the Tick or Inst timed faults of a queue that share the same
+ * core/thread scope. They all compare against the same counter so only
+ * the earliest one has to be checked, the rest can not be due before it.
+ */
+class InjectedFaultTrigger
+{
+public:
+  uint16_t timingType; // InjectedFault::TickTiming or InstructionTiming
+  int where;           // core id or -1 for all cores
+  int thread;          // thread id or -1 for all threads
+
+  std::set<InjectedFault *, InjectedFaultTimingOrder> pending;
+
+  InjectedFaultTrigger(uint16_t t, int w, int th)
+    : timingType(t), where(w), thread(th)
+  {}
+
+  bool
+  covers(int curCpu, int threadId) const
+  {
+    return (thread == -1 || thread == threadId) &&
+      (where == -1 || where == curCpu);
+  }
+
+  InjectedFault *next() const { return *pending.begin(); }
+};
+
 class InjectedFaultQueue : public Serializable
 {
   friend class ThreadEnabledFault;
+  friend class InjectedFault;
+  friend class Fi_System;
+public:
+  //Pipeline stage that the queue is scanned from, selects which counters are compared
+  typedef uint16_t QueueStage;
+  static const QueueStage MainStage   = 0;
+  static const QueueStage FetchStage  = 1;
+  static const QueueStage DecodeStage = 2;
+  static const QueueStage IEWStage    = 3;
+
 private:
   /* Name of the Queue
    */
   std::string objName;
-  
-protected:
-   /*Pointers at the beginning and end of the list (NULL if the list is empty)
+  QueueStage stage;
+
+  /*
+   * Tick and Inst timed faults grouped by scope, every group is
+   * ordered by timing (the first element is the next threshold).
    */
-  
+  std::vector<InjectedFaultTrigger *> triggers;
+
+  /*
+   * Addr timed faults keyed by their offset from the magic instruction
+   * so a single lookup per instruction is needed.
+   */
+  typedef m5::hash_map<Addr, std::vector<InjectedFault *> > AddrTriggerMap;
+  AddrTriggerMap addrTriggers;
+
+  /*
+   * Watermarks on the Fi_System clocks (instruction events and ticks of
+   * all threads), no fault of the queue can be due before one of the
+   * clocks reaches its mark. Set by Fi_System::update_marks(), cleared
+   * whenever the queue changes. pcLow/pcHigh bound the Addr trigger offsets.
+   */
+  uint64_t instMark;
+  uint64_t tickMark;
+  Addr pcLow;
+  Addr pcHigh;
+
+  void invalidateMarks() { instMark = 0; tickMark = 0; }
+
+  InjectedFaultTrigger *findTrigger(InjectedFault *f, bool create);
+  void index(InjectedFault *f);
+  bool unindex(InjectedFault *f);
+  void retime(InjectedFault *f, uint64_t timing);
 
-  
- 
-   
-    
 public:
   InjectedFault *head;
   InjectedFault *tail;
@@ -481,7 +427,8 @@ public:
   virtual const std::string name() const { return objName; }
 
   /* Inserts the given fault into the queue
-   * The faults are entered in a ascending order based on their timing value, however, we do not make any distiction betweent different timing types (maybe in a later version)
+   * The list keeps the faults in an ascending order based on their timing value,
+   * scan() uses the per scope trigger index instead of the list.
    */
   void insert(InjectedFault *fault);
 
@@ -489,20 +436,39 @@ public:
    */
   void remove(InjectedFault *fault);
 
-  void setName(string v){
-    objName=v;
+  /* true if the fault is still linked in this queue
+   */
+  bool contains(InjectedFault *fault);
+
+  void setName(string v);
+  QueueStage getStage() const { return stage; }
+
+  /* true if no Tick/Inst timed fault can be due at these clocks
+   */
+  bool
+  quiet(uint64_t instClock, uint64_t tickClock) const
+  {
+    return instClock < instMark && tickClock < tickMark;
+  }
+
+  bool hasAddrTriggers() const { return !addrTriggers.empty(); }
+
+  /* true if no Addr timed fault exists at this offset from the magic instruction
+   */
+  bool
+  addrQuiet(Addr pcOffset) const
+  {
+    return pcOffset < pcLow || pcOffset > pcHigh;
   }
 
   void setHead(InjectedFault* p) {head=p;}
   void setTail(InjectedFault* p) {tail=p;}
   /* Scan the specific queue to find if any fault matches the provided criteria
-   * s: injected module name
+   * s: id of the injected core
    * thisThread: the current thread/application
    * vaddr: current PC address
    */
-  virtual InjectedFault *scan(std::string s , ThreadEnabledFault &thisThread , Addr vaddr);
-  //virtual InjectedFault * scan(std::string s, int64_t t, uint64_t instCnt, Addr vaddr);
-  //virtual InjectedFault * scan(std::string s, int64_t t, uint64_t instCnt, Addr vaddr , ThreadEnabledFault &thisThread);
+  virtual InjectedFault *scan(int s , ThreadEnabledFault &thisThread , Addr vaddr);
 
 
   
@@ -514,6 +480,13 @@ public:
   /* Dump the contents of the queue
    */
   void dump() const;
+
+  /* The pending faults are saved by their position in the fault file
+   * together with the state that changes while they manifest.
+   * unserialize() deletes the faults that were no longer pending.
+   */
+  virtual void serialize(std::ostream &os);
+  virtual void unserialize(Checkpoint *cp, const std::string &section);
 };
 
 
@@ -3,22 +3,35 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "cpu/o3/cpu.hh"
 #include "cpu/base.hh"
 
+#include "fi/addr_trigger.hh"
 #include "fi/faultq.hh"
 #include "fi/cpu_threadInfo.hh"
+#include "fi/crash_event.hh"
 #include "fi/fi_system.hh"
 #include "fi/o3cpu_injfault.hh"
 #include "fi/cpu_injfault.hh"
 #include "fi/genfetch_injfault.hh"
 #include "fi/iew_injfault.hh"
 #include "fi/mem_injfault.hh"
+#include "fi/o3struct_injfault.hh"
 #include "fi/opcode_injfault.hh"
 #include "fi/pc_injfault.hh"
 #include "fi/regdec_injfault.hh"
 #include "fi/reg_injfault.hh"
+#include "fi/reg_liveness.hh"
 
 
 
@@ -26,8 +39,18 @@
 #include "base/types.hh"
 #include "arch/types.hh"
 #include "base/trace.hh"
+#include "base/cprintf.hh"
+#include "base/callback.hh"
+#include "base/output.hh"
+#include "fi/lockstep.hh"
+#include "fi/reg_injfault.hh"
+#include "sim/core.hh"
+#include "sim/sim_exit.hh"
+#include "sim/full_system.hh"
+#include "sim/system.hh"
 
 #include "mem/mem_object.hh"
+#include "mem/physical.hh"
 
 
 using namespace std;
@@ -37,14 +60,34 @@ using namespace std;
 Fi_System *fi_system;
 
 Fi_System::Fi_System(Params *p)
-  :MemObject(p)
+  :MemObject(p), hangEvent(this)
 {
   std:: stringstream s1;
   in_name = p->input_fi;
   setcheck(p->check_before_init);
   vectorpos = 0;
+  instClock = 0;
+  tickClock = 0;
+
+  campaign = p->campaign;
+  campaignChild = false;
+  maxChildren = std::max(p->max_children, 1);
+  campaignResults = p->campaign_results;
+  campaignFaultId = 0;
+  campaignForkTick = 0;
+  exitCode = 0;
+  tokenFds[0] = tokenFds[1] = -1;
+  if (campaign) {
+    open_tokens();
+    registerExitCallback(new MakeCallback<Fi_System, &Fi_System::campaign_exit>(this));
+  }
   
   fi_system = this;
+
+  //the Addr triggers of the faults read below are armed once there is a system
+  pcQueue = NULL;
+  addrHitTc = NULL;
+  addrHitPc = 0;
   
   mainInjectedFaultQueue.setName("MainFaultQueue");
   mainInjectedFaultQueue.setHead(NULL);
@@ -58,16 +101,91 @@ Fi_System::Fi_System(Params *p)
   iewStageInjectedFaultQueue.setName("IEWStageFaultQueue");
   iewStageInjectedFaultQueue.setHead(NULL);
   iewStageInjectedFaultQueue.setTail(NULL);
+  o3StructInjectedFaultQueue.setName("O3StructFaultQueue");
+  o3StructInjectedFaultQueue.setHead(NULL);
+  o3StructInjectedFaultQueue.setTail(NULL);
   
   
 
-  if(in_name.size() > 1){
-    input.open (in_name.c_str(), ifstream::in);
-    getFromFile(input);
-    input.close();
+  instWindow = p->inst_window;
+  tickWindow = p->tick_window;
+  load_faults();
+
+  digestInterval = p->digest_interval;
+  nextDigest = digestInterval ? digestInterval : (uint64_t)-1;
+  digestPoint = 0;
+  faultsApplied = 0;
+  recordDigests = digestInterval && p->record_digests;
+  if (recordDigests) {
+    string out = simout.resolve(p->golden_digests.empty() ? "fi_digests.txt" : p->golden_digests);
+    digestOut.open(out.c_str());
+    if (!digestOut)
+      fatal("Fi_System: unable to open %s\n", out);
   }
+  else if (digestInterval && !p->golden_digests.empty())
+    load_golden_digests(p->golden_digests);
 
-  
+  snapshotInterval = p->snapshot_interval;
+  maxSnapshots = std::max(p->max_snapshots, 1);
+  snapshotBudget = p->snapshot_budget;
+  snapshotSpill = p->snapshot_spill;
+  if (snapshotInterval && !campaign && !snapshotSpill) {
+    warn("Fi_System: snapshots are only taken by a campaign or spilled to checkpoints\n");
+    snapshotInterval = 0;
+  }
+  ladder = snapshotInterval && campaign && !snapshotSpill;
+  nextSnapshot = snapshotInterval ? 0 : (uint64_t)-1;
+
+  autoSwitch = p->auto_switch;
+  detailed = false;
+  switchWarmup = p->switch_warmup;
+  switchWarmupTicks = p->switch_warmup_ticks;
+  switchInstMark = autoSwitch ? 0 : (uint64_t)-1;
+  switchTickMark = (uint64_t)-1;
+
+  maxLanes = campaign ? std::max(p->lockstep_lanes, 0) : 0;
+  probing = false;
+
+  memUses = p->mem_uses;
+  if (!memUses.empty()) {
+    string out = simout.resolve(memUses);
+    memUsesOut.open(out.c_str());
+    if (!memUsesOut)
+      fatal("Fi_System: unable to open %s\n", out);
+    registerExitCallback(new MakeCallback<Fi_System, &Fi_System::mem_uses_exit>(this));
+  }
+
+  memTimeline = p->mem_timeline;
+  recordTimeline = !memTimeline.empty() && p->record_mem_timeline;
+  if (recordTimeline)
+    registerExitCallback(new MakeCallback<Fi_System, &Fi_System::write_timelines>(this));
+
+  liveness = NULL;
+  livenessProfile = p->liveness_profile;
+  if (!livenessProfile.empty()) {
+    liveness = new RegLiveness;
+    registerExitCallback(new MakeCallback<Fi_System, &Fi_System::write_liveness>(this));
+  }
+
+  goldenTotals = p->golden_totals;
+  recordTotals = p->record_golden_totals;
+  goldenEndTick = 0;
+  hangFactor = p->hang_factor;
+  if (recordTotals)
+    registerExitCallback(new MakeCallback<Fi_System, &Fi_System::write_golden_totals>(this));
+  else if (hangFactor > 0 && !goldenTotals.empty())
+    load_golden_totals(goldenTotals);
+  watchInterval = p->watch_interval;
+  loopSamples = std::max(p->loop_samples, 0);
+  loopWindow = std::max(p->loop_window, 1);
+  loopBurst = false;
+  nextWatch = watchInterval && ((hangFactor > 0 && !threadTotals.empty()) || loopSamples) ?
+    watchInterval : (uint64_t)-1;
+  crashSymbols = p->crash_symbols;
+  runEnded = false;
+  outcomeFile = p->outcome;
+  if (!campaign && !outcomeFile.empty())
+    registerExitCallback(new MakeCallback<Fi_System, &Fi_System::outcome_exit>(this));
 }
 Fi_System::~Fi_System(){
   
@@ -79,6 +197,21 @@ Fi_System::init()
   if (DTRACE(FaultInjection)) {
     std::cout << "Fi_System:init()\n";
   }
+
+  //give every core its id before any thread starts counting
+  //(or is restored from a checkpoint)
+  for (size_t i = 0; i < BaseCPU::cpuList.size(); i++) {
+    BaseCPU *cpu = BaseCPU::cpuList[i];
+    int id = get_core_id(cpu->name());
+    cpu->setFiCoreId(id);
+    if (coreCpus.size() <= (size_t)id)
+      coreCpus.resize(id + 1, NULL);
+    coreCpus[id] = cpu;
+  }
+
+  //fault injection runs a single system, the Addr triggers go to its queue
+  if (!System::systemList.empty())
+    pcQueue = &System::systemList[0]->pcEventQueue;
 }
 
 
@@ -119,6 +252,12 @@ Fi_System:: dump(){
 	    p->dump();
 	    p=p->nxt;
     }
+
+    p=o3StructInjectedFaultQueue.head;
+    while(p){
+	    p->dump();
+	    p=p->nxt;
+    }
    std::cout <<"~===Fi_System::dump()===\n"; 
   }
   
@@ -132,9 +271,203 @@ Fi_System::startup()
   if (DTRACE(FaultInjection)) {
     std::cout << "Fi_System:startup()\n";
   }
+
+  //the contexts may run a thread restored from a checkpoint
+  update_fi_threads();
+
+  if (recordTimeline) {
+    std::vector<AbstractMemory *> mems;
+    find_memories(mems);
+    for (size_t i = 0; i < mems.size(); i++) {
+      MemTimeline t = { mems[i], new AccessTimeline, 0 };
+      mems[i]->setTimeline(t.timeline);
+      memTimelines.push_back(t);
+    }
+  }
+  else if (!memTimeline.empty()) {
+    if (autoSwitch)
+      warn("Fi_System: the memory timelines do not follow the detailed cpus, they are not used\n");
+    else
+      load_timelines();
+  }
+
+  //the deadline of the watchdog, from where this run starts
+  if (hangFactor > 0 && goldenEndTick > curTick() && !hangEvent.scheduled())
+    schedule(hangEvent, curTick() + (Tick)(hangFactor * (goldenEndTick - curTick())));
+
+  //the kernel is loaded by now, the crash functions are found past their prologue
+  System *sys = System::systemList.empty() ? NULL : System::systemList[0];
+  if (FullSystem && sys && sys->kernelSymtab && crashEvents.empty()) {
+    for (size_t i = 0; i < crashSymbols.size(); i++) {
+      CrashEvent *e = sys->addKernelFuncEvent<CrashEvent>(crashSymbols[i].c_str());
+      if (e)
+	crashEvents.push_back(e);
+      else
+	warn("Fi_System: no kernel symbol %s to detect crashes with\n", crashSymbols[i]);
+    }
+  }
   dump();
 }
 
+void
+Fi_System::serialize(std::ostream &os)
+{
+  std::vector<Addr> fi_activation_pcb;
+  std::vector<int> fi_activation_pos;
+  for (fi_activation_iter = fi_activation.begin(); fi_activation_iter != fi_activation.end(); ++fi_activation_iter) {
+    fi_activation_pcb.push_back(fi_activation_iter->first);
+    fi_activation_pos.push_back(fi_activation_iter->second);
+  }
+  int numThreads = threadList.size();
+
+  paramOut(os, "input_fi", in_name);
+  SERIALIZE_SCALAR(vectorpos);
+  SERIALIZE_SCALAR(instClock);
+  SERIALIZE_SCALAR(tickClock);
+  SERIALIZE_SCALAR(numThreads);
+  SERIALIZE_SCALAR(nextInstRecord);
+  SERIALIZE_SCALAR(nextTickRecord);
+  arrayParamOut(os, "fi_activation_pcb", fi_activation_pcb);
+  arrayParamOut(os, "fi_activation_pos", fi_activation_pos);
+
+  for (int i = 0; i < numThreads; i++) {
+    nameOut(os, csprintf("%s.thread%d", name(), i));
+    threadList[i]->serialize(os);
+  }
+
+  nameOut(os, csprintf("%s.%s", name(), mainInjectedFaultQueue.name()));
+  mainInjectedFaultQueue.serialize(os);
+  nameOut(os, csprintf("%s.%s", name(), fetchStageInjectedFaultQueue.name()));
+  fetchStageInjectedFaultQueue.serialize(os);
+  nameOut(os, csprintf("%s.%s", name(), decodeStageInjectedFaultQueue.name()));
+  decodeStageInjectedFaultQueue.serialize(os);
+  nameOut(os, csprintf("%s.%s", name(), iewStageInjectedFaultQueue.name()));
+  iewStageInjectedFaultQueue.serialize(os);
+  nameOut(os, csprintf("%s.%s", name(), o3StructInjectedFaultQueue.name()));
+  o3StructInjectedFaultQueue.serialize(os);
+}
+
+void
+Fi_System::unserialize(Checkpoint *cp, const std::string &section)
+{
+  std::string cpt_input;
+  std::vector<Addr> fi_activation_pcb;
+  std::vector<int> fi_activation_pos;
+  int numThreads;
+
+  paramIn(cp, section, "input_fi", cpt_input);
+  UNSERIALIZE_SCALAR(vectorpos);
+  UNSERIALIZE_SCALAR(instClock);
+  UNSERIALIZE_SCALAR(tickClock);
+  UNSERIALIZE_SCALAR(numThreads);
+  arrayParamIn(cp, section, "fi_activation_pcb", fi_activation_pcb);
+  arrayParamIn(cp, section, "fi_activation_pos", fi_activation_pos);
+
+  fi_activation.clear();
+  for (size_t i = 0; i < fi_activation_pcb.size(); i++)
+    fi_activation[fi_activation_pcb[i]] = fi_activation_pos[i];
+
+  clear_addr_events();
+  for (size_t i = 0; i < threadList.size(); i++)
+    delete threadList[i];
+  threadList.clear();
+  for (int i = 0; i < numThreads; i++) {
+    ThreadEnabledFault *thread = new ThreadEnabledFault(0);
+    thread->unserialize(cp, csprintf("%s.thread%d", section, i));
+    threadList.push_back(thread);
+  }
+
+  if (cpt_input.compare(in_name) == 0) {
+    //create every fault of the list the checkpointed run had created
+    if (faultList.isOpen()) {
+      uint64_t instUntil, tickUntil;
+      paramIn(cp, section, "nextInstRecord", instUntil);
+      paramIn(cp, section, "nextTickRecord", tickUntil);
+      load_records(instUntil, tickUntil);
+    }
+    mainInjectedFaultQueue.unserialize(cp, csprintf("%s.%s", section, mainInjectedFaultQueue.name()));
+    fetchStageInjectedFaultQueue.unserialize(cp, csprintf("%s.%s", section, fetchStageInjectedFaultQueue.name()));
+    decodeStageInjectedFaultQueue.unserialize(cp, csprintf("%s.%s", section, decodeStageInjectedFaultQueue.name()));
+    iewStageInjectedFaultQueue.unserialize(cp, csprintf("%s.%s", section, iewStageInjectedFaultQueue.name()));
+    //checkpoints from before the structure faults do not have their queue
+    string structSection = csprintf("%s.%s", section, o3StructInjectedFaultQueue.name());
+    if (cp->sectionExists(structSection))
+      o3StructInjectedFaultQueue.unserialize(cp, structSection);
+  }
+  else {
+    inform("Fi_System: checkpoint taken with fault file '%s', keeping the faults of '%s'\n",
+	   cpt_input, in_name);
+  }
+  invalidate_marks();
+
+  for (fi_activation_iter = fi_activation.begin(); fi_activation_iter != fi_activation.end(); ++fi_activation_iter)
+    if (fi_activation_iter->second != -1)
+      rebase_addr_events(threadList[fi_activation_iter->second]);
+
+  //the digest points follow the restored clock
+  if (digestInterval) {
+    digestPoint = instClock / digestInterval;
+    nextDigest = (digestPoint + 1) * digestInterval;
+  }
+}
+
+void
+Fi_System::regStats()
+{
+  MemObject::regStats();
+
+  hooksSkipped
+    .name(name() + ".hooks_skipped")
+    .desc("Number of fault injection hooks that skipped the fault queue scan")
+    ;
+
+  hooksScanned
+    .name(name() + ".hooks_scanned")
+    .desc("Number of fault injection hooks that scanned a fault queue")
+    ;
+
+  lanesAdded
+    .name(name() + ".lanes_added")
+    .desc("Number of register faults carried as lockstep lanes")
+    ;
+
+  lanesMasked
+    .name(name() + ".lanes_masked")
+    .desc("Number of lockstep lanes that converged with the golden run")
+    ;
+
+  lanesSplit
+    .name(name() + ".lanes_split")
+    .desc("Number of lockstep lanes forked off once they diverged")
+    ;
+
+  memFaultsPruned
+    .name(name() + ".mem_faults_pruned")
+    .desc("Number of memory faults the timelines show are masked, not forked")
+    ;
+
+  structFaultsPruned
+    .name(name() + ".struct_faults_pruned")
+    .desc("Number of core structure faults on empty entries, not forked")
+    ;
+}
+
+int
+Fi_System::get_core_id(const std::string &name)
+{
+  if (name.compare("all") == 0)
+    return ThreadEnabledFault::AllCores;
+
+  std::map<std::string, int>::iterator it = coreIds.find(name);
+  if (it != coreIds.end())
+    return it->second;
+
+  int id = coreNames.size();
+  coreIds[name] = id;
+  coreNames.push_back(name);
+  return id;
+}
+
 
 Fi_System *
 Fi_SystemParams::create()
@@ -152,63 +485,1334 @@ Fi_System::getPort(const string &if_name, int idx)
   panic("No Such Port\n");
 }
 
+ThreadEnabledFault *
+Fi_System::get_fi_thread(Addr pcb)
+{
+  std::map<Addr, int>::iterator it = fi_activation.find(pcb);
+  if (it == fi_activation.end() || it->second == -1)
+    return NULL;
+  return threadList[it->second];
+}
+
+void
+Fi_System::arm_addr_event(ThreadEnabledFault *thread, Addr offset)
+{
+  if (!pcQueue || thread->getMagicInstVirtualAddr() == (Addr)-1)
+    return;
+  AddrTriggerEvent *&ev = addrEvents[std::make_pair(thread, offset)];
+  if (!ev)
+    ev = new AddrTriggerEvent(pcQueue, thread, thread->getMagicInstVirtualAddr() + offset);
+}
+
+void
+Fi_System::disarm_addr_events(ThreadEnabledFault *thread)
+{
+  AddrEventMap::iterator it = addrEvents.lower_bound(std::make_pair(thread, (Addr)0));
+  while (it != addrEvents.end() && it->first.first == thread) {
+    delete it->second;
+    addrEvents.erase(it++);
+  }
+  if (addrHitTc && addrHitTc->getFiThread() == thread)
+    addrHitTc = NULL;
+}
+
+void
+Fi_System::add_addr_offset(Addr offset)
+{
+  if (addrOffsets[offset]++)
+    return;
+  for (fi_activation_iter = fi_activation.begin(); fi_activation_iter != fi_activation.end(); ++fi_activation_iter)
+    if (fi_activation_iter->second != -1)
+      arm_addr_event(threadList[fi_activation_iter->second], offset);
+}
+
+void
+Fi_System::remove_addr_offset(Addr offset)
+{
+  std::map<Addr, int>::iterator o = addrOffsets.find(offset);
+  assert(o != addrOffsets.end());
+  if (--o->second)
+    return;
+  addrOffsets.erase(o);
+
+  for (size_t i = 0; i < threadList.size(); i++) {
+    AddrEventMap::iterator it = addrEvents.find(std::make_pair(threadList[i], offset));
+    if (it != addrEvents.end()) {
+      delete it->second;
+      addrEvents.erase(it);
+    }
+  }
+}
+
+void
+Fi_System::rebase_addr_events(ThreadEnabledFault *thread)
+{
+  disarm_addr_events(thread);
+  for (std::map<Addr, int>::iterator o = addrOffsets.begin(); o != addrOffsets.end(); ++o)
+    arm_addr_event(thread, o->first);
+}
+
+void
+Fi_System::clear_addr_events()
+{
+  for (AddrEventMap::iterator it = addrEvents.begin(); it != addrEvents.end(); ++it)
+    delete it->second;
+  addrEvents.clear();
+  addrHitTc = NULL;
+}
+
+void
+Fi_System::invalidate_marks()
+{
+  //the watermarks may move closer, look at the window again
+  if (autoSwitch)
+    switchInstMark = 0;
+  mainInjectedFaultQueue.invalidateMarks();
+  fetchStageInjectedFaultQueue.invalidateMarks();
+  decodeStageInjectedFaultQueue.invalidateMarks();
+  iewStageInjectedFaultQueue.invalidateMarks();
+  o3StructInjectedFaultQueue.invalidateMarks();
+}
+
+//The earliest a fault of a trigger can be due is after as many clock events
+//as its threshold is ahead of the largest counter that an active thread has for its scope.
+void
+Fi_System::update_marks(InjectedFaultQueue &q)
+{
+  const uint64_t never = (uint64_t)-1;
+  uint64_t instSlack = never;
+  uint64_t tickSlack = never;
+  uint64_t instr, time;
+
+  for (size_t i = 0; i < q.triggers.size(); i++) {
+    InjectedFaultTrigger *t = q.triggers[i];
+    if (t->pending.empty())
+      continue;
+
+    uint64_t counter = 0;
+    for (fi_activation_iter = fi_activation.begin(); fi_activation_iter != fi_activation.end(); ++fi_activation_iter) {
+      if (fi_activation_iter->second == -1)
+	continue;
+      ThreadEnabledFault *thread = threadList[fi_activation_iter->second];
+      if (t->thread != -1 && t->thread != thread->getThreaId())
+	continue;
+      get_fi_counters(q.getStage(), t->where, t->thread, *thread, t->where, &instr, &time);
+      counter = std::max(counter, t->timingType == InjectedFault::TickTiming ? time : instr);
+      if (t->thread == -1) //the same for every thread
+	break;
+    }
+
+    uint64_t timing = t->next()->getTiming();
+    uint64_t slack = (timing > counter) ? timing - counter : 0;
+    if (t->timingType == InjectedFault::TickTiming)
+      tickSlack = std::min(tickSlack, slack);
+    else
+      instSlack = std::min(instSlack, slack);
+  }
+
+  q.instMark = (instSlack > never - instClock) ? never : instClock + instSlack;
+  q.tickMark = (tickSlack > never - tickClock) ? never : tickClock + tickSlack;
+}
+
+void
+Fi_System::update_fi_threads()
+{
+  invalidate_marks();
+  for (size_t i = 0; i < BaseCPU::cpuList.size(); i++) {
+    BaseCPU *cpu = BaseCPU::cpuList[i];
+    for (ThreadID tid = 0; tid < cpu->numThreads; tid++) {
+      ThreadContext *tc = cpu->getContext(tid);
+      update_fi_thread(tc, tc->readMiscRegNoEffect(AlphaISA::IPR_PALtemp23));
+    }
+  }
+}
+
+//The golden run takes the fault out of its queue and leaves it to a child.
+//Returns true in the child, which keeps only this fault.
+bool
+Fi_System::fork_experiment(InjectedFault *f)
+{
+  if (campaignChild)
+    return true;
+
+  f->getQueue()->remove(f);
+  if (!fork_child(f->getFaultID() - faultBase, curTick()))
+    return false;
+  f->getQueue()->insert(f);
+  return true;
+}
+
+//forks the experiment of fault id, true in the child which drops every
+//other fault
+bool
+Fi_System::fork_child(uint64_t id, Tick forkTick)
+{
+  take_token();
+
+  std::cout.flush();
+  std::cerr.flush();
+  digestOut.flush();
+  fflush(NULL);
+
+  pid_t pid = fork();
+  if (pid == -1)
+    fatal("Fi_System: unable to fork the experiment of fault %d: %s\n",
+	  id, strerror(errno));
+  if (pid > 0) {
+    children.insert(pid);
+    experiments.insert(pid);
+    return false;
+  }
+
+  become_experiment(id);
+  campaignForkTick = forkTick;
+  drop_faults();
+  faultList.close();
+  lazyInstMark = (uint64_t)-1;
+  lazyTickMark = (uint64_t)-1;
+  return true;
+}
+
+//This process now runs the experiment of the fault with the given id
+//A transient register fault that hits an atomic cpu with a free lane is
+//carried by it instead of forking its experiment now
+bool
+Fi_System::add_lane(InjectedFault *f)
+{
+  if (f->getFaultType() != InjectedFault::RegisterInjectedFault)
+    return false;
+  RegisterInjectedFault *rf = reinterpret_cast<RegisterInjectedFault *>(f);
+  LockstepLanes *lanes = rf->getCPU()->getLanes();
+  if (!lanes || (int)lanes->size() >= maxLanes || !lanes->accepts(rf))
+    return false;
+
+  f->getQueue()->remove(f);
+  lanesAdded++;
+  if (lanes->add(rf, f->getFaultID() - faultBase))
+    laneSets.insert(lanes);
+  return true;
+}
+
+bool
+Fi_System::split_lane(uint64_t id, Tick tick)
+{
+  lanesSplit++;
+  if (!fork_child(id, tick))
+    return false;
+  //the experiment carries no lane
+  laneSets.clear();
+  return true;
+}
+
+void
+Fi_System::lane_masked(uint64_t id, Tick tick)
+{
+  lanesMasked++;
+  write_result(id, tick, 0, "fault masked: state converged with the golden run");
+}
+
+//flat liveness index of a register operand, -1 for the zero, pal shadow
+//and misc registers (a fault in a zero register is cleared before any read)
+static int
+liveness_reg(ThreadContext *tc, int idx)
+{
+  if (idx < TheISA::FP_Base_DepTag) {
+    int flat = tc->flattenIntIndex(idx);
+    return (idx == TheISA::ZeroReg || flat >= TheISA::NumIntArchRegs) ? -1 : flat;
+  }
+  if (idx < TheISA::Ctrl_Base_DepTag) {
+    idx -= TheISA::FP_Base_DepTag;
+#if THE_ISA == ALPHA_ISA
+    if (idx == TheISA::ZeroReg)
+      return -1;
+#endif
+    return TheISA::NumIntArchRegs + tc->flattenFloatIndex(idx);
+  }
+  return -1;
+}
+
+//The accesses are stamped on the counters of the four scopes a register
+//fault of this thread may be timed with
+static void
+record_liveness(RegLiveness *liveness, Fi_System *fi, ThreadContext *tc,
+		const RegLiveness::Event *ev, int n)
+{
+  ThreadEnabledFault *thread = tc->getFiThread();
+  int core = tc->getCpuPtr()->fiCoreId();
+  int tid = thread->getThreaId();
+  const int scopes[4][2] = {
+    { tid, core }, { tid, ThreadEnabledFault::AllCores },
+    { -1, core }, { -1, ThreadEnabledFault::AllCores } };
+  uint64_t instr, time;
+
+  for (int i = 0; i < 4; i++) {
+    fi->get_fi_counters(InjectedFaultQueue::MainStage, scopes[i][1], scopes[i][0],
+			*thread, core, &instr, &time);
+    //no fault triggers before the first fetch of its scope
+    if (instr)
+      liveness->record(scopes[i][0], scopes[i][1], core, instr - 1, ev, n);
+  }
+}
+
+void
+Fi_System::profile_regs(ThreadContext *tc, const StaticInstPtr &inst, Fault fault)
+{
+  RegLiveness::Event ev[RegLiveness::NumRegs + TheISA::MaxInstDestRegs];
+  int n = 0;
+  int r;
+
+  //pal calls, ipr accesses and pseudo instructions may read any register
+  if (inst->isNonSpeculative() || inst->isSerializing() || inst->isSyscall() ||
+      inst->isIprAccess() || inst->isQuiesce() || inst->isUnverifiable()) {
+    for (r = 0; r < RegLiveness::NumRegs; r++) {
+      ev[n].reg = r;
+      ev[n++].type = RegLiveness::Read;
+    }
+  }
+  else {
+    for (int i = 0; i < inst->numSrcRegs(); i++)
+      if ((r = liveness_reg(tc, inst->srcRegIdx(i))) >= 0) {
+	ev[n].reg = r;
+	ev[n++].type = RegLiveness::Read;
+      }
+  }
+  //a faulting instruction writes no register
+  if (fault == NoFault)
+    for (int i = 0; i < inst->numDestRegs(); i++)
+      if ((r = liveness_reg(tc, inst->destRegIdx(i))) >= 0) {
+	ev[n].reg = r;
+	ev[n++].type = RegLiveness::Write;
+      }
+
+  if (n)
+    record_liveness(liveness, this, tc, ev, n);
+}
+
+void
+Fi_System::profile_pc(ThreadContext *tc, Addr pc)
+{
+  if (!AddrTriggerEvent::othersAt(tc->getSystemPtr()->pcEventQueue, pc))
+    return;
+
+  RegLiveness::Event ev[RegLiveness::NumRegs];
+  for (int r = 0; r < RegLiveness::NumRegs; r++) {
+    ev[r].reg = r;
+    ev[r].type = RegLiveness::Read;
+  }
+  record_liveness(liveness, this, tc, ev, RegLiveness::NumRegs);
+}
+
+void
+Fi_System::write_liveness()
+{
+  if (!liveness)
+    return;
+  string out = simout.resolve(livenessProfile);
+  liveness->write(out, coreNames);
+  if (DTRACE(FaultInjection))
+    std::cout << "Fi_System: " << liveness->numEvents() << " register accesses profiled to " << out << "\n";
+}
+
+/*
+ * "M5FIMTL1", then for every memory its name, a zero, the number of
+ * accesses it served (64 bit) and its timeline.
+ */
+void
+Fi_System::write_timelines()
+{
+  if (!recordTimeline)
+    return;
+  string out = simout.resolve(memTimeline);
+  ofstream f(out.c_str(), ios::binary);
+  if (!f)
+    fatal("Fi_System: unable to open %s\n", out);
+  f.write("M5FIMTL1", 8);
+  for (size_t i = 0; i < memTimelines.size(); i++) {
+    MemTimeline &t = memTimelines[i];
+    uint64_t accesses = t.mem->getAccessSeq();
+    f.write(t.mem->name().c_str(), t.mem->name().size() + 1);
+    f.write((const char *)&accesses, sizeof(accesses));
+    t.timeline->write(f);
+    if (DTRACE(FaultInjection))
+      std::cout << "Fi_System: " << t.mem->name() << " timeline of " << t.timeline->numLines()
+		<< " lines, " << t.timeline->numRuns() << " runs\n";
+    t.mem->setTimeline(NULL);
+  }
+}
+
+void
+Fi_System::load_timelines()
+{
+  ifstream f(memTimeline.c_str(), ios::binary);
+  char magic[8];
+  if (!f || !f.read(magic, 8) || memcmp(magic, "M5FIMTL1", 8))
+    fatal("Fi_System: %s is not a memory timeline file\n", memTimeline);
+
+  std::vector<AbstractMemory *> mems;
+  find_memories(mems);
+  string name;
+  while (getline(f, name, '\0')) {
+    MemTimeline t = { NULL, new AccessTimeline, 0 };
+    f.read((char *)&t.accesses, sizeof(t.accesses));
+    t.timeline->read(f);
+    for (size_t i = 0; i < mems.size(); i++)
+      if (mems[i]->name() == name)
+	t.mem = mems[i];
+    if (!t.mem) {
+      warn("Fi_System: no memory %s for its timeline\n", name);
+      delete t.timeline;
+      continue;
+    }
+    memTimelines.push_back(t);
+  }
+}
+
+//A transient memory fault whose byte is written, or not read any more,
+//before it is read is masked: its result is written without an experiment
+bool
+Fi_System::mem_fault_masked(InjectedFault *f)
+{
+  if (f->getFaultType() != InjectedFault::MemoryInjectedFault || f->getOccurrence() != 1)
+    return false;
+
+  Addr physical;
+  AbstractMemory *mem = reinterpret_cast<MemoryInjectedFault *>(f)->target(physical);
+  MemTimeline *t = NULL;
+  for (size_t i = 0; mem && i < memTimelines.size(); i++)
+    if (memTimelines[i].mem == mem)
+      t = &memTimelines[i];
+  //past the end of the recorded run nothing is known
+  if (!t || mem->getAccessSeq() >= t->accesses)
+    return false;
+
+  uint64_t stamp = (mem->getAccessSeq() << 1) | 1;
+  if (t->timeline->next(physical - mem->getAddrRange().start, stamp) == AccessTimeline::Read)
+    return false;
+
+  uint64_t id = f->getFaultID() - faultBase;
+  f->getQueue()->remove(f);
+  memFaultsPruned++;
+  if (DTRACE(FaultInjection))
+    std::cout << "Fi_System: memory fault " << id << " is masked in the timeline\n";
+  write_result(id, curTick(), 0, "fault masked: memory byte overwritten or not read again");
+  return true;
+}
+
+//A structure fault on an entry that holds nothing live when it is due is
+//masked, as is one set to a core that is not detailed
+bool
+Fi_System::struct_fault_masked(InjectedFault *f)
+{
+  if (f->getFaultType() != InjectedFault::O3StructInjectedFault || f->getOccurrence() != 1)
+    return false;
+
+  O3StructInjectedFault *k = reinterpret_cast<O3StructInjectedFault *>(f);
+  if (k->occupied())
+    return false;
+
+  uint64_t id = f->getFaultID() - faultBase;
+  bool detailed = dynamic_cast<BaseO3CPU *>(k->getCPU()) != NULL;
+  f->getQueue()->remove(f);
+  structFaultsPruned++;
+  if (DTRACE(FaultInjection))
+    std::cout << "Fi_System: structure fault " << id << " hits an empty entry\n";
+  write_result(id, curTick(), 0, detailed ? "fault masked: empty structure entry" :
+	       "fault not applied: not a detailed cpu");
+  return true;
+}
+
+//The fault leaves its queue unapplied, a memory fault has its byte watched
+void
+Fi_System::observe_fault(InjectedFault *f)
+{
+  uint64_t id = f->getFaultID() - faultBase;
+  f->getQueue()->remove(f);
+  if (f->getFaultType() != InjectedFault::MemoryInjectedFault)
+    return;
+
+  Addr physical;
+  AbstractMemory *mem = reinterpret_cast<MemoryInjectedFault *>(f)->target(physical);
+  if (!mem) {
+    memUsesOut << "fault " << id << " addr none\n";
+    return;
+  }
+  memWatch.insert(make_pair(physical, id));
+  mem->watch(physical, this);
+}
+
+void
+Fi_System::accessed(Addr addr, bool write, uint64_t seq)
+{
+  std::pair<std::multimap<Addr, uint64_t>::iterator, std::multimap<Addr, uint64_t>::iterator> r =
+    memWatch.equal_range(addr);
+  for (std::multimap<Addr, uint64_t>::iterator it = r.first; it != r.second; ++it)
+    memUsesOut << "fault " << it->second << " addr " << addr << " use " << seq
+	       << (write ? " write\n" : " read\n");
+  memWatch.erase(r.first, r.second);
+}
+
+//the bytes never accessed again
+void
+Fi_System::mem_uses_exit()
+{
+  for (std::multimap<Addr, uint64_t>::iterator it = memWatch.begin(); it != memWatch.end(); ++it)
+    memUsesOut << "fault " << it->second << " addr " << it->first << " use none\n";
+  memWatch.clear();
+  memUsesOut.close();
+}
+
+void
+Fi_System::become_experiment(uint64_t id)
+{
+  campaignChild = true;
+  campaignFaultId = id;
+  campaignForkTick = curTick();
+  children.clear();
+  snapshotInterval = 0;
+  nextSnapshot = (uint64_t)-1;
+  ladder = false;
+
+  //everything the child prints goes to its own file
+  string out = simout.resolve(csprintf("fi_experiment.%d.out", campaignFaultId));
+  if (!freopen(out.c_str(), "w", stdout) || !freopen(out.c_str(), "a", stderr))
+    warn("Fi_System: unable to redirect the output to %s\n", out);
+
+  //only the golden run records digests, a child compares against them
+  if (recordDigests) {
+    digestOut.close();
+    recordDigests = false;
+  }
+  //and the liveness of its registers and memories
+  delete liveness;
+  liveness = NULL;
+  if (recordTimeline) {
+    for (size_t i = 0; i < memTimelines.size(); i++)
+      memTimelines[i].mem->setTimeline(NULL);
+    recordTimeline = false;
+  }
+}
+
+void
+Fi_System::reap_children(bool block)
+{
+  int status;
+  pid_t pid;
+
+  while (!children.empty() && (pid = waitpid(-1, &status, block ? 0 : WNOHANG)) > 0) {
+    children.erase(pid);
+    if (experiments.erase(pid))
+      give_token();
+    if (block)
+      break;
+  }
+}
+
+void
+Fi_System::open_tokens()
+{
+  if (pipe(tokenFds) == -1)
+    fatal("Fi_System: unable to create the experiment tokens: %s\n", strerror(errno));
+  fcntl(tokenFds[0], F_SETFL, fcntl(tokenFds[0], F_GETFL) | O_NONBLOCK);
+  for (int i = 0; i < maxChildren; i++)
+    give_token();
+}
+
+//waits for a free token, reaping the experiments of this process meanwhile
+void
+Fi_System::take_token()
+{
+  struct pollfd pfd = { tokenFds[0], POLLIN, 0 };
+  char token;
+  for (;;) {
+    reap_children(false);
+    if (read(tokenFds[0], &token, 1) == 1)
+      return;
+    if (errno != EAGAIN && errno != EINTR)
+      fatal("Fi_System: unable to take an experiment token: %s\n", strerror(errno));
+    poll(&pfd, 1, 10);
+  }
+}
+
+void
+Fi_System::give_token()
+{
+  char token = 0;
+  while (write(tokenFds[1], &token, 1) != 1)
+    if (errno != EINTR)
+      fatal("Fi_System: unable to give an experiment token back: %s\n", strerror(errno));
+}
+
+//the child of a campaign only injects its own fault
+void
+Fi_System::drop_faults()
+{
+  while(!mainInjectedFaultQueue.empty())
+    mainInjectedFaultQueue.remove(mainInjectedFaultQueue.head);
+  while(!fetchStageInjectedFaultQueue.empty())
+    fetchStageInjectedFaultQueue.remove(fetchStageInjectedFaultQueue.head);
+  while(!decodeStageInjectedFaultQueue.empty())
+    decodeStageInjectedFaultQueue.remove(decodeStageInjectedFaultQueue.head);
+  while(!iewStageInjectedFaultQueue.empty())
+    iewStageInjectedFaultQueue.remove(iewStageInjectedFaultQueue.head);
+  while(!o3StructInjectedFaultQueue.empty())
+    o3StructInjectedFaultQueue.remove(o3StructInjectedFaultQueue.head);
+}
+
+//The children append one line each to the results file, the golden run
+//waits for all of them before it exits.
+void
+Fi_System::campaign_exit()
+{
+  if (!campaignChild) {
+    for (std::set<LockstepLanes *>::iterator it = laneSets.begin(); it != laneSets.end(); ++it)
+      (*it)->finish(exitCause, exitCode);
+    //the snapshots exit once they have run the experiments sent to them
+    while (!snapshots.empty())
+      retire_snapshot();
+    while (!children.empty())
+      reap_children(true);
+    return;
+  }
+
+  write_result(campaignFaultId, campaignForkTick, exitCode, exitCause);
+}
+
+void
+Fi_System::write_result(uint64_t id, Tick forkTick, int code, const std::string &cause)
+{
+  string line = csprintf("fault %d fork_tick %d exit_tick %d outcome %s code %d cause \"%s\"\n",
+			 id, forkTick, curTick(), classify(code, cause), code, cause);
+  string results = simout.resolve(campaignResults);
+  int fd = open(results.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0664);
+  if (fd == -1) {
+    warn("Fi_System: unable to open %s: %s\n", results, strerror(errno));
+    return;
+  }
+  //a single append write so lines of different children do not mix
+  if (write(fd, line.data(), line.size()) != (ssize_t)line.size())
+    warn("Fi_System: unable to write to %s\n", results);
+  close(fd);
+}
+
+const char *
+Fi_System::classify(int code, const std::string &cause)
+{
+  if (cause.compare(0, 12, "fault masked") == 0)
+    return "masked";
+  if (cause.compare(0, 17, "fault not applied") == 0)
+    return "not_applied";
+  //the tick limit of the script is a hang the watchdog did not catch
+  if (cause.compare(0, 7, "fi hang") == 0 || cause == "simulate() limit reached")
+    return "hang";
+  if (cause.compare(0, 8, "fi crash") == 0)
+    return "crash";
+  if (code == 0 && (cause == "m5_exit instruction encountered" || cause == "target called exit()"))
+    return "completed";
+  return "error";
+}
+
+//A run outside a campaign that applied faults writes one line with its outcome
+void
+Fi_System::outcome_exit()
+{
+  if (!faultsApplied)
+    return;
+  string out = simout.resolve(outcomeFile);
+  ofstream os(out.c_str());
+  if (!os) {
+    warn("Fi_System: unable to open %s\n", out);
+    return;
+  }
+  ccprintf(os, "outcome %s faults %d exit_tick %d code %d cause \"%s\"\n",
+	   classify(exitCode, exitCause), faultsApplied, curTick(), exitCode, exitCause);
+}
+
+//Golden totals: "end TICK", then one "thread ID insts N ticks T" line per thread
+void
+Fi_System::load_golden_totals(const std::string &path)
+{
+  ifstream in(path.c_str());
+  if (!in)
+    fatal("Fi_System: unable to open the golden totals %s\n", path);
+
+  string key, insts, ticks;
+  int id;
+  uint64_t n, t;
+  if (!(in >> key >> goldenEndTick) || key != "end")
+    fatal("Fi_System: %s does not start with the end tick\n", path);
+  while (in >> key >> id >> insts >> n >> ticks >> t)
+    threadTotals[id] = std::make_pair(n, t);
+}
+
+void
+Fi_System::write_golden_totals()
+{
+  //the experiments forked off the golden run leave its totals alone
+  if (campaignChild)
+    return;
+  string out = simout.resolve(goldenTotals.empty() ? "fi_totals.txt" : goldenTotals);
+  ofstream os(out.c_str());
+  if (!os) {
+    warn("Fi_System: unable to open %s\n", out);
+    return;
+  }
+  ccprintf(os, "end %d\n", curTick());
+  for (size_t i = 0; i < threadList.size(); i++) {
+    const cpuExecutedTicks *c = threadList[i]->getCounters(ThreadEnabledFault::AllCores);
+    ccprintf(os, "thread %d insts %d ticks %d\n", threadList[i]->getThreaId(),
+	     c->getInstrFetched(), c->getTicks());
+  }
+}
+
+//Ends a run that applied a fault once, the exit cause classifies it
+void
+Fi_System::end_run(const std::string &cause)
+{
+  if (runEnded)
+    return;
+  runEnded = true;
+  nextWatch = (uint64_t)-1;
+  if (DTRACE(FaultInjection))
+    std::cout << "Fi_System: " << cause << " @ tick " << curTick() << "\n";
+  exitSimLoop(cause);
+}
+
+void
+Fi_System::hang_deadline()
+{
+  if (faultsApplied)
+    end_run("fi hang: golden ticks exceeded");
+}
+
+void
+Fi_System::guest_crash(ThreadContext *tc, const std::string &symbol)
+{
+  if (faultsApplied)
+    end_run(csprintf("fi crash: %s", symbol));
+}
+
+void
+Fi_System::watch_point(ThreadContext *tc)
+{
+  if (loopBurst) {
+    loop_sample(tc);
+    return;
+  }
+  nextWatch = instClock + watchInterval;
+  if (!faultsApplied || runEnded)
+    return;
+
+  ThreadEnabledFault *thread = tc->getFiThread();
+  int id = thread->getThreaId();
+  std::map<int, std::pair<uint64_t, uint64_t> >::iterator g = threadTotals.find(id);
+  if (hangFactor > 0 && g != threadTotals.end()) {
+    const cpuExecutedTicks *c = thread->getCounters(ThreadEnabledFault::AllCores);
+    if (c->getInstrFetched() > hangFactor * g->second.first) {
+      end_run("fi hang: golden instructions exceeded");
+      return;
+    }
+    if (c->getTicks() > hangFactor * g->second.second) {
+      end_run("fi hang: golden ticks exceeded");
+      return;
+    }
+  }
+
+  if (loopSamples) {
+    //sample the thread at every instruction event until the burst ends
+    loopBurst = true;
+    loopThread = id;
+    loopCommitted = tc->getCpuPtr()->totalInsts();
+    loopBurstEnd = nextWatch;
+    loopFound = false;
+    loopSeen.clear();
+    loopSeen.insert(register_digest(tc));
+    nextWatch = instClock + 1;
+  }
+}
+
+/*
+ * One sample of a loop burst: the pc and registers of the thread after an
+ * instruction committed since the previous sample. Seeing a signature twice
+ * means the thread came back to the same state; the burst ends there, after
+ * loopWindow samples, or at the next watch point if the thread stops running.
+ */
+void
+Fi_System::loop_sample(ThreadContext *tc)
+{
+  nextWatch = instClock + 1;
+  Counter committed = tc->getCpuPtr()->totalInsts();
+  if (tc->getFiThread()->getThreaId() == loopThread && committed != loopCommitted) {
+    loopCommitted = committed;
+    loopFound = !loopSeen.insert(register_digest(tc)).second;
+    if (!loopFound && loopSeen.size() <= (size_t)loopWindow)
+      return;
+  } else if (instClock < loopBurstEnd) {
+    return;
+  }
+
+  loopBurst = false;
+  loopSeen.clear();
+  nextWatch = std::max<uint64_t>(loopBurstEnd, instClock + 1);
+  int &repeats = loopRepeats[loopThread];
+  repeats = loopFound ? repeats + 1 : 0;
+  if (repeats >= loopSamples)
+    end_run("fi hang: tight loop");
+}
+
+//Golden digests, one "point instClock registers memory" line per point
+void
+Fi_System::load_golden_digests(const std::string &path)
+{
+  ifstream in(path.c_str());
+  if (!in)
+    fatal("Fi_System: unable to open the golden digests %s\n", path);
+
+  uint64_t point, clock, regs, mem;
+  while (in >> point >> clock >> regs >> mem)
+    goldenDigests[point] = std::make_pair(regs, mem);
+}
+
+static inline uint64_t
+digest_mix(uint64_t h, uint64_t v)
+{
+  h ^= v + ULL(0x9e3779b97f4a7c15) + (h << 6) + (h >> 2);
+  h ^= h >> 33;
+  h *= ULL(0xff51afd7ed558ccd);
+  return h ^ (h >> 29);
+}
+
+uint64_t
+Fi_System::register_digest(ThreadContext *tc)
+{
+  uint64_t h = digest_mix(0, tc->pcState().instAddr());
+  for (int i = 0; i < TheISA::NumIntArchRegs; i++)
+    h = digest_mix(h, tc->readIntReg(i));
+  for (int i = 0; i < TheISA::NumFloatRegs; i++)
+    h = digest_mix(h, tc->readFloatRegBits(i));
+  return h;
+}
+
+static uint64_t
+page_digest(const uint8_t *page, Addr bytes, Addr index)
+{
+  const uint64_t *w = reinterpret_cast<const uint64_t *>(page);
+  uint64_t h = digest_mix(0, index);
+  for (Addr i = 0; i < bytes / sizeof(uint64_t); i++)
+    h = digest_mix(h, w[i]);
+  return h;
+}
+
+//the memories (with host memory) of the systems of the cores
+void
+Fi_System::find_memories(std::vector<AbstractMemory *> &mems)
+{
+  std::set<AbstractMemory *> seen;
+  for (size_t i = 0; i < coreCpus.size(); i++) {
+    if (!coreCpus[i] || !coreCpus[i]->system)
+      continue;
+    range_map<Addr, AbstractMemory *> *map = coreCpus[i]->system->getPhysMem().getaddrMap();
+    for (range_map<Addr, AbstractMemory *>::iterator m = map->begin(); m != map->end(); ++m)
+      if (m->second->hostAddr() && seen.insert(m->second).second)
+	mems.push_back(m->second);
+  }
+}
+
+//Sum of the page hashes of all memories, only the pages written since the
+//previous point are hashed again
+uint64_t
+Fi_System::memory_digest()
+{
+  if (memDigests.empty()) {
+    std::vector<AbstractMemory *> mems;
+    find_memories(mems);
+    for (size_t i = 0; i < mems.size(); i++) {
+      MemoryDigest d;
+      d.mem = mems[i];
+      d.consumer = d.mem->addDirtyConsumer();
+      d.sum = 0;
+      Addr bytes = d.mem->pageBytes();
+      d.pageHash.resize(d.mem->size() / bytes);
+      for (Addr p = 0; p < d.pageHash.size(); p++) {
+	d.pageHash[p] = page_digest(d.mem->hostAddr() + p * bytes, bytes, p);
+	d.sum += d.pageHash[p];
+      }
+      memDigests.push_back(d);
+    }
+  }
+  else {
+    std::vector<Addr> pages;
+    for (size_t i = 0; i < memDigests.size(); i++) {
+      MemoryDigest &d = memDigests[i];
+      Addr bytes = d.mem->pageBytes();
+      pages.clear();
+      d.mem->getDirty(d.consumer, pages);
+      for (size_t j = 0; j < pages.size(); j++) {
+	uint64_t h = page_digest(d.mem->hostAddr() + pages[j] * bytes, bytes, pages[j]);
+	d.sum += h - d.pageHash[pages[j]];
+	d.pageHash[pages[j]] = h;
+      }
+      d.mem->clearDirty(d.consumer);
+    }
+  }
+
+  uint64_t h = 0;
+  for (size_t i = 0; i < memDigests.size(); i++)
+    h = digest_mix(h, memDigests[i].sum);
+  return h;
+}
+
+//true while a fault is queued or still to be created from the fault list
+bool
+Fi_System::faults_pending()
+{
+  return !mainInjectedFaultQueue.empty() || !fetchStageInjectedFaultQueue.empty() ||
+    !decodeStageInjectedFaultQueue.empty() || !iewStageInjectedFaultQueue.empty() ||
+    !o3StructInjectedFaultQueue.empty() ||
+    (faultList.isOpen() &&
+     (nextInstRecord < faultList.addrRecords() + faultList.instRecords() ||
+      nextTickRecord < faultList.numRecords()));
+}
+
+void
+Fi_System::digest_point(ThreadContext *tc)
+{
+  digestPoint = instClock / digestInterval;
+  nextDigest = (digestPoint + 1) * digestInterval;
+
+  if (!recordDigests && (goldenDigests.empty() || !faultsApplied))
+    return;
+  std::map<uint64_t, std::pair<uint64_t, uint64_t> >::iterator g = goldenDigests.find(digestPoint);
+  if (!recordDigests && g == goldenDigests.end())
+    return;
+
+  uint64_t regs = register_digest(tc);
+  uint64_t mem = memory_digest();
+
+  if (recordDigests) {
+    digestOut << digestPoint << " " << instClock << " " << regs << " " << mem << "\n";
+    return;
+  }
+
+  if (DTRACE(FaultInjection)) {
+    std::cout << "Fi_System::digest_point " << digestPoint << " registers "
+	      << (g->second.first == regs ? "match" : "differ") << " memory "
+	      << (g->second.second == mem ? "match" : "differ") << "\n";
+  }
+  if (g->second.first == regs && g->second.second == mem && !faults_pending())
+    exitSimLoop("fault masked: state converged with the golden run");
+}
+
+//Switches to the detailed cpus when a fault comes within the warm up
+//distance, back to the atomic ones when none is
+void
+Fi_System::switch_point()
+{
+  const uint64_t never = (uint64_t)-1;
+  InjectedFaultQueue *queues[] = { &mainInjectedFaultQueue, &fetchStageInjectedFaultQueue,
+				   &decodeStageInjectedFaultQueue, &iewStageInjectedFaultQueue,
+				   &o3StructInjectedFaultQueue };
+  uint64_t instMark = never, tickMark = never;
+  for (int i = 0; i < 5; i++) {
+    update_marks(*queues[i]);
+    instMark = std::min(instMark, queues[i]->instMark);
+    tickMark = std::min(tickMark, queues[i]->tickMark);
+  }
+  //no fault of the list triggers before the clocks reach its timing
+  if (faultList.isOpen()) {
+    if (nextInstRecord < faultList.addrRecords() + faultList.instRecords())
+      instMark = std::min(instMark, faultList.record(nextInstRecord).timing);
+    if (nextTickRecord < faultList.numRecords())
+      tickMark = std::min(tickMark, faultList.record(nextTickRecord).timing);
+  }
+
+  bool close = instMark - std::min(instMark, switchWarmup) <= instClock ||
+    tickMark - std::min(tickMark, switchWarmupTicks) <= tickClock;
+
+  if (close != detailed) {
+    detailed = close;
+    if (DTRACE(FaultInjection)) {
+      std::cout << "Fi_System::switch_point to " << (detailed ? "detailed" : "atomic")
+		<< " instClock " << instClock << " tickClock " << tickClock << "\n";
+    }
+    exitSimLoop(detailed ? "fi switch detailed" : "fi switch atomic");
+  }
+
+  if (detailed) {
+    //look again once the fault may have triggered
+    switchInstMark = instClock + switchWarmup / 8 + 1;
+    switchTickMark = never;
+  } else {
+    switchInstMark = instMark == never ? never : instMark - std::min(instMark, switchWarmup);
+    switchTickMark = tickMark == never ? never : tickMark - std::min(tickMark, switchWarmupTicks);
+  }
+}
+
+void
+Fi_System::snapshot_point()
+{
+  nextSnapshot = (instClock / snapshotInterval + 1) * snapshotInterval;
+
+  if (snapshotSpill) {
+    //Simulation.py writes the checkpoint and goes on
+    exitSimLoop("fi snapshot");
+    return;
+  }
+
+  if (snapshotMems.empty()) {
+    std::vector<AbstractMemory *> mems;
+    find_memories(mems);
+    for (size_t i = 0; i < mems.size(); i++)
+      snapshotMems.push_back(std::make_pair(mems[i], mems[i]->addDirtyConsumer()));
+  }
+
+  //every live snapshot holds a copy of the pages written since it was taken
+  uint64_t dirty = 0, total = 0, bytes = 0;
+  std::vector<Addr> pages;
+  for (size_t i = 0; i < snapshotMems.size(); i++) {
+    AbstractMemory *mem = snapshotMems[i].first;
+    pages.clear();
+    mem->getDirty(snapshotMems[i].second, pages);
+    mem->clearDirty(snapshotMems[i].second);
+    dirty += pages.size();
+    total += mem->size() / mem->pageBytes();
+    bytes = mem->pageBytes();
+  }
+  for (size_t i = 0; i < snapshots.size(); i++)
+    snapshots[i].dirtyPages = std::min(snapshots[i].dirtyPages + dirty, total);
+
+  reap_children(false);
+  take_snapshot();
+
+  uint64_t copied = 0;
+  for (size_t i = 0; i < snapshots.size(); i++)
+    copied += snapshots[i].dirtyPages * bytes;
+  while (snapshots.size() > 1 &&
+	 ((int)snapshots.size() > maxSnapshots || (snapshotBudget && copied > snapshotBudget))) {
+    copied -= snapshots.front().dirtyPages * bytes;
+    retire_snapshot();
+  }
+}
+
+void
+Fi_System::take_snapshot()
+{
+  int fds[2];
+  if (pipe(fds) == -1) {
+    warn("Fi_System: unable to take a snapshot: %s\n", strerror(errno));
+    return;
+  }
+
+  std::cout.flush();
+  std::cerr.flush();
+  digestOut.flush();
+  fflush(NULL);
+
+  pid_t pid = fork();
+  if (pid == -1) {
+    warn("Fi_System: unable to take a snapshot: %s\n", strerror(errno));
+    close(fds[0]);
+    close(fds[1]);
+    return;
+  }
+  if (pid == 0) {
+    close(fds[1]);
+    for (size_t i = 0; i < snapshots.size(); i++)
+      close(snapshots[i].fd);
+    snapshots.clear();
+    //returns only in the experiments forked from the snapshot
+    serve_snapshot(fds[0]);
+    return;
+  }
+
+  close(fds[0]);
+  Snapshot snap;
+  snap.pid = pid;
+  snap.fd = fds[1];
+  snap.dirtyPages = 0;
+  snapshots.push_back(snap);
+  if (DTRACE(FaultInjection)) {
+    std::cout << "Fi_System::take_snapshot " << pid << " instClock " << instClock
+	      << " snapshots " << snapshots.size() << "\n";
+  }
+}
+
+//A snapshot forks an experiment for every fault id it reads, each id
+//comes with the token of its experiment, and exits at the end of the pipe.
+//It reaps its experiments while it waits so their tokens go back.
+void
+Fi_System::serve_snapshot(int fd)
+{
+  children.clear();
+  experiments.clear();
+  struct pollfd pfd = { fd, POLLIN, 0 };
+  uint64_t id;
+  for (;;) {
+    reap_children(false);
+    if (poll(&pfd, 1, children.empty() ? -1 : 10) <= 0)
+      continue;
+    if (read(fd, &id, sizeof(id)) != sizeof(id))
+      break;
+
+    pid_t pid = fork();
+    if (pid == -1) {
+      warn("Fi_System: unable to fork the experiment of fault %d: %s\n", id, strerror(errno));
+      give_token();
+      continue;
+    }
+    if (pid == 0) {
+      close(fd);
+      become_experiment(id);
+      keep_only_fault(id);
+      return;
+    }
+    children.insert(pid);
+    experiments.insert(pid);
+  }
+  while (!children.empty())
+    reap_children(true);
+  _exit(0);
+}
+
+//the oldest snapshot gets no more faults, it exits once its experiments end
+void
+Fi_System::retire_snapshot()
+{
+  close(snapshots.front().fd);
+  children.insert(snapshots.front().pid);
+  snapshots.pop_front();
+}
+
+void
+Fi_System::dispatch_fault(InjectedFault *f)
+{
+  uint64_t id = f->getFaultID() - faultBase;
+  f->getQueue()->remove(f);
+  //the snapshot forks the experiment with this token
+  take_token();
+  if (write(snapshots.back().fd, &id, sizeof(id)) != sizeof(id)) {
+    warn("Fi_System: unable to send fault %d to its snapshot\n", id);
+    give_token();
+  }
+}
+
+//drop every fault but the one of this experiment, creating it from the
+//fault list if the snapshot had not yet
+void
+Fi_System::keep_only_fault(uint64_t id)
+{
+  InjectedFaultQueue *queues[] = { &mainInjectedFaultQueue, &fetchStageInjectedFaultQueue,
+				   &decodeStageInjectedFaultQueue, &iewStageInjectedFaultQueue,
+				   &o3StructInjectedFaultQueue };
+  for (int i = 0; i < 5; i++) {
+    InjectedFault *p = queues[i]->head;
+    while (p) {
+      InjectedFault *next = p->nxt;
+      if (p->getFaultID() - faultBase != id)
+	queues[i]->remove(p);
+      p = next;
+    }
+  }
+
+  if (faultList.isOpen()) {
+    uint64_t instEnd = faultList.addrRecords() + faultList.instRecords();
+    if ((id >= nextInstRecord && id < instEnd) ||
+	(id >= nextTickRecord && id < faultList.numRecords())) {
+      uint64_t cnt = InjectedFault::faultCnt;
+      InjectedFault::faultCnt = faultBase + id;
+      create_fault(id);
+      InjectedFault::faultCnt = cnt;
+    }
+    faultList.close();
+  }
+  lazyInstMark = (uint64_t)-1;
+  lazyTickMark = (uint64_t)-1;
+  invalidate_marks();
+}
+
 //Initialize faults from a file
 //Note that the conditions of how the faults are
 //stored in a file are very strict.
 
+InjectedFault *
+Fi_System::create_fault(const std::string &type, std::istream &os)
+{
+  InjectedFault *k = NULL;
+
+  if(type.compare("CPUInjectedFault") ==0)
+    k = new CPUInjectedFault(os);
+  else if(type.compare("InjectedFault") ==0)
+    k = new InjectedFault(os);
+  else if(type.compare("GeneralFetchInjectedFault") ==0)
+    k = new GeneralFetchInjectedFault(os);
+  else if(type.compare("IEWStageInjectedFault") ==0)
+    k = new IEWStageInjectedFault(os);
+  else if(type.compare("MemoryInjectedFault") ==0)
+    k = new MemoryInjectedFault(os);
+  else if(type.compare("O3CPUInjectedFault") ==0)
+    k = new O3CPUInjectedFault(os);
+  else if(type.compare("OpCodeInjectedFault") ==0)
+    k = new OpCodeInjectedFault(os);
+  else if(type.compare("PCInjectedFault") ==0)
+    k = new PCInjectedFault(os);
+  else if(type.compare("RegisterInjectedFault") ==0)
+    k = new RegisterInjectedFault(os);
+  else if(type.compare("RegisterDecodingInjectedFault") ==0)
+    k = new RegisterDecodingInjectedFault(os);
+  else if(type.compare("O3StructInjectedFault") ==0)
+    k = new O3StructInjectedFault(os);
+  else if (DTRACE(FaultInjection))
+    std::cout << "No such Object: "<<type<<"\n";
+
+  if (k)
+    k->dump();
+  return k;
+}
+
+//a fault of the binary list, built from the fields of its record
+InjectedFault *
+Fi_System::create_fault(uint64_t record)
+{
+  const FaultRecord &r = faultList.record(record);
+  faultList.check(r);
+  int where = r.core < 0 ? (int)ThreadEnabledFault::AllCores : listCores[r.core];
+  InjectedFault *k = NULL;
+
+  switch (r.type) {
+  case FaultRecord::GeneralFetch:
+    k = new GeneralFetchInjectedFault(r, where);
+    break;
+  case FaultRecord::IEWStage:
+    k = new IEWStageInjectedFault(r, where);
+    break;
+  case FaultRecord::Memory:
+    k = new MemoryInjectedFault(r, where);
+    break;
+  case FaultRecord::OpCode:
+    k = new OpCodeInjectedFault(r, where);
+    break;
+  case FaultRecord::PC:
+    k = new PCInjectedFault(r, where);
+    break;
+  case FaultRecord::Register:
+    k = new RegisterInjectedFault(r, where);
+    break;
+  case FaultRecord::RegisterDecoding:
+    k = new RegisterDecodingInjectedFault(r, where);
+    break;
+  case FaultRecord::CPU:
+    k = new CPUInjectedFault(r, where);
+    break;
+  case FaultRecord::Plain:
+    k = new InjectedFault(r, where);
+    break;
+  case FaultRecord::O3CPU:
+    k = new O3CPUInjectedFault(r, where);
+    break;
+  case FaultRecord::O3Struct:
+    k = new O3StructInjectedFault(r, where);
+    break;
+  }
+
+  if (k)
+    k->dump();
+  return k;
+}
+
 void
-Fi_System:: getFromFile(std::ifstream &os){
+Fi_System:: getFromFile(std::istream &os){
 	string check;
-	InjectedFault *k;
 	
-	while(os.good()){
-		os>>check;		
-		if(check.compare("CPUInjectedFault") ==0){
-			k = new CPUInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("InjectedFault") ==0){
-			k = new InjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("GeneralFetchInjectedFault") ==0){
-			k = new GeneralFetchInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("IEWStageInjectedFault") ==0){
-			k = new IEWStageInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("MemoryInjectedFault") ==0){
-			k = new MemoryInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("O3CPUInjectedFault") ==0){
-			k = new O3CPUInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("OpCodeInjectedFault") ==0){
-			k = new OpCodeInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("PCInjectedFault") ==0){
-			k = new PCInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("RegisterInjectedFault") ==0){
-			k = new RegisterInjectedFault(os);
-			k->dump();
-		}
-		else if(check.compare("RegisterDecodingInjectedFault") ==0){
-			k = new RegisterDecodingInjectedFault(os);
-			k->dump();
-		}
-		else{
-		  if (DTRACE(FaultInjection)) {
-		    std::cout << "No such Object: "<<check<<"\n";
-		  }
-		}
-	}
+	while(os>>check)
+		create_fault(check, os);
+}
+
+//(Re)load the faults of in_name, a binary fault list is mapped and only its
+//Addr timed faults are created now, the rest follow the clocks (load_window)
+void
+Fi_System::load_faults()
+{
+  faultBase = InjectedFault::nextFaultID();
+  faultList.close();
+  nextInstRecord = 0;
+  nextTickRecord = 0;
+  lazyInstMark = (uint64_t)-1;
+  lazyTickMark = (uint64_t)-1;
+
+  if(in_name.size() <= 1)
+    return;
+
+  if (!FaultList::isFaultList(in_name)) {
+    input.open (in_name.c_str(), ifstream::in);
+    getFromFile(input);
+    input.close();
+    return;
+  }
+
+  faultList.open(in_name);
+  listCores.clear();
+  for (uint32_t i = 0; i < faultList.numCores(); i++)
+    listCores.push_back(get_core_id(faultList.coreName(i)));
+  nextInstRecord = faultList.addrRecords();
+  nextTickRecord = faultList.addrRecords() + faultList.instRecords();
+  for (uint64_t i = 0; i < faultList.addrRecords(); i++) {
+    InjectedFault::faultCnt = faultBase + i; //faults of a list are numbered by their record
+    create_fault(i);
+  }
+  InjectedFault::faultCnt = faultBase + faultList.numRecords();
+  load_window();
+}
+
+//create the Inst/Tick timed faults that are due within the window of the clocks
+void
+Fi_System::load_window()
+{
+  if (!faultList.isOpen())
+    return;
+
+  uint64_t instUntil = nextInstRecord;
+  uint64_t instEnd = faultList.addrRecords() + faultList.instRecords();
+  while (instUntil < instEnd && faultList.record(instUntil).timing - std::min(faultList.record(instUntil).timing, instWindow) <= instClock)
+    instUntil++;
+
+  uint64_t tickUntil = nextTickRecord;
+  while (tickUntil < faultList.numRecords() && faultList.record(tickUntil).timing - std::min(faultList.record(tickUntil).timing, tickWindow) <= tickClock)
+    tickUntil++;
+
+  load_records(instUntil, tickUntil);
+}
+
+void
+Fi_System::load_records(uint64_t instUntil, uint64_t tickUntil)
+{
+  uint64_t cnt = InjectedFault::faultCnt;
+
+  for (; nextInstRecord < instUntil; nextInstRecord++) {
+    InjectedFault::faultCnt = faultBase + nextInstRecord;
+    create_fault(nextInstRecord);
+  }
+  for (; nextTickRecord < tickUntil; nextTickRecord++) {
+    InjectedFault::faultCnt = faultBase + nextTickRecord;
+    create_fault(nextTickRecord);
+  }
+  InjectedFault::faultCnt = cnt;
+  update_lazy_marks();
+}
+
+//the clocks at which the next records come within the window
+void
+Fi_System::update_lazy_marks()
+{
+  uint64_t instEnd = faultList.addrRecords() + faultList.instRecords();
+  lazyInstMark = (uint64_t)-1;
+  lazyTickMark = (uint64_t)-1;
+  if (nextInstRecord < instEnd) {
+    uint64_t t = faultList.record(nextInstRecord).timing;
+    lazyInstMark = t - std::min(t, instWindow);
+  }
+  if (nextTickRecord < faultList.numRecords()) {
+    uint64_t t = faultList.record(nextTickRecord).timing;
+    lazyTickMark = t - std::min(t, tickWindow);
+  }
 }
 
 
@@ -235,6 +1839,8 @@ Fi_System:: reset()
   
   while(!iewStageInjectedFaultQueue.empty())
     iewStageInjectedFaultQueue.remove(iewStageInjectedFaultQueue.head);
+  while(!o3StructInjectedFaultQueue.empty())
+    o3StructInjectedFaultQueue.remove(o3StructInjectedFaultQueue.head);
  
   
   mainInjectedFaultQueue.setName("MainFaultQueue");
@@ -249,22 +1855,24 @@ Fi_System:: reset()
   iewStageInjectedFaultQueue.setName("IEWStageFaultQueue");
   iewStageInjectedFaultQueue.setHead(NULL);
   iewStageInjectedFaultQueue.setTail(NULL);
+  o3StructInjectedFaultQueue.setName("O3StructFaultQueue");
+  o3StructInjectedFaultQueue.setHead(NULL);
+  o3StructInjectedFaultQueue.setTail(NULL);
   
+  clear_addr_events();
   threadList.erase(threadList.begin(),threadList.end());
+  fi_activation.clear();
   
   
-  if(in_name.size() > 1){
-    if (DTRACE(FaultInjection)) {
-       std::cout << "Fi_System::Reading New Faults \n";
-    }
-    input.open (in_name.c_str(), ifstream::in);
-    getFromFile(input);
-    input.close();
-    
-    if (DTRACE(FaultInjection)) {
-      std::cout << "~Fi_System::Reading New Faults \n";
-    }
+  if (DTRACE(FaultInjection)) {
+    std::cout << "Fi_System::Reading New Faults \n";
   }
+  load_faults();
+  if (DTRACE(FaultInjection)) {
+    std::cout << "~Fi_System::Reading New Faults \n";
+  }
+  //no thread has activated fault injection any more
+  update_fi_threads();
   dump();
   
 }
@@ -273,9 +1881,10 @@ Fi_System:: reset()
 
 //Wrapper function
 int
-Fi_System:: increase_instr_fetched(std:: string curCpu , ThreadEnabledFault *curThread){
+Fi_System:: increase_instr_fetched(int curCpu , ThreadEnabledFault *curThread){
    
   
+   instClock++;
    if(curThread){
       curThread->increaseFetchedInstr(curCpu);
     }
@@ -283,8 +1892,9 @@ Fi_System:: increase_instr_fetched(std:: string curCpu , ThreadEnabledFault *cur
 }
 //Wrapper function
 int
-Fi_System:: increase_instr_decoded(std:: string curCpu , ThreadEnabledFault *curThread){
+Fi_System:: increase_instr_decoded(int curCpu , ThreadEnabledFault *curThread){
      
+    instClock++;
     if(curThread)
       curThread->increaseDecodedInstr(curCpu);
     return (1);
@@ -292,8 +1902,9 @@ Fi_System:: increase_instr_decoded(std:: string curCpu , ThreadEnabledFault *cur
 
 //Wrapper function
 int
-Fi_System:: increase_instr_executed(std:: string curCpu , ThreadEnabledFault *curThread){
+Fi_System:: increase_instr_executed(int curCpu , ThreadEnabledFault *curThread){
 
+    instClock++;
     if(curThread)
       curThread->increaseExecutedInstr(curCpu);
     return (1);
@@ -302,9 +1913,10 @@ Fi_System:: increase_instr_executed(std:: string curCpu , ThreadEnabledFault *cu
 
 //Wrapper function
 int
-Fi_System:: increaseTicks(std :: string curCpu , ThreadEnabledFault *curThread, uint64_t ticks){
+Fi_System:: increaseTicks(int curCpu , ThreadEnabledFault *curThread, uint64_t ticks){
     
 
+    tickClock += ticks;
     if(curThread)
       curThread->increaseTicks(curCpu,ticks);
     
@@ -315,7 +1927,7 @@ Fi_System:: increaseTicks(std :: string curCpu , ThreadEnabledFault *curThread,
 //this function calculates all the instructions that all threads 
 // have fetched in a specific core or even on all cores
 int
-Fi_System:: get_core_fetched_time(std::string Cpu,uint64_t *instr,uint64_t *time){
+Fi_System:: get_core_fetched_time(int Cpu,uint64_t *instr,uint64_t *time){
   uint64_t temp_time;
   uint64_t temp_instr;
   for(fi_activation_iter = fi_activation.begin(); fi_activation_iter != fi_activation.end(); ++fi_activation_iter){
@@ -332,7 +1944,7 @@ Fi_System:: get_core_fetched_time(std::string Cpu,uint64_t *instr,uint64_t *time
 //this function calculates all the instructions that all threads 
 // have decoded in a specific core or even on all cores
 int
-Fi_System:: get_core_decoded_time(std::string Cpu,uint64_t *instr,uint64_t *time){
+Fi_System:: get_core_decoded_time(int Cpu,uint64_t *instr,uint64_t *time){
   uint64_t temp_time;
   uint64_t temp_instr;
   for(fi_activation_iter = fi_activation.begin(); fi_activation_iter != fi_activation.end(); ++fi_activation_iter){
@@ -349,7 +1961,7 @@ Fi_System:: get_core_decoded_time(std::string Cpu,uint64_t *instr,uint64_t *time
 // have executed in a specific core or even on all cores
 
 int
-Fi_System:: get_core_executed_time(std::string Cpu,uint64_t *instr,uint64_t *time){
+Fi_System:: get_core_executed_time(int Cpu,uint64_t *instr,uint64_t *time){
   uint64_t temp_time;
   uint64_t temp_instr;
   for(fi_activation_iter = fi_activation.begin(); fi_activation_iter != fi_activation.end(); ++fi_activation_iter){
@@ -364,114 +1976,57 @@ Fi_System:: get_core_executed_time(std::string Cpu,uint64_t *instr,uint64_t *tim
 
 
 
-int 
-Fi_System:: get_fi_fetch_counters( InjectedFault *p , ThreadEnabledFault &thread,std::string curCpu , uint64_t *fetch_instr , uint64_t *fetch_time ){
-  
-  *fetch_time=0;
-  *fetch_instr=0;
-  // Case :: specific cpu ---- specific thread
-  if((p->getWhere().compare(curCpu))==0 && (p->getThread()).compare("all") != 0 && thread.getThreaId() == atoi( (p->getThread()).c_str() ) ){ // case thread_id - cpu_id
-      thread.CalculateFetchedTime(curCpu,fetch_instr,fetch_time);
-  }//Case :: ALL cores --- specific Thread
-  else if((p->getWhere().compare("all") == 0) && (p->getThread()).compare("all") != 0 && thread.getThreaId() == atoi( (p->getThread()).c_str() )){// case thread_id - all
-      thread.CalculateFetchedTime("all",fetch_instr,fetch_time);
-  }//Case :: Specific Cpu --- All threads
-  else if( ( (p->getWhere().compare(curCpu)) == 0  ) && (((p->getThread()).compare("all")) == 0)  ){ //case cpu_id - all
-    get_core_fetched_time(curCpu,fetch_instr,fetch_time);
-  }//Case:: All cores --- All threads
-  else if( ((p->getThread()).compare("all") == 0) && ((p->getWhere().compare("all")) == 0) ){ //case all - all
-    get_core_fetched_time("all",fetch_instr,fetch_time);
-  }
-  if(*fetch_time|*fetch_instr){
-    if(p->getFaultType() == p->RegisterInjectedFault || p->getFaultType() == p->PCInjectedFault || p->getFaultType() == p->MemoryInjectedFault  ){
-	  p->setCPU(reinterpret_cast<BaseCPU *>(find(curCpu.c_str())));// I may manifest during this cycle so se the core.
-	  return 1;
-    }
-    else if(p->getFaultType() == p->GeneralFetchInjectedFault || p->getFaultType() == p->OpCodeInjectedFault ||
-	    p->getFaultType() == p->RegisterDecodingInjectedFault || p->getFaultType() == p->ExecutionInjectedFault){
-	O3CPUInjectedFault *k = reinterpret_cast<O3CPUInjectedFault*> (p);
-	k->setCPU(reinterpret_cast<BaseO3CPU *>(find(curCpu.c_str())));// I may manifest during this cycle so se the core.
-	return 2;
-    }
-  }
-  return 0;
-}
-
-
+void
+Fi_System:: get_fi_counters(int stage, int where, int threadScope, ThreadEnabledFault &thread, int curCpu, uint64_t *exec_instr, uint64_t *exec_time){
 
-int 
-Fi_System:: get_fi_decode_counters( InjectedFault *p , ThreadEnabledFault &thread,std::string curCpu , uint64_t *decode_instr , uint64_t *decode_time ){
+  int core = (where == ThreadEnabledFault::AllCores) ? ThreadEnabledFault::AllCores : curCpu;
 
-  // case thread_id - cpu_id
-  *decode_time=0;
-  *decode_instr=0;
-  if((p->getWhere().compare(curCpu))==0 && (p->getThread()).compare("all") != 0 && thread.getThreaId() == atoi( (p->getThread()).c_str() ) ){ 
-      thread.CalculateFetchedTime(curCpu,decode_instr,decode_time);
-  }// case thread_id - all
-  else if((p->getWhere().compare("all") == 0) && (p->getThread()).compare("all") != 0 && thread.getThreaId() == atoi( (p->getThread()).c_str() )){
-      thread.CalculateFetchedTime("all",decode_instr,decode_time);
- }//case cpu_id - all
-  else if( ( (p->getWhere().compare(curCpu)) == 0  ) && (((p->getThread()).compare("all")) == 0)  ){ 
-    get_core_decoded_time(curCpu,decode_instr,decode_time);
-  } //case all - all
-  else if( ((p->getThread()).compare("all") == 0) && ((p->getWhere().compare("all")) == 0) ){
-    get_core_decoded_time("all",decode_instr,decode_time);
+  *exec_time=0;
+  *exec_instr=0;
+  if (threadScope != -1) { // case thread_id - cpu_id / thread_id - all
+    if (stage == InjectedFaultQueue::IEWStage)
+      thread.CalculateExecutedTime(core, exec_instr, exec_time);
+    else // the decode queue has always been timed by the fetched instructions of the thread
+      thread.CalculateFetchedTime(core, exec_instr, exec_time);
   }
-  
-  if(*decode_time | *decode_instr){
-    if(p->getFaultType() == p->RegisterInjectedFault || p->getFaultType() == p->PCInjectedFault || p->getFaultType() == p->MemoryInjectedFault ) {
-	p->setCPU(reinterpret_cast<BaseCPU *>(find(curCpu.c_str())));// I may manifest during this cycle so se the core.
-	return 1;
-    }
-    else if(p->getFaultType() == p->GeneralFetchInjectedFault || p->getFaultType() == p->OpCodeInjectedFault ||
-	  p->getFaultType() == p->RegisterDecodingInjectedFault || p->getFaultType() == p->ExecutionInjectedFault){
-	O3CPUInjectedFault *k = reinterpret_cast<O3CPUInjectedFault*> (p);
-	BaseO3CPU *v = reinterpret_cast<BaseO3CPU *>(find(curCpu.c_str())); // I may manifest during this cycle so se the core.
-	k->setCPU(v);
-      return 2;
-    }
+  else { // case cpu_id - all / all - all
+    if (stage == InjectedFaultQueue::IEWStage)
+      get_core_executed_time(core, exec_instr, exec_time);
+    else if (stage == InjectedFaultQueue::DecodeStage)
+      get_core_decoded_time(core, exec_instr, exec_time);
+    else
+      get_core_fetched_time(core, exec_instr, exec_time);
   }
-   
-  return 0;
 }
 
 
+void
+Fi_System::switch_core(int id, BaseCPU *cpu)
+{
+  if (id < 0)
+    return;
+  if (coreCpus.size() <= (size_t)id)
+    coreCpus.resize(id + 1, NULL);
+  coreCpus[id] = cpu;
+  //the counters the marks were taken from now run on another cpu
+  invalidate_marks();
+}
 
+int
+Fi_System:: set_fault_cpu(InjectedFault *p, int curCpu){
 
-int 
-Fi_System:: get_fi_exec_counters( InjectedFault *p , ThreadEnabledFault &thread,std::string curCpu , uint64_t *exec_instr, uint64_t *exec_time  ){
-  
-  *exec_time=0;
-  *exec_instr=0;
-  if((p->getWhere().compare(curCpu))==0 && (p->getThread()).compare("all") != 0 && thread.getThreaId() == atoi( (p->getThread()).c_str() ) ){ // case thread_id - cpu_id
-      thread.CalculateExecutedTime(curCpu,exec_instr,exec_time);
-  }
-  else if((p->getWhere().compare("all") == 0) && (p->getThread()).compare("all") != 0 && thread.getThreaId() == atoi( (p->getThread()).c_str() )){// case thread_id - all
-      thread.CalculateExecutedTime("all",exec_instr,exec_time);
+  BaseCPU *cpu = (size_t)curCpu < coreCpus.size() ? coreCpus[curCpu] : NULL;
+  if(p->getFaultType() == p->RegisterInjectedFault || p->getFaultType() == p->PCInjectedFault || p->getFaultType() == p->MemoryInjectedFault){
+    p->setCPU(cpu); // I may manifest during this cycle so se the core.
+    return 1;
   }
-  else if( ( (p->getWhere().compare(curCpu)) == 0  ) && (((p->getThread()).compare("all")) == 0)  ){ //case cpu_id - all
-    get_core_executed_time(curCpu,exec_instr,exec_time);
-  }
-  else if( ((p->getThread()).compare("all") == 0) && ((p->getWhere().compare("all")) == 0) ){ //case all - all
-    get_core_executed_time("all",exec_instr,exec_time);
-  }
-  if(*exec_time | *exec_instr){
-    if(p->getFaultType() == p->RegisterInjectedFault || p->getFaultType() == p->PCInjectedFault || p->getFaultType() == p->MemoryInjectedFault){
-	p->setCPU(reinterpret_cast<BaseCPU *>(find(curCpu.c_str()))); // I may manifest during this cycle so se the core.
-	return 1;
-    }
-    else if(p->getFaultType() == p->GeneralFetchInjectedFault || p->getFaultType() == p->OpCodeInjectedFault ||
-	    p->getFaultType() == p->RegisterDecodingInjectedFault || p->getFaultType() == p->ExecutionInjectedFault){
-	O3CPUInjectedFault *k = reinterpret_cast<O3CPUInjectedFault*> (p);
-	BaseO3CPU *v = reinterpret_cast<BaseO3CPU *>(find(curCpu.c_str())); // I may manifest during this cycle so se the core.
-	k->setCPU(v);
-      return 2;
-    }
+  else if(p->getFaultType() == p->GeneralFetchInjectedFault || p->getFaultType() == p->OpCodeInjectedFault ||
+	  p->getFaultType() == p->RegisterDecodingInjectedFault || p->getFaultType() == p->ExecutionInjectedFault ||
+	  p->getFaultType() == p->O3StructInjectedFault){
+    O3CPUInjectedFault *k = reinterpret_cast<O3CPUInjectedFault*> (p);
+    BaseO3CPU *v = reinterpret_cast<BaseO3CPU *>(cpu); // I may manifest during this cycle so se the core.
+    k->setCPU(v);
+    return 2;
   }
   return 0;
 }
-
-
-
-
-
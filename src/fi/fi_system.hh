@@ -7,31 +7,45 @@
 
 #ifndef _FI_SYSTEM__
 #define _FI_SYSTEM__
+#include <deque>
 #include <map>
+#include <set>
 #include <utility> 
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
 
 
 #include "config/the_isa.hh"
 #include "base/types.hh"
 #include "arch/types.hh"
 #include "base/trace.hh"
+#include "base/statistics.hh"
 #include "debug/FaultInjection.hh"
 #include "fi/faultq.hh"
+#include "fi/fault_list.hh"
 #include "fi/cpu_threadInfo.hh"
 #include "fi/iew_injfault.hh"
 #include "fi/cpu_injfault.hh"
+#include "mem/abstract_mem.hh"
 #include "mem/mem_object.hh"
 #include "params/Fi_System.hh"
 #include "fi/genfetch_injfault.hh"
 #include "fi/regdec_injfault.hh"
+#include "fi/o3struct_injfault.hh"
 
 using namespace std;
 using namespace TheISA;
 
+class AddrTriggerEvent;
+class CrashEvent;
 class Fi_System;
 class InjectedFaultQueue;
+class LockstepLanes;
+class PCEventQueue;
+class RegLiveness;
 
 
 extern Fi_System *fi_system;
@@ -42,7 +56,7 @@ extern Fi_System *fi_system;
  */
 
 
-class Fi_System : public MemObject
+class Fi_System : public MemObject, public AbstractMemory::AccessWatcher
 {
 private :
     std::ifstream input;
@@ -55,6 +69,7 @@ public :
     InjectedFaultQueue fetchStageInjectedFaultQueue;	//("Fetch Stage Fault Queue");
     InjectedFaultQueue decodeStageInjectedFaultQueue;	//("Decode Stage Fault Queue");	
     InjectedFaultQueue iewStageInjectedFaultQueue;	//("IEW Stage Fault Queue");
+    InjectedFaultQueue o3StructInjectedFaultQueue;	//("O3 Structure Fault Queue");
     
     /*
      * The map correlate a thread/application with the pcb address
@@ -74,11 +89,307 @@ public :
 
 private:
 
+  /*
+   * Core names are interned to small integer ids, the counters of every
+   * thread are a flat array indexed by them. The cpus get their id at
+   * startup and the faults when they are read.
+   */
+  std::map<std::string, int> coreIds;
+  std::vector<std::string> coreNames;
+  std::vector<BaseCPU *> coreCpus;
+
+  /*
+   * Clocks that every counter of every thread advances with: instClock
+   * counts the fetched, decoded and executed instruction events and
+   * tickClock the ticks. No scope counter grows faster than them, so the
+   * queue watermarks are expressed on these clocks.
+   */
+  uint64_t instClock;
+  uint64_t tickClock;
+
+  /* id of the first fault read from in_name, the queues save their
+   * faults relative to it
+   */
+  uint64_t faultBase;
+
+  /*
+   * A binary fault list is mapped instead of read, its Inst and Tick
+   * timed faults are created once the clocks come within a window of
+   * their timing (no scope counter runs ahead of the clocks).
+   */
+  FaultList faultList;
+  std::vector<int> listCores; // core id of every core name of the list
+  uint64_t nextInstRecord;
+  uint64_t nextTickRecord;
+  uint64_t lazyInstMark;
+  uint64_t lazyTickMark;
+  uint64_t instWindow;
+  uint64_t tickWindow;
+
+  void load_faults();
+  void load_window();
+  void load_records(uint64_t instUntil, uint64_t tickUntil);
+  void update_lazy_marks();
+  InjectedFault *create_fault(const std::string &type, std::istream &in);
+  InjectedFault *create_fault(uint64_t record);
+
+  Stats::Scalar hooksSkipped;
+  Stats::Scalar hooksScanned;
+
+  /*
+   * Campaign mode: this process runs the golden execution and forks a
+   * child at the trigger of every fault. The child applies only that
+   * fault and runs to completion, the parent never applies any fault.
+   */
+  bool campaign;
+  bool campaignChild;
+  int maxChildren;
+  std::string campaignResults;
+  std::set<pid_t> children;
+  /*
+   * maxChildren tokens on a pipe shared by the golden run and its
+   * snapshots: an experiment takes one before it is forked (or its fault
+   * is sent to a snapshot) and the process that reaps it gives it back.
+   */
+  int tokenFds[2];
+  std::set<pid_t> experiments; // children holding a token
+  uint64_t campaignFaultId; // position of the fault of this child in the fault file
+  Tick campaignForkTick;
+  std::string exitCause; // cause of the last simulation loop exit
+  int exitCode;
+
+  bool fork_experiment(InjectedFault *f);
+  bool fork_child(uint64_t id, Tick forkTick);
+  void reap_children(bool block);
+  void open_tokens();
+  void take_token();
+  void give_token();
+  void drop_faults();
+  void campaign_exit();
+
+  /*
+   * State digests: every digestInterval events of instClock the
+   * registers of the running context and the memories are hashed. The
+   * golden run records them, a faulty run compares against them and
+   * exits as masked once it is back to the golden state with no fault
+   * left to apply. The memory digest is a sum of per page hashes so only
+   * the pages written since the previous point are hashed again.
+   */
+  struct MemoryDigest
+  {
+    AbstractMemory *mem;
+    int consumer; // id of the dirty set kept for the digests
+    std::vector<uint64_t> pageHash;
+    uint64_t sum;
+  };
+  std::vector<MemoryDigest> memDigests;
+  uint64_t digestInterval;
+  uint64_t nextDigest;
+  uint64_t digestPoint;
+  bool recordDigests;
+  std::ofstream digestOut;
+  std::map<uint64_t, std::pair<uint64_t, uint64_t> > goldenDigests; // point -> register and memory digest
+  uint64_t faultsApplied;
+
+  void digest_point(ThreadContext *tc);
+  uint64_t register_digest(ThreadContext *tc);
+  uint64_t memory_digest();
+  bool faults_pending();
+  void load_golden_digests(const std::string &path);
+
+  /*
+   * Snapshot ladder: every snapshotInterval events of instClock the
+   * golden run of a campaign forks a snapshot, a process parked on a pipe
+   * that shares the memory of the golden run copy on write. A fault that
+   * triggers in the golden run is not applied there; its id is sent to
+   * the latest snapshot, which forks the experiment of the fault from
+   * there. The oldest snapshots are retired (they finish the experiments
+   * they were sent and exit) beyond maxSnapshots or once the pages the
+   * golden run wrote since they were taken exceed snapshotBudget bytes.
+   * With snapshotSpill the snapshots are checkpoints written by the
+   * simulation script instead.
+   */
+  struct Snapshot
+  {
+    pid_t pid;
+    int fd;              // write end of the pipe the fault ids are sent on
+    uint64_t dirtyPages; // written by the golden run since it was taken
+  };
+  std::deque<Snapshot> snapshots;
+  std::vector<std::pair<AbstractMemory *, int> > snapshotMems; // memory and its dirty set id
+  uint64_t snapshotInterval;
+  uint64_t nextSnapshot;
+  int maxSnapshots;
+  uint64_t snapshotBudget;
+  bool snapshotSpill;
+  bool ladder;
+
+  void find_memories(std::vector<AbstractMemory *> &mems);
+  void snapshot_point();
+  void take_snapshot();
+  void serve_snapshot(int fd);
+  void retire_snapshot();
+  void dispatch_fault(InjectedFault *f);
+  void become_experiment(uint64_t id);
+  void keep_only_fault(uint64_t id);
+
+  /*
+   * Detailed window: the run goes on with the atomic cpus and asks the
+   * simulation script to switch to the detailed ones once a fault may
+   * trigger within switchWarmup instruction events (switchWarmupTicks
+   * ticks), and back once no fault is that close any more. A fault can
+   * not trigger before the clock reaches its watermark, so the window
+   * is checked only when the clocks reach switchInstMark/switchTickMark.
+   */
+  bool autoSwitch;
+  bool detailed;
+  uint64_t switchWarmup;
+  uint64_t switchWarmupTicks;
+  uint64_t switchInstMark;
+  uint64_t switchTickMark;
+
+  void switch_point();
+
+  /*
+   * Lockstep lanes: the golden run of a campaign hands up to maxLanes
+   * transient register faults to the atomic cpu they hit, which carries
+   * them along the golden thread (fi/lockstep.hh) and forks their
+   * experiment only once they diverge from it.
+   */
+  int maxLanes;
+  bool probing; // a lane is probing an instruction, the execute hooks ignore it
+  std::set<LockstepLanes *> laneSets;
+  Stats::Scalar lanesAdded;
+  Stats::Scalar lanesMasked;
+  Stats::Scalar lanesSplit;
+
+  bool add_lane(InjectedFault *f);
+
+  /*
+   * Register liveness profile (fi/reg_liveness.hh): the atomic cpus report
+   * the registers every instruction of a fault injection thread reads and
+   * writes, it is written to livenessProfile at exit.
+   */
+  RegLiveness *liveness;
+  std::string livenessProfile;
+
+  void write_liveness();
+
+  /*
+   * Memory uses: with memUses set the faults of this run are only
+   * observed, the run stays golden. The physical byte a memory fault would
+   * hit is watched until its next access and written to memUses with the
+   * sequence number and kind of that access, faults on the same byte
+   * waiting for the same access are equivalent (util/fi_collapse.py).
+   */
+  std::string memUses;
+  std::ofstream memUsesOut;
+  std::multimap<Addr, uint64_t> memWatch; // byte -> id of the faults on it
+
+  void observe_fault(InjectedFault *f);
+  void mem_uses_exit();
+
+  /*
+   * Memory timelines (mem/access_timeline.hh): with recordTimeline the
+   * accesses of the memories of the golden run are recorded and written
+   * to memTimeline at exit. Otherwise a campaign reads them from there
+   * and does not fork the memory faults whose byte is overwritten or
+   * never read again after the fault; the stamps of the campaign follow
+   * those of the golden run as long as it runs on the same cpus.
+   */
+  struct MemTimeline
+  {
+    AbstractMemory *mem;
+    AccessTimeline *timeline;
+    uint64_t accesses; // served by the memory in the recorded run
+  };
+  std::vector<MemTimeline> memTimelines;
+  std::string memTimeline;
+  bool recordTimeline;
+  Stats::Scalar memFaultsPruned;
+
+  void load_timelines();
+  void write_timelines();
+  bool mem_fault_masked(InjectedFault *f);
+
+  /*
+   * A campaign does not fork the transient faults of the structures of
+   * the detailed core that hit an entry holding nothing live at their
+   * cycle, they are masked.
+   */
+  Stats::Scalar structFaultsPruned;
+
+  bool struct_fault_masked(InjectedFault *f);
+
+  /*
+   * Addr timed faults as PC events (fi/addr_trigger.hh): every offset an
+   * Addr timed fault of any queue is at (addrOffsets, with the number of
+   * queues that have it) gets an event of the system PC event queue at
+   * that offset from the magic instruction of every active thread. The
+   * event that goes off for the thread running on a context remembers
+   * the context and pc in addrHitTc/addrHitPc, the cpus that service the
+   * PC events before the hooks only scan the Addr triggers there.
+   */
+  PCEventQueue *pcQueue;
+  std::map<Addr, int> addrOffsets;
+  typedef std::map<std::pair<ThreadEnabledFault *, Addr>, AddrTriggerEvent *> AddrEventMap;
+  AddrEventMap addrEvents;
+  ThreadContext *addrHitTc;
+  Addr addrHitPc;
+
+  void arm_addr_event(ThreadEnabledFault *thread, Addr offset);
+  void disarm_addr_events(ThreadEnabledFault *thread);
+
+  /*
+   * Outcome of a run that applied a fault: the golden run writes the
+   * instruction events and ticks of every thread and the tick it ended
+   * at to goldenTotals. A faulty run is ended as a hang once a thread
+   * runs hangFactor times its golden totals (checked every watchInterval
+   * instruction events) or the run hangFactor times the ticks of the
+   * golden one (hangEvent). Every watchInterval instruction events a
+   * burst samples the pc and registers of the running thread after each
+   * of its next loopWindow committed instructions; loopSamples bursts in
+   * a row that see a signature twice are a tight loop, whatever its period
+   * up to loopWindow instructions.
+   * The guest crash functions of crashSymbols end it as a crash
+   * (fi/crash_event.hh). The outcome is classified from the exit cause.
+   */
+  std::string goldenTotals;
+  bool recordTotals;
+  std::map<int, std::pair<uint64_t, uint64_t> > threadTotals; // thread id -> golden instruction events, ticks
+  Tick goldenEndTick;
+  double hangFactor;
+  uint64_t watchInterval;
+  uint64_t nextWatch;
+  int loopSamples;
+  int loopWindow;
+  std::map<int, int> loopRepeats; // thread id -> bursts in a row that saw a repeat
+  bool loopBurst;
+  int loopThread;
+  Counter loopCommitted; // committed instructions of the cpu at the last sample
+  uint64_t loopBurstEnd; // instClock the burst gives up at
+  bool loopFound;
+  std::set<uint64_t> loopSeen;
+  std::vector<std::string> crashSymbols;
+  std::vector<CrashEvent *> crashEvents;
+  std::string outcomeFile;
+  bool runEnded;
+
+  void hang_deadline();
+  EventWrapper<Fi_System, &Fi_System::hang_deadline> hangEvent;
+
+  void load_golden_totals(const std::string &path);
+  void write_golden_totals();
+  void watch_point(ThreadContext *tc);
+  void loop_sample(ThreadContext *tc);
+  void end_run(const std::string &cause);
+  void outcome_exit();
+
   bool check_before_init;
   
-  int get_core_fetched_time(std::string Cpu,uint64_t* time,uint64_t *instr);
-  int get_core_decoded_time(std::string Cpu,uint64_t* time,uint64_t *instr);
-  int get_core_executed_time(std::string Cpu,uint64_t* time,uint64_t *instr);
+  int get_core_fetched_time(int Cpu,uint64_t* time,uint64_t *instr);
+  int get_core_decoded_time(int Cpu,uint64_t* time,uint64_t *instr);
+  int get_core_executed_time(int Cpu,uint64_t* time,uint64_t *instr);
     
   void setcheck(bool v){check_before_init=v;};
   
@@ -97,24 +408,193 @@ public:
   
   
   
-  int increase_instr_fetched(std:: string curCpu , ThreadEnabledFault *curThread);
-  int increase_instr_decoded(std:: string curCpu , ThreadEnabledFault *curThread);  
-  int increase_instr_executed(std:: string curCpu , ThreadEnabledFault *curThread);
+  int increase_instr_fetched(int curCpu , ThreadEnabledFault *curThread);
+  int increase_instr_decoded(int curCpu , ThreadEnabledFault *curThread);  
+  int increase_instr_executed(int curCpu , ThreadEnabledFault *curThread);
   
-  int increaseTicks(std :: string curCpu , ThreadEnabledFault *curThread , uint64_t ticks);
+  int increaseTicks(int curCpu , ThreadEnabledFault *curThread , uint64_t ticks);
+
+  /* id of the named core, a new one is given the first time a name is seen
+   * ("all" stands for ThreadEnabledFault::AllCores)
+   */
+  int get_core_id(const std::string &name);
+  int get_num_cores() const { return coreNames.size(); }
+  const std::string &get_core_name(int id) const { return coreNames[id]; }
+
+  /*
+   * Counters that a fault of the given scope (where: core name or "all",
+   * threadScope: thread id or -1 for all threads) is compared against
+   * while the given queue stage is scanned.
+   */
+  void get_fi_counters(int stage, int where, int threadScope, ThreadEnabledFault &thread, int curCpu, uint64_t *exec_instr, uint64_t *exec_time);
 
-  int get_fi_fetch_counters(InjectedFault *p , ThreadEnabledFault &thread,std::string curCpu , uint64_t *exec_time , uint64_t *exec_instr );
-  int get_fi_decode_counters(InjectedFault *p , ThreadEnabledFault &thread,std::string curCpu , uint64_t *exec_time , uint64_t *exec_instr );
-  int get_fi_exec_counters(InjectedFault *p , ThreadEnabledFault &thread,std::string curCpu , uint64_t *exec_time , uint64_t *exec_instr );
+  /*
+   * The fault may manifest during this cycle so set the core it is going to hit.
+   * Returns 1 for faults on the simple cpu interface and 2 for O3 faults.
+   */
+  int set_fault_cpu(InjectedFault *p, int curCpu);
   
   
-  void getFromFile(std::ifstream &os);
+  /* the thread that activated fault injection from this pcb address, NULL if none is active
+   */
+  ThreadEnabledFault *get_fi_thread(Addr pcb);
+
+  /* The thread contexts cache the ThreadEnabledFault of the thread they run
+   * update_fi_thread is called when the pcb register of a context is written (context switch)
+   * update_fi_threads refreshes all contexts after the activation map changes
+   */
+  void update_fi_thread(ThreadContext *tc, Addr pcb) { tc->setFiThread(get_fi_thread(pcb)); }
+  void update_fi_threads();
+
+  /* recompute the watermarks of the queue from the counters of all the active threads
+   */
+  void update_marks(InjectedFaultQueue &q);
+  void invalidate_marks();
+
+  /* the queues index or drop the last Addr timed fault at an offset
+   */
+  void add_addr_offset(Addr offset);
+  void remove_addr_offset(Addr offset);
+
+  /* moves the PC events of the thread to its magic instruction, called
+   * whenever it is set; disarm_addr_events() of all the threads drops
+   * them all
+   */
+  void rebase_addr_events(ThreadEnabledFault *thread);
+  void clear_addr_events();
+
+  /* an Addr trigger event of the thread running on tc went off */
+  void
+  addr_hit(ThreadContext *tc)
+  {
+    addrHitTc = tc;
+    addrHitPc = tc->instAddr();
+  }
+
+  /* true if no Addr timed fault of the queue can be due at the pc of tc
+   */
+  bool
+  addr_quiet(InjectedFaultQueue &q, ThreadContext *tc, ThreadEnabledFault &thread)
+  {
+    if (!q.hasAddrTriggers())
+      return true;
+    Addr pc = tc->pcState().instAddr();
+    if (pcQueue && tc->getCpuPtr()->fiServicesPcEvents())
+      return addrHitTc != tc || addrHitPc != pc;
+    return q.addrQuiet(pc - thread.getMagicInstVirtualAddr());
+  }
+
+  /* true if nothing of the queue can manifest on this hook so the scan is skipped
+   */
+  bool
+  skip_scan(InjectedFaultQueue &q, ThreadContext *tc, ThreadEnabledFault &thread)
+  {
+    if (instClock >= lazyInstMark || tickClock >= lazyTickMark)
+      load_window();
+    if (q.quiet(instClock, tickClock) && addr_quiet(q, tc, thread)) {
+      hooksSkipped++;
+      return true;
+    }
+    hooksScanned++;
+    return false;
+  }
+
+  uint64_t get_fault_base() const { return faultBase; }
+
+  /* true if a cpu taking over from another one stays the same core for
+   * the faults, the detailed cpus of the detailed window do
+   */
+  bool switch_keeps_core() const { return autoSwitch; }
+
+  /* cpu took over core id, the faults of the core are applied to it from now on
+   */
+  void switch_core(int id, BaseCPU *cpu);
+
+  /* true if the fault should be applied by this process, in campaign
+   * mode the golden run forks a child that applies it instead
+   */
+  bool
+  apply_fault(InjectedFault *f)
+  {
+    if (!memUses.empty()) {
+      observe_fault(f);
+      return false;
+    }
+    if (!recordTimeline && !memTimelines.empty() && campaign && !campaignChild &&
+	mem_fault_masked(f))
+      return false;
+    if (campaign && !campaignChild && struct_fault_masked(f))
+      return false;
+    if (maxLanes && campaign && !campaignChild && add_lane(f))
+      return false;
+    if (ladder && !snapshots.empty()) {
+      //the experiment starts from the latest snapshot
+      dispatch_fault(f);
+      return false;
+    }
+    if (campaign && !fork_experiment(f))
+      return false;
+    faultsApplied++;
+    return true;
+  }
+
+  bool profiling() const { return liveness != NULL; }
+
+  /* set while the lockstep lanes execute an instruction in probe mode, the
+   * probes must leave the counters and the fault queues as they are
+   */
+  void set_probing(bool v) { probing = v; }
+
+  /* next access of a byte a memory fault was observed on */
+  virtual void accessed(Addr addr, bool write, uint64_t seq);
+
+  /* records the register accesses of an instruction that executed with
+   * the given fault, profile_pc() those of the pc events at pc (they may
+   * read any register)
+   */
+  void profile_regs(ThreadContext *tc, const StaticInstPtr &inst, Fault fault);
+  void profile_pc(ThreadContext *tc, Addr pc);
+
+  /* outcome of the lanes: a split lane forks its experiment (true in
+   * the child), a converged one is masked
+   */
+  bool split_lane(uint64_t id, Tick tick);
+  void lane_masked(uint64_t id, Tick tick);
+
+  /* appends the outcome of the experiment of fault id to the campaign results
+   */
+  void write_result(uint64_t id, Tick forkTick, int code, const std::string &cause);
+
+  /* remembers why the simulation loop exited for the campaign results
+   */
+  void sim_loop_exit(const std::string &cause, int code) { exitCause = cause; exitCode = code; }
+
+  /* a guest crash function was entered, a run that applied a fault ends
+   */
+  void guest_crash(ThreadContext *tc, const std::string &symbol);
+
+  /* outcome of a run that exited with code and cause: masked,
+   * not_applied, hang, crash, completed (the output is still to be
+   * compared with the golden one) or error
+   */
+  static const char *classify(int code, const std::string &cause);
+
+  void getFromFile(std::istream &os);
   bool getCheck(){return check_before_init;}
   
   void reset();
   virtual Port* getPort(const std::string &if_name, int idx = 0);
   virtual void init();
   virtual void startup();
+  virtual void regStats();
+
+  /* Activation map, threads, counters and pending faults go into the
+   * checkpoint. The fault queues are only restored if the checkpoint was
+   * taken with the same fault file, otherwise the faults of the new file
+   * are kept so every experiment can start from the same checkpoint.
+   */
+  virtual void serialize(std::ostream &os);
+  virtual void unserialize(Checkpoint *cp, const std::string &section);
   
   void dump();
   
@@ -127,59 +607,98 @@ public:
   */
   template <class MYVAL>
   MYVAL iew_fault(ThreadContext *tc,MYVAL value){
-	IEWStageInjectedFault *iewFault = NULL;
-	Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
-	std::string _name = tc->getCpuPtr()->name();
-	Addr _pcbaddr = tc->readMiscReg(AlphaISA::IPR_PALtemp23); //Read PCB address;
-	if( FullSystem && (TheISA::inUserMode(tc)) ){
-	  if((fi_activation.find(_pcbaddr) != fi_activation.end()) && (fi_activation.find(_pcbaddr)->second != -1)){
-	      while ((iewFault = reinterpret_cast<IEWStageInjectedFault *>(iewStageInjectedFaultQueue.scan(_name, *(threadList[fi_activation[_pcbaddr]]), pcaddr))) != NULL)
-		  value = iewFault->process(value);
-	      increase_instr_executed(tc->getCpuPtr()->name(),threadList[fi_activation[_pcbaddr]]);
-	  }
+	ThreadEnabledFault *thread = tc->getFiThread();
+	if( thread && FullSystem && (TheISA::inUserMode(tc)) )
+	  value = iew_point(tc, tc->getCpuPtr()->fiCoreId(), *thread, tc->pcState().instAddr(), value);
+	return value;
+  }
+
+  /* the execute hook of the thread running on _core at pcaddr (tc is only
+   * read for Addr timed faults)
+   */
+  template <class MYVAL>
+  MYVAL iew_point(ThreadContext *tc, int _core, ThreadEnabledFault &thread, Addr pcaddr, MYVAL value){
+	if (probing)
+	  return value;
+	if (!skip_scan(iewStageInjectedFaultQueue, tc, thread)) {
+	  IEWStageInjectedFault *iewFault = NULL;
+	  while ((iewFault = reinterpret_cast<IEWStageInjectedFault *>(iewStageInjectedFaultQueue.scan(_core, thread, pcaddr))) != NULL)
+	      if (apply_fault(iewFault))
+		value = iewFault->process(value);
+	  update_marks(iewStageInjectedFaultQueue);
 	}
+	increase_instr_executed(_core, &thread);
 	return value;
   }
 	  
   void main_fault(ThreadContext *tc){
-      	CPUInjectedFault *mainfault = NULL;
-	Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
-	std::string _name = tc->getCpuPtr()->name();
-	Addr _pcbaddr = tc->readMiscReg(AlphaISA::IPR_PALtemp23); //Read PCB address;
-	if( FullSystem && (TheISA::inUserMode(tc)) ){
-	  if((fi_activation.find(_pcbaddr) != fi_activation.end()) && (fi_activation.find(_pcbaddr)->second != -1))
-	    while ((mainfault = reinterpret_cast<CPUInjectedFault *>(mainInjectedFaultQueue.scan(_name, *(threadList[fi_activation[_pcbaddr]]), pcaddr))) != NULL)
+	ThreadEnabledFault *thread = tc->getFiThread();
+	if( thread && FullSystem && (TheISA::inUserMode(tc)) ){
+	  if (skip_scan(mainInjectedFaultQueue, tc, *thread))
+	    return;
+	  CPUInjectedFault *mainfault = NULL;
+	  Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
+	  int _core = tc->getCpuPtr()->fiCoreId();
+	  while ((mainfault = reinterpret_cast<CPUInjectedFault *>(mainInjectedFaultQueue.scan(_core, *thread, pcaddr))) != NULL)
+	      if (apply_fault(mainfault))
 		mainfault->process();
+	  update_marks(mainInjectedFaultQueue);
 	}
     }
     
   TheISA::MachInst fetch_fault(ThreadContext *tc,TheISA::MachInst cur_instr){
-	
-	GeneralFetchInjectedFault *fetchfault = NULL;
-	Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
-	std::string _name = tc->getCpuPtr()->name();
-	Addr _pcbaddr = tc->readMiscReg(AlphaISA::IPR_PALtemp23); //Read PCB address;
-	if( FullSystem && (TheISA::inUserMode(tc)) ){
-	  if((fi_activation.find(_pcbaddr) != fi_activation.end()) && (fi_activation.find(_pcbaddr)->second != -1)){
-	      while ((fetchfault = reinterpret_cast<GeneralFetchInjectedFault *>(fetchStageInjectedFaultQueue.scan(_name, *(threadList[fi_activation[_pcbaddr]]), pcaddr))) != NULL)
+	ThreadEnabledFault *thread = tc->getFiThread();
+	if( thread && FullSystem && (TheISA::inUserMode(tc)) ){
+	  int _core = tc->getCpuPtr()->fiCoreId();
+	  if (!skip_scan(fetchStageInjectedFaultQueue, tc, *thread)) {
+	    GeneralFetchInjectedFault *fetchfault = NULL;
+	    Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
+	    while ((fetchfault = reinterpret_cast<GeneralFetchInjectedFault *>(fetchStageInjectedFaultQueue.scan(_core, *thread, pcaddr))) != NULL)
+		if (apply_fault(fetchfault))
 		  cur_instr = fetchfault->process(cur_instr);
-	     increase_instr_fetched(_name,threadList[fi_activation[_pcbaddr]]);
+	    update_marks(fetchStageInjectedFaultQueue);
 	  }
+	  increase_instr_fetched(_core,thread);
+	  if (instClock >= nextDigest)
+	    digest_point(tc);
+	  if (instClock >= nextWatch)
+	    watch_point(tc);
+	  if (instClock >= nextSnapshot)
+	    snapshot_point();
+	  if (instClock >= switchInstMark || tickClock >= switchTickMark)
+	    switch_point();
 	}
 	return cur_instr;
   }
   
+  void struct_fault(ThreadContext *tc){
+	ThreadEnabledFault *thread = tc->getFiThread();
+	if( thread && FullSystem && (TheISA::inUserMode(tc)) ){
+	  if (skip_scan(o3StructInjectedFaultQueue, tc, *thread))
+	    return;
+	  O3StructInjectedFault *structfault = NULL;
+	  Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
+	  int _core = tc->getCpuPtr()->fiCoreId();
+	  while ((structfault = reinterpret_cast<O3StructInjectedFault *>(o3StructInjectedFaultQueue.scan(_core, *thread, pcaddr))) != NULL)
+	      if (apply_fault(structfault))
+		structfault->process();
+	  update_marks(o3StructInjectedFaultQueue);
+	}
+    }
+
   StaticInstPtr decode_fault(ThreadContext *tc, StaticInstPtr cur_instr){
-      RegisterDecodingInjectedFault *decodefault = NULL;
-      Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
-      std::string _name = tc->getCpuPtr()->name();
-      Addr _pcbaddr = tc->readMiscReg(AlphaISA::IPR_PALtemp23); //Read PCB address;
-      if( FullSystem && (TheISA::inUserMode(tc)) ){
-	if((fi_activation.find(_pcbaddr) != fi_activation.end()) && (fi_activation.find(_pcbaddr)->second != -1)){
-	    while ((decodefault = reinterpret_cast<RegisterDecodingInjectedFault *>(decodeStageInjectedFaultQueue.scan(_name, *(threadList[fi_activation[_pcbaddr]]), pcaddr))) != NULL)
-		cur_instr = decodefault->process(cur_instr);
-	  increase_instr_decoded(_name,threadList[fi_activation[_pcbaddr]]);
+      ThreadEnabledFault *thread = tc->getFiThread();
+      if( thread && FullSystem && (TheISA::inUserMode(tc)) ){
+	int _core = tc->getCpuPtr()->fiCoreId();
+	if (!skip_scan(decodeStageInjectedFaultQueue, tc, *thread)) {
+	  RegisterDecodingInjectedFault *decodefault = NULL;
+	  Addr pcaddr = tc->pcState().instAddr(); //PC address for these instruction
+	  while ((decodefault = reinterpret_cast<RegisterDecodingInjectedFault *>(decodeStageInjectedFaultQueue.scan(_core, *thread, pcaddr))) != NULL)
+	      if (apply_fault(decodefault))
+		cur_instr = decodefault->process(tc, cur_instr);
+	  update_marks(decodeStageInjectedFaultQueue);
 	}
+	increase_instr_decoded(_core,thread);
       }
       return cur_instr;
   }
@@ -187,6 +706,83 @@ public:
   
 };
 
+#ifndef FI_ON
+#define FI_ON 1
+#endif
+
+/*
+ * Compile time switch for the fault injection hooks called from the CPU
+ * models and the ISA. FiHookPolicy<true> forwards to fi_system, while
+ * FiHookPolicy<false> (gem5.fast-nofi) returns its input untouched so the
+ * hooks inline to nothing.
+ *
+ * Every CPU model calls them at the same points of an instruction:
+ * main_fault before it is fetched, fetch_fault on its machine
+ * instruction, decode_fault on its StaticInst and increaseTicks for the
+ * ticks it runs (AtomicSimpleCPU::tick, TimingSimpleCPU::fetch and
+ * completeIfetch, InOrder FetchUnit::createMachInst and InOrderCPU::tick,
+ * O3 DefaultFetch::fetch). The iew faults are called by the ISA.
+ */
+template <bool Enabled>
+struct FiHookPolicy
+{
+  template <class MYVAL>
+  static MYVAL iew_fault(ThreadContext *tc, MYVAL value)
+  { return fi_system->iew_fault(tc, value); }
+
+  static void main_fault(ThreadContext *tc)
+  { fi_system->main_fault(tc); }
+
+  static TheISA::MachInst fetch_fault(ThreadContext *tc, TheISA::MachInst cur_instr)
+  { return fi_system->fetch_fault(tc, cur_instr); }
+
+  static StaticInstPtr decode_fault(ThreadContext *tc, StaticInstPtr cur_instr)
+  { return fi_system->decode_fault(tc, cur_instr); }
+
+  static void struct_fault(ThreadContext *tc)
+  { fi_system->struct_fault(tc); }
+
+  static void increaseTicks(ThreadContext *tc, int curCpu, uint64_t ticks){
+    if (tc->getFiThread() && FullSystem && TheISA::inUserMode(tc))
+      fi_system->increaseTicks(curCpu, tc->getFiThread(), ticks);
+  }
+
+  static void profile_regs(ThreadContext *tc, const StaticInstPtr &inst, Fault fault)
+  {
+    if (fi_system->profiling() && tc->getFiThread())
+      fi_system->profile_regs(tc, inst, fault);
+  }
+
+  static void profile_pc(ThreadContext *tc, Addr pc)
+  {
+    if (fi_system->profiling() && tc->getFiThread())
+      fi_system->profile_pc(tc, pc);
+  }
+};
+
+template <>
+struct FiHookPolicy<false>
+{
+  template <class MYVAL>
+  static MYVAL iew_fault(ThreadContext *tc, MYVAL value) { return value; }
+
+  static void main_fault(ThreadContext *tc) {}
+
+  static TheISA::MachInst fetch_fault(ThreadContext *tc, TheISA::MachInst cur_instr)
+  { return cur_instr; }
+
+  static StaticInstPtr decode_fault(ThreadContext *tc, StaticInstPtr cur_instr)
+  { return cur_instr; }
+
+  static void struct_fault(ThreadContext *tc) {}
+
+  static void increaseTicks(ThreadContext *tc, int curCpu, uint64_t ticks) {}
+
+  static void profile_regs(ThreadContext *tc, const StaticInstPtr &inst, Fault fault) {}
+
+  static void profile_pc(ThreadContext *tc, Addr pc) {}
+};
 
+typedef FiHookPolicy<FI_ON> FiHooks;
 
 #endif //_FI_SYSTEM
\ No newline at end of file
@@ -5,13 +5,20 @@
 
 using namespace std;
 
-GeneralFetchInjectedFault::GeneralFetchInjectedFault(std::ifstream &os)
+GeneralFetchInjectedFault::GeneralFetchInjectedFault(std::istream &os)
   : O3CPUInjectedFault(os)
 {
   setFaultType(InjectedFault::GeneralFetchInjectedFault);
   fi_system->fetchStageInjectedFaultQueue.insert(this);
 }
 
+GeneralFetchInjectedFault::GeneralFetchInjectedFault(const FaultRecord &r, int whereId)
+  : O3CPUInjectedFault(r, whereId)
+{
+  setFaultType(InjectedFault::GeneralFetchInjectedFault);
+  fi_system->fetchStageInjectedFaultQueue.insert(this);
+}
+
 GeneralFetchInjectedFault::~GeneralFetchInjectedFault()
 {
 }
@@ -40,7 +47,7 @@ GeneralFetchInjectedFault::process(TheISA::MachInst inst)
   DPRINTF(FaultInjection, "===GeneralFetchStageInjectedFault::process()===\n");
   dump();
   
-  retInst = manifest(inst, getValue(), getValueType());
+  retInst = manifest(inst);
 
   check4reschedule();
 
@@ -17,7 +17,8 @@ class GeneralFetchInjectedFault : public O3CPUInjectedFault
 
 public:
 
-  GeneralFetchInjectedFault(std::ifstream &os);
+  GeneralFetchInjectedFault(std::istream &os);
+  GeneralFetchInjectedFault(const FaultRecord &r, int whereId);
   ~GeneralFetchInjectedFault();
 
   virtual const char *description() const;
@@ -5,13 +5,20 @@
 
 using namespace std;
 
-IEWStageInjectedFault::IEWStageInjectedFault(std::ifstream &os)
+IEWStageInjectedFault::IEWStageInjectedFault(std::istream &os)
   : O3CPUInjectedFault(os)
 {
   setFaultType(InjectedFault::ExecutionInjectedFault);
   fi_system->iewStageInjectedFaultQueue.insert(this);
 }
 
+IEWStageInjectedFault::IEWStageInjectedFault(const FaultRecord &r, int whereId)
+  : O3CPUInjectedFault(r, whereId)
+{
+  setFaultType(InjectedFault::ExecutionInjectedFault);
+  fi_system->iewStageInjectedFaultQueue.insert(this);
+}
+
 IEWStageInjectedFault::~IEWStageInjectedFault()
 {
 }
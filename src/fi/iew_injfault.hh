@@ -18,7 +18,8 @@ class IEWStageInjectedFault : public O3CPUInjectedFault
 
 public:
 
-  IEWStageInjectedFault( std::ifstream &os);
+  IEWStageInjectedFault( std::istream &os);
+  IEWStageInjectedFault(const FaultRecord &r, int whereId);
   ~IEWStageInjectedFault();
 
   virtual const char *description() const;
@@ -66,7 +67,7 @@ public:
     DPRINTF(FaultInjection, "===IEWStageInjectedFault::process(T)===\n");
     
 #ifdef ALPHA_ISA
-  retVal = manifest(v, getValue(), getValueType());
+  retVal = manifest(v);
 #endif
 #ifndef ALPHA_ISA
     assert(0);
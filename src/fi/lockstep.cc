@@ -0,0 +1,362 @@
+#include <cstring>
+
+#include "config/the_isa.hh"
+#include "cpu/simple/atomic.hh"
+#include "cpu/pc_event.hh"
+#include "cpu/simple_thread.hh"
+#include "fi/addr_trigger.hh"
+#include "fi/fi_system.hh"
+#include "fi/lockstep.hh"
+#include "fi/reg_injfault.hh"
+#include "sim/system.hh"
+
+using namespace std;
+
+LockstepLanes::LockstepLanes(AtomicSimpleCPU *_cpu, SimpleThread *_thread)
+  : cpu(_cpu), thread(_thread), numSrc(0), numDest(0), probing(false),
+    probe(NULL), probed(false)
+{
+}
+
+// -1 for the misc registers, the lanes do not carry them
+int
+LockstepLanes::flatten(int idx) const
+{
+  if (idx < TheISA::FP_Base_DepTag)
+    return thread->flattenIntIndex(idx);
+  if (idx < TheISA::Ctrl_Base_DepTag)
+    return TheISA::NumIntRegs + thread->flattenFloatIndex(idx - TheISA::FP_Base_DepTag);
+  return -1;
+}
+
+uint64_t
+LockstepLanes::readReg(int flat) const
+{
+  if (flat < TheISA::NumIntRegs)
+    return thread->readIntRegFlat(flat);
+  return thread->readFloatRegBitsFlat(flat - TheISA::NumIntRegs);
+}
+
+void
+LockstepLanes::setReg(int flat, uint64_t val)
+{
+  if (flat < TheISA::NumIntRegs)
+    thread->setIntRegFlat(flat, val);
+  else
+    thread->setFloatRegBitsFlat(flat - TheISA::NumIntRegs, val);
+}
+
+bool
+LockstepLanes::accepts(RegisterInjectedFault *f) const
+{
+  return f->isTransientDataReg() && f->getTContext() == 0;
+}
+
+bool
+LockstepLanes::add(RegisterInjectedFault *f, uint64_t id)
+{
+  Lane lane;
+  lane.id = id;
+  lane.tick = curTick();
+  lane.pending = false;
+  lane.follow = false;
+
+  //the value process() would write, the golden register is left as is
+  int reg = f->getRegister();
+  int flat;
+  uint64_t golden, val;
+  if (f->isFloatReg()) {
+    flat = TheISA::NumIntRegs + thread->flattenFloatIndex(reg);
+    golden = thread->readFloatRegBits(reg);
+  }
+  else {
+    flat = thread->flattenIntIndex(reg);
+    golden = thread->readIntReg(reg);
+  }
+  //the masks apply to the bits of a float register as they are
+  val = f->manifest(golden);
+
+  if (val == golden) {
+    fi_system->lane_masked(id, lane.tick);
+    return false;
+  }
+
+  lane.diff.set(flat);
+  lane.regs[flat] = val;
+  lanes.push_back(lane);
+  any.set(flat);
+  if (DTRACE(FaultInjection))
+    std::cout << "LockstepLanes: fault " << id << " carried as lane " << lanes.size() - 1 << "\n";
+  return true;
+}
+
+void
+LockstepLanes::refresh()
+{
+  any.reset();
+  for (size_t i = 0; i < lanes.size(); i++)
+    any |= lanes[i].diff;
+}
+
+void
+LockstepLanes::retire(size_t i)
+{
+  if (DTRACE(FaultInjection))
+    std::cout << "LockstepLanes: fault " << lanes[i].id << " converged\n";
+  fi_system->lane_masked(lanes[i].id, lanes[i].tick);
+  lanes.erase(lanes.begin() + i);
+}
+
+// true in the forked experiment, which goes on with the registers of the lane
+bool
+LockstepLanes::split(size_t i)
+{
+  Lane lane = lanes[i];
+  lanes.erase(lanes.begin() + i);
+  if (DTRACE(FaultInjection))
+    std::cout << "LockstepLanes: fault " << lane.id << " diverged\n";
+  if (!fi_system->split_lane(lane.id, lane.tick))
+    return false;
+
+  lanes.clear();
+  any.reset();
+  probed = false;
+  for (int r = 0; r < NumLaneRegs; r++)
+    if (lane.diff[r])
+      setReg(r, lane.regs[r]);
+  return true;
+}
+
+void
+LockstepLanes::splitAll()
+{
+  while (!lanes.empty())
+    if (split(0))
+      return;
+  any.reset();
+}
+
+void
+LockstepLanes::pcEvent(Addr pc)
+{
+  //the Addr triggers of the faults do not touch the thread
+  if (AddrTriggerEvent::othersAt(cpu->system->pcEventQueue, pc))
+    splitAll();
+}
+
+void
+LockstepLanes::finish(const std::string &cause, int code)
+{
+  //nothing told the lanes apart from the golden run up to its end
+  for (size_t i = 0; i < lanes.size(); i++)
+    fi_system->write_result(lanes[i].id, lanes[i].tick, code, cause);
+  lanes.clear();
+  any.reset();
+}
+
+/*
+ * Executes inst with the registers of the lane (of the golden thread if
+ * NULL) and puts the registers and pc back.
+ */
+void
+LockstepLanes::run(const StaticInstPtr &inst, const Lane *lane, Probe &p)
+{
+  uint64_t savedSrc[TheISA::MaxInstSrcRegs];
+  uint64_t savedDest[TheISA::MaxInstDestRegs];
+  TheISA::PCState pc = thread->pcState();
+
+  for (int i = 0; i < numSrc; i++)
+    if (src[i] >= 0)
+      savedSrc[i] = readReg(src[i]);
+  for (int i = 0; i < numDest; i++)
+    if (dest[i] >= 0)
+      savedDest[i] = readReg(dest[i]);
+  if (lane)
+    for (int i = 0; i < numSrc; i++)
+      if (src[i] >= 0 && lane->diff[src[i]])
+	setReg(src[i], lane->regs[src[i]]);
+
+  p.accesses = 0;
+  probe = &p;
+  probing = true;
+  fi_system->set_probing(true);
+  p.fault = inst->execute(cpu, NULL);
+  fi_system->set_probing(false);
+  probing = false;
+  probe = NULL;
+
+  p.pc = thread->pcState();
+  for (int i = 0; i < numDest; i++)
+    p.dest[i] = dest[i] >= 0 ? readReg(dest[i]) : 0;
+
+  for (int i = 0; i < numDest; i++)
+    if (dest[i] >= 0)
+      setReg(dest[i], savedDest[i]);
+  for (int i = 0; i < numSrc; i++)
+    if (src[i] >= 0)
+      setReg(src[i], savedSrc[i]);
+  thread->pcState(pc);
+}
+
+// true if the lane goes on in lockstep after the instruction
+bool
+LockstepLanes::same(const StaticInstPtr &inst, const Probe &l, const Probe &g) const
+{
+  if (l.fault != NoFault || g.fault != NoFault || !(l.pc == g.pc))
+    return false;
+  if (!inst->isMemRef())
+    return l.accesses == 0 && g.accesses == 0;
+  return l.accesses == 1 && g.accesses == 1 && l.write == g.write &&
+    l.addr == g.addr && l.size == g.size && l.flags == g.flags &&
+    (!l.write || l.data == g.data);
+}
+
+void
+LockstepLanes::before(const StaticInstPtr &inst)
+{
+  numSrc = inst->numSrcRegs();
+  numDest = inst->numDestRegs();
+  srcSet.reset();
+  destSet.reset();
+  bool misc = false;
+  for (int i = 0; i < numSrc; i++)
+    if ((src[i] = flatten(inst->srcRegIdx(i))) >= 0)
+      srcSet.set(src[i]);
+  for (int i = 0; i < numDest; i++) {
+    if ((dest[i] = flatten(inst->destRegIdx(i))) >= 0)
+      destSet.set(dest[i]);
+    else
+      misc = true;
+  }
+  probed = false;
+
+  //preExecute has just zeroed the zero registers of the golden thread
+  RegSet zero;
+  zero.set(thread->flattenIntIndex(TheISA::ZeroReg));
+#if THE_ISA == ALPHA_ISA
+  zero.set(TheISA::NumIntRegs + thread->flattenFloatIndex(TheISA::ZeroReg));
+#endif
+  if ((any & zero).any()) {
+    for (size_t i = 0; i < lanes.size();) {
+      lanes[i].diff &= ~zero;
+      if (lanes[i].diff.none())
+	retire(i);
+      else
+	i++;
+    }
+    refresh();
+  }
+
+  bool implicit = misc || inst->isNonSpeculative() || inst->isSerializing() ||
+    inst->isSyscall() || inst->isIprAccess() || inst->isQuiesce() ||
+    inst->isUnverifiable() || inst->isStoreConditional();
+  if (implicit && !lanes.empty()) {
+    splitAll();
+    return;
+  }
+  if ((srcSet & any).none())
+    return;
+
+  Probe golden;
+  bool goldenRun = false;
+  for (size_t i = 0; i < lanes.size();) {
+    Lane &lane = lanes[i];
+    lane.pending = false;
+    if ((lane.diff & srcSet).none()) {
+      i++;
+      continue;
+    }
+
+    if (!goldenRun) {
+      run(inst, NULL, golden);
+      goldenRun = true;
+    }
+    Probe p;
+    run(inst, &lane, p);
+    if (!same(inst, p, golden)) {
+      if (split(i))
+	return;
+      continue;
+    }
+
+    //a load reads what the golden one reads, a branch links the same pc
+    lane.pending = true;
+    lane.follow = inst->isMemRef() || inst->isControl();
+    memcpy(lane.dest, p.dest, sizeof(lane.dest));
+    probed = true;
+    i++;
+  }
+  refresh();
+}
+
+void
+LockstepLanes::after(Fault fault)
+{
+  //a faulting instruction writes no register, in the lanes neither
+  if (fault != NoFault || (!probed && (destSet & any).none())) {
+    for (size_t i = 0; probed && i < lanes.size(); i++)
+      lanes[i].pending = false;
+    probed = false;
+    return;
+  }
+
+  for (size_t i = 0; i < lanes.size();) {
+    Lane &lane = lanes[i];
+    if (lane.pending && !lane.follow) {
+      for (int d = 0; d < numDest; d++) {
+	if (dest[d] < 0)
+	  continue;
+	if (lane.dest[d] == readReg(dest[d]))
+	  lane.diff.reset(dest[d]);
+	else {
+	  lane.diff.set(dest[d]);
+	  lane.regs[dest[d]] = lane.dest[d];
+	}
+      }
+    }
+    else
+      lane.diff &= ~destSet;
+    lane.pending = false;
+
+    if (lane.diff.none())
+      retire(i);
+    else
+      i++;
+  }
+  probed = false;
+  refresh();
+}
+
+Fault
+LockstepLanes::probeRead(Addr addr, uint8_t *data, unsigned size, unsigned flags)
+{
+  if (probe->accesses++ == 0) {
+    probe->write = false;
+    probe->addr = addr;
+    probe->size = size;
+    probe->flags = flags;
+    probe->data = 0;
+  }
+  memset(data, 0, size);
+  return NoFault;
+}
+
+Fault
+LockstepLanes::probeWrite(uint8_t *data, unsigned size, Addr addr, unsigned flags,
+			  uint64_t *res)
+{
+  if (probe->accesses++ == 0) {
+    probe->write = true;
+    probe->addr = addr;
+    probe->size = size;
+    probe->flags = flags;
+    probe->data = 0;
+    if (size > sizeof(probe->data))
+      probe->accesses++; //never the same as the golden one
+    else if (data)
+      memcpy(&probe->data, data, size);
+  }
+  if (res)
+    *res = 0;
+  return NoFault;
+}
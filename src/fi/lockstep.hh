@@ -0,0 +1,132 @@
+#ifndef __FI_LOCKSTEP_HH__
+#define __FI_LOCKSTEP_HH__
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "arch/registers.hh"
+#include "base/types.hh"
+#include "cpu/static_inst.hh"
+#include "sim/faults.hh"
+
+class AtomicSimpleCPU;
+class SimpleThread;
+class RegisterInjectedFault;
+
+/*
+ * Lockstep lanes: in a campaign the golden run of an atomic cpu carries
+ * the transient register faults of its thread as lanes instead of forking
+ * an experiment for each of them. A lane only keeps the integer and float
+ * registers (flattened) it differs in from the golden thread.
+ *
+ * An instruction that reads none of them computes the same in the lane,
+ * the lane then takes the golden value of the registers it writes. One
+ * that does is executed once more in probe mode with the registers of the
+ * lane, and once as the golden run, before the golden execution: memory
+ * accesses are only recorded and the registers and pc are put back after,
+ * and the execute hooks of fault injection do not see it (set_probing).
+ * The lane goes on in lockstep if both probes agree on the fault, next
+ * pc, memory address and store data, and is split off otherwise: the
+ * experiment is forked right there, before the instruction executes, with
+ * the registers of the lane. Instructions with side effects or implicit
+ * register reads (pal calls, pseudo instructions, ipr accesses, store
+ * conditionals) and pc events split every lane that differs at all.
+ *
+ * A lane whose registers are all back to the golden ones is masked.
+ */
+class LockstepLanes
+{
+  public:
+    static const int NumLaneRegs = TheISA::NumIntRegs + TheISA::NumFloatRegs;
+    typedef std::bitset<NumLaneRegs> RegSet;
+
+  private:
+    struct Lane
+    {
+      uint64_t id;       // position of the fault in the fault file
+      Tick tick;         // when the fault was applied
+      RegSet diff;       // registers that differ from the golden thread
+      uint64_t regs[NumLaneRegs];
+      bool pending;      // the lane computed its own destination values
+      bool follow;       // ...or takes the golden ones (loads, branches)
+      uint64_t dest[TheISA::MaxInstDestRegs];
+    };
+
+    // what a probe execution did
+    struct Probe
+    {
+      Fault fault;
+      TheISA::PCState pc;
+      int accesses;
+      bool write;
+      Addr addr;
+      unsigned size;
+      unsigned flags;
+      uint64_t data;
+      uint64_t dest[TheISA::MaxInstDestRegs];
+    };
+
+    AtomicSimpleCPU *cpu;
+    SimpleThread *thread;
+    std::vector<Lane> lanes;
+
+    // flattened registers of the instruction about to execute
+    int numSrc;
+    int numDest;
+    int src[TheISA::MaxInstSrcRegs];
+    int dest[TheISA::MaxInstDestRegs];
+    RegSet srcSet;
+    RegSet destSet;
+    RegSet any; // union of the diff of all the lanes
+
+    bool probing;
+    Probe *probe;
+    bool probed; // some lane has been probed on the instruction
+
+    int flatten(int idx) const;
+    uint64_t readReg(int flat) const;
+    void setReg(int flat, uint64_t val);
+
+    void run(const StaticInstPtr &inst, const Lane *lane, Probe &p);
+    bool same(const StaticInstPtr &inst, const Probe &l, const Probe &g) const;
+    bool split(size_t i);
+    void retire(size_t i);
+    void refresh();
+
+  public:
+    LockstepLanes(AtomicSimpleCPU *cpu, SimpleThread *thread);
+
+    bool empty() const { return lanes.empty(); }
+    size_t size() const { return lanes.size(); }
+
+    /* true if the fault can be carried by a lane of this cpu */
+    bool accepts(RegisterInjectedFault *f) const;
+
+    /* makes a lane of the fault, false if the fault leaves the register
+     * as it is (it is reported masked right away)
+     */
+    bool add(RegisterInjectedFault *f, uint64_t id);
+
+    /* called before and after the golden execution of inst, before()
+     * returns in the forked experiment if a lane is split off
+     */
+    void before(const StaticInstPtr &inst);
+    void after(Fault fault);
+
+    /* a pc event at pc may read any register */
+    void pcEvent(Addr pc);
+
+    /* forks the experiment of every lane, the cpu stops carrying them */
+    void splitAll();
+
+    /* writes the outcome of the lanes still carried when the golden run exits */
+    void finish(const std::string &cause, int code);
+
+    bool isProbing() const { return probing; }
+    Fault probeRead(Addr addr, uint8_t *data, unsigned size, unsigned flags);
+    Fault probeWrite(uint8_t *data, unsigned size, Addr addr, unsigned flags,
+                     uint64_t *res);
+};
+
+#endif // __FI_LOCKSTEP_HH__
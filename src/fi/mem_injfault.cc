@@ -4,7 +4,7 @@
 #include "arch/alpha/vtophys.hh"
 using namespace std;
 
-MemoryInjectedFault::MemoryInjectedFault(std::ifstream &os)
+MemoryInjectedFault::MemoryInjectedFault(std::istream &os)
 	: CPUInjectedFault(os){
 		int k;
 		os>>k;
@@ -17,6 +17,15 @@ MemoryInjectedFault::MemoryInjectedFault(std::ifstream &os)
 		fi_system->mainInjectedFaultQueue.insert(this);
 }
 
+MemoryInjectedFault::MemoryInjectedFault(const FaultRecord &r, int whereId)
+	: CPUInjectedFault(r, whereId){
+		setOffset(r.arg1);
+		setRegister(r.arg0);
+		setFaultType(InjectedFault::MemoryInjectedFault);
+		pMem = reinterpret_cast<PhysicalMemory *>(fi_system->find("system.physmem"));
+		fi_system->mainInjectedFaultQueue.insert(this);
+}
+
 
 
 MemoryInjectedFault::~MemoryInjectedFault()
@@ -42,39 +51,45 @@ void MemoryInjectedFault::dump() const
 
 
 
-int
-MemoryInjectedFault::process()
+AbstractMemory *
+MemoryInjectedFault::target(Addr &physical)
 {
-  range_map<Addr, AbstractMemory* > *addrMap;
-  AbstractMemory *myblock;
-  bool isphysical;
-  
-  DPRINTF(FaultInjection, "===MemoryInjectedFault::process()===\n");
-  dump();
-   
-  Addr physical;
-  
   TheISA::IntReg addr = getCPU()->getContext(getTContext())->readIntReg(getRegister()); //find the VA address
   addr+= offset; //calculate the desired VA
   physical= AlphaISA::vtophys(getCPU()->getContext(getTContext()),addr); //find the Physical Address
-  isphysical = getCPU()->system->isMemAddr(physical); //check if the address exists
+  bool isphysical = getCPU()->system->isMemAddr(physical); //check if the address exists
   
   if (DTRACE(FaultInjection)) {
     std::cout<<"\tVirtual  Address is: "<< addr<<"\n";
     std::cout<<"\tPhysical Address is : "<< physical<<"\n";
     std::cout<<"\tis physical mem : "<<isphysical<<"\n";
   }
+
+  if (!isphysical)
+    return NULL;
+  range_map<Addr, AbstractMemory* > *addrMap = (getCPU()->system->getPhysMem()).getaddrMap(); // get a map of the memory
+  range_map<Addr, AbstractMemory*>::const_iterator m = addrMap->find(physical); //find the injected block
+  assert(m != addrMap->end()); 
+  return m->second;
+}
+
+int
+MemoryInjectedFault::process()
+{
+  AbstractMemory *myblock;
   
+  DPRINTF(FaultInjection, "===MemoryInjectedFault::process()===\n");
+  dump();
+   
+  Addr physical;
+  myblock = target(physical);
   
-  if(isphysical){ //I exist so inject the fault
-    addrMap=(getCPU()->system->getPhysMem()).getaddrMap(); // get a map of the memory
-    range_map<Addr, AbstractMemory*>::const_iterator m = addrMap->find(physical); //find the injected block
-    assert(m != addrMap->end()); 
-    myblock=m->second;
+  if(myblock){ //I exist so inject the fault
     uint8_t *hostAddr = myblock->pmemAddr + physical - myblock->range.start;
     uint8_t memval=*hostAddr;
-    int8_t mask = manifest(memval, (uint8_t)getValue(), getValueType()); //alter information of the block
+    uint8_t mask = manifest(memval); //alter information of the block
     *hostAddr=mask;
+    myblock->setDirty(physical, 1); //the state digests have to see the corrupted page
   }else{
     if (DTRACE(FaultInjection)) {
       std::cout<<"I am not going to manifest since the memory does not exist";
@@ -27,7 +27,8 @@ public:
   
   PhysicalMemory *pMem;
 
-  MemoryInjectedFault(std::ifstream &os);
+  MemoryInjectedFault(std::istream &os);
+  MemoryInjectedFault(const FaultRecord &r, int whereId);
   ~MemoryInjectedFault();
 
   virtual const char *description() const;
@@ -39,6 +40,11 @@ public:
   int getOffset(){return offset;};
   
 
+  /* the memory and physical address the fault hits now, NULL if the
+   * address is not backed by a memory
+   */
+  AbstractMemory *target(Addr &physical);
+
   int process();
   
 };
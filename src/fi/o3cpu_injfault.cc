@@ -6,7 +6,7 @@
 using namespace std;
 
 
-O3CPUInjectedFault::O3CPUInjectedFault( std::ifstream &os)
+O3CPUInjectedFault::O3CPUInjectedFault( std::istream &os)
 : InjectedFault(os){
 	int t;
 	os>>t;
@@ -16,6 +16,11 @@ O3CPUInjectedFault::O3CPUInjectedFault( std::ifstream &os)
 	setTContext(t);
 }
 
+O3CPUInjectedFault::O3CPUInjectedFault(const FaultRecord &r, int whereId)
+: InjectedFault(r, whereId){
+	setTContext(r.tcontext);
+}
+
 
 O3CPUInjectedFault::~O3CPUInjectedFault()
 {
@@ -49,12 +54,8 @@ O3CPUInjectedFault:: check4reschedule(){
     getQueue()->remove(this);
     return;
   }else{
-    Tick cycles = getTiming() + getCPU()->ticks(1);
-    int insts = getTiming() + 1;
-    Addr addr = getTiming() + (getCPU()->getContext(getTContext())->pcState().nextInstAddr() - getCPU()->getContext(getTContext())->pcState().instAddr());
-    increaseTiming(cycles,insts,addr);
-    decreaseOccurrence();
-    setManifested(false);
+    ThreadContext *tc = getCPU()->getContext(getTContext());
+    rearm(getCPU()->ticks(1), tc->pcState().nextInstAddr() - tc->pcState().instAddr());
   }
 
   
@@ -24,7 +24,8 @@ private:
 
 public:
 
-  O3CPUInjectedFault(std::ifstream &os);//initialize faults from the input fstream
+  O3CPUInjectedFault(std::istream &os);//initialize faults from the input fstream
+  O3CPUInjectedFault(const FaultRecord &r, int whereId);
   ~O3CPUInjectedFault();
 
   virtual const char *description() const;
@@ -0,0 +1,94 @@
+#include "base/types.hh"
+#include "fi/faultq.hh"
+#include "fi/o3struct_injfault.hh"
+#include "fi/fi_system.hh"
+
+using namespace std;
+
+const char *O3StructInjectedFault::structNames[BaseO3CPU::NumFiStructures] = {
+  "intphys", "floatphys", "rob", "iq", "lsq"
+};
+
+O3StructInjectedFault::O3StructInjectedFault(std::istream &os)
+	:O3CPUInjectedFault(os)
+{
+	string s;
+	os>>s;
+	setStruct(s);
+	os>>_entry;
+	os>>_field;
+	fi_system->o3StructInjectedFaultQueue.insert(this);
+	setFaultType(InjectedFault::O3StructInjectedFault);
+}
+
+O3StructInjectedFault::O3StructInjectedFault(const FaultRecord &r, int whereId)
+	:O3CPUInjectedFault(r, whereId)
+{
+	_struct = (BaseO3CPU::FiStructure)r.regType;
+	_entry = r.arg0;
+	_field = r.arg1;
+	fi_system->o3StructInjectedFaultQueue.insert(this);
+	setFaultType(InjectedFault::O3StructInjectedFault);
+}
+
+O3StructInjectedFault::~O3StructInjectedFault()
+{
+}
+
+void
+O3StructInjectedFault::setStruct(std::string v)
+{
+  for (int i = 0; i < BaseO3CPU::NumFiStructures; i++) {
+    if (v.compare(structNames[i]) == 0) {
+      _struct = (BaseO3CPU::FiStructure)i;
+      return;
+    }
+  }
+  std::cout << "O3StructInjectedFault::setStruct() -- Error parsing structure " << v << "\n";
+  assert(0);
+}
+
+const char *
+O3StructInjectedFault::description() const
+{
+    return "O3StructInjectedFault";
+}
+
+void
+O3StructInjectedFault::dump() const
+{
+  if (DTRACE(FaultInjection)) {
+    std::cout << "===O3StructInjectedFault::dump()===\n";
+    O3CPUInjectedFault::dump();
+    std::cout << "\tstructure: " << structNames[getStruct()] << "\n";
+    std::cout << "\tentry: " << getEntry() << "\n";
+    std::cout << "\tfield: " << getField() << "\n";
+    std::cout << "~==O3StructInjectedFault::dump()===\n";
+  }
+}
+
+bool
+O3StructInjectedFault::occupied() const
+{
+  BaseO3CPU *cpu = dynamic_cast<BaseO3CPU *>(getCPU());
+  return cpu && cpu->fiCorrupt(getStruct(), getTContext(), getEntry(), getField(), NULL);
+}
+
+bool
+O3StructInjectedFault::process()
+{
+  DPRINTF(FaultInjection, "===O3StructInjectedFault::process() ID: %d ===\n", getFaultID());
+  dump();
+
+  BaseO3CPU *cpu = dynamic_cast<BaseO3CPU *>(getCPU());
+  bool applied = cpu && cpu->fiCorrupt(getStruct(), getTContext(), getEntry(), getField(), this);
+  if (!cpu)
+    DPRINTF(FaultInjection, "%s is not a detailed cpu, fault not applied\n", getCPU()->name());
+  else if (!applied)
+    DPRINTF(FaultInjection, "%s entry %d is empty, fault masked\n", structNames[getStruct()], getEntry());
+
+  check4reschedule();
+
+  DPRINTF(FaultInjection, "~==O3StructInjectedFault::process() ID: %d ===\n", getFaultID());
+  return applied;
+}
@@ -0,0 +1,55 @@
+#ifndef __O3STRUCT_INJECTED_FAULT_HH__
+#define __O3STRUCT_INJECTED_FAULT_HH__
+
+#include "config/the_isa.hh"
+#include "base/types.hh"
+#include "fi/faultq.hh"
+#include "fi/o3cpu_injfault.hh"
+#include "cpu/o3/cpu.hh"
+
+/*
+ * Insert a fault into an entry of a microarchitectural structure of the
+ * detailed core, checked every cycle (BaseO3CPU::fiCorrupt):
+ * intphys/floatphys ENTRY: a physical register
+ * rob ENTRY: the pc of the ENTRY-th oldest instruction of the thread
+ * iq ENTRY FIELD: the physical register tag of source operand FIELD of
+ *   the ENTRY-th oldest instruction of the thread waiting to issue
+ * lsq ENTRY: the data of the ENTRY-th oldest store of the thread that
+ *   has not been sent to memory
+ * An entry that holds nothing live at that cycle is left alone, the
+ * fault is masked.
+ */
+class O3StructInjectedFault : public O3CPUInjectedFault
+{
+public:
+  static const char *structNames[BaseO3CPU::NumFiStructures];
+
+private:
+  BaseO3CPU::FiStructure _struct;
+  unsigned _entry;
+  int _field;
+
+  void setStruct(std::string v);
+
+public:
+
+  O3StructInjectedFault(std::istream &os);
+  O3StructInjectedFault(const FaultRecord &r, int whereId);
+  ~O3StructInjectedFault();
+
+  virtual const char *description() const;
+
+  void dump() const;
+
+  /* true if the entry holds something live on the core it is set to */
+  bool occupied() const;
+
+  /* corrupts the entry, false if it was left alone */
+  bool process();
+
+  BaseO3CPU::FiStructure getStruct() const { return _struct;}
+  unsigned getEntry() const { return _entry;}
+  int getField() const { return _field;}
+};
+
+#endif // __O3STRUCT_INJECTED_FAULT_HH__
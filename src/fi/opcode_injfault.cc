@@ -8,13 +8,20 @@ using namespace std;
 
 
 
-OpCodeInjectedFault::OpCodeInjectedFault(std::ifstream &os)
+OpCodeInjectedFault::OpCodeInjectedFault(std::istream &os)
   : O3CPUInjectedFault(os)
 {
   setFaultType(InjectedFault::OpCodeInjectedFault);
   fi_system->fetchStageInjectedFaultQueue.insert(this);
 }
 
+OpCodeInjectedFault::OpCodeInjectedFault(const FaultRecord &r, int whereId)
+  : O3CPUInjectedFault(r, whereId)
+{
+  setFaultType(InjectedFault::OpCodeInjectedFault);
+  fi_system->fetchStageInjectedFaultQueue.insert(this);
+}
+
 
 OpCodeInjectedFault::~OpCodeInjectedFault()
 {
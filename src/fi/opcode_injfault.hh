@@ -16,7 +16,8 @@ class OpCodeInjectedFault : public O3CPUInjectedFault
 
 public:
 
-  OpCodeInjectedFault(std::ifstream &os);
+  OpCodeInjectedFault(std::istream &os);
+  OpCodeInjectedFault(const FaultRecord &r, int whereId);
   ~OpCodeInjectedFault();
 
   virtual const char *description() const;
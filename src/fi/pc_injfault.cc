@@ -7,12 +7,18 @@
 using namespace std;
 
 
-PCInjectedFault::PCInjectedFault( std::ifstream &os)
+PCInjectedFault::PCInjectedFault( std::istream &os)
 	:CPUInjectedFault(os){
 	 setFaultType(InjectedFault::PCInjectedFault);
 	 fi_system->mainInjectedFaultQueue.insert(this);
 }
 
+PCInjectedFault::PCInjectedFault(const FaultRecord &r, int whereId)
+	:CPUInjectedFault(r, whereId){
+	 setFaultType(InjectedFault::PCInjectedFault);
+	 fi_system->mainInjectedFaultQueue.insert(this);
+}
+
 PCInjectedFault::~PCInjectedFault()
 {
 }
@@ -44,7 +50,7 @@ PCInjectedFault::process()
   dump();
   uint64_t pcval = getCPU()->getContext(getTContext())->pcState().instAddr();
   DPRINTF(FaultInjection, "\tPC value before FI: %lx\n", pcval);
-  uint64_t mask = manifest(pcval, getValue(), getValueType());
+  uint64_t mask = manifest(pcval);
   getCPU()->getContext(getTContext())->pcState(TheISA::PCState(mask));
   
   check4reschedule();
@@ -14,7 +14,8 @@
 class PCInjectedFault : public CPUInjectedFault
 {
 public:
-  PCInjectedFault( std::ifstream &os);
+  PCInjectedFault( std::istream &os);
+  PCInjectedFault(const FaultRecord &r, int whereId);
   ~PCInjectedFault();
 
   virtual const char *description() const;
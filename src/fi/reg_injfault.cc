@@ -11,7 +11,7 @@
 using namespace std;
 
 
-RegisterInjectedFault::RegisterInjectedFault(ifstream &os)
+RegisterInjectedFault::RegisterInjectedFault(std::istream &os)
 	: CPUInjectedFault(os)
 {
 	setFaultType(InjectedFault::RegisterInjectedFault);
@@ -24,6 +24,16 @@ RegisterInjectedFault::RegisterInjectedFault(ifstream &os)
 	fi_system->mainInjectedFaultQueue.insert(this);
 }
 
+RegisterInjectedFault::RegisterInjectedFault(const FaultRecord &r, int whereId)
+	: CPUInjectedFault(r, whereId)
+{
+	setFaultType(InjectedFault::RegisterInjectedFault);
+	//the records number int, float, misc from 0
+	setRegType((RegisterType)(r.regType + 1));
+	setRegister(r.arg0);
+	fi_system->mainInjectedFaultQueue.insert(this);
+}
+
 RegisterInjectedFault::~RegisterInjectedFault()
 {
 }
@@ -61,21 +71,21 @@ RegisterInjectedFault::process()
     case(RegisterInjectedFault::IntegerRegisterFault):
       {
 	TheISA::IntReg regval = getCPU()->getContext(getTContext())->readIntReg(getRegister());
-	TheISA::IntReg mask = manifest(regval, getValue(), getValueType());
+	TheISA::IntReg mask = manifest(regval);
 	getCPU()->getContext(getTContext())->setIntReg(getRegister(), mask);
 	break;
       }
     case(RegisterInjectedFault::FloatRegisterFault):
       {
 	TheISA::FloatReg regval = getCPU()->getContext(getTContext())->readFloatReg(getRegister());
-	TheISA::FloatReg mask = manifest(regval, getValue(), getValueType());
+	TheISA::FloatReg mask = manifest(regval);
 	getCPU()->getContext(getTContext())->setFloatReg(getRegister(), mask);
 	break;
       }
     case(RegisterInjectedFault::MiscRegisterFault):
       {
 	TheISA::MiscReg regval = getCPU()->getContext(getTContext())->readMiscReg(getRegister());
-	TheISA::MiscReg mask = manifest(regval, getValue(), getValueType());
+	TheISA::MiscReg mask = manifest(regval);
 	getCPU()->getContext(getTContext())->setMiscReg(getRegister(), mask);
 	break;
       }
@@ -50,7 +50,8 @@ private:
 
 public:
 
-  RegisterInjectedFault( std::ifstream &os);
+  RegisterInjectedFault( std::istream &os);
+  RegisterInjectedFault(const FaultRecord &r, int whereId);
   ~RegisterInjectedFault();
 
 
@@ -64,6 +65,15 @@ public:
   int getRegister() const { return _register;}
   RegisterType getRegType() const { return _regType;}
 
+  /* a transient fault of an integer or float register, the only ones a
+   * lockstep lane can carry
+   */
+  bool isTransientDataReg() const
+  {
+    return _regType != MiscRegisterFault && getOccurrence() == 1;
+  }
+  bool isFloatReg() const { return _regType == FloatRegisterFault; }
+
 };
 
 #endif // __REGISTER_INJECTED_FAULT_HH__
@@ -0,0 +1,125 @@
+#include <fstream>
+
+#include "base/misc.hh"
+#include "fi/reg_liveness.hh"
+
+using namespace std;
+
+RegLiveness::RegLiveness()
+  : events(0)
+{
+  start.setTimer();
+}
+
+void
+RegLiveness::putVarint(std::vector<uint8_t> &out, uint64_t v)
+{
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+void
+RegLiveness::close(Stream &s)
+{
+  if (s.type < 0)
+    return;
+  putVarint(s.data, ((s.last - s.prev) << 1) | s.type);
+  s.prev = s.last;
+  s.runs++;
+  s.type = -1;
+}
+
+void
+RegLiveness::record(int thread, int scope, int core, uint64_t stamp,
+		    const Event *ev, int numEvents)
+{
+  uint64_t k = key(thread, scope, core);
+  std::map<uint64_t, RegStreams>::iterator it = streams.find(k);
+  if (it == streams.end()) {
+    RegStreams rs;
+    for (int r = 0; r < NumRegs; r++) {
+      rs.regs[r].type = -1;
+      rs.regs[r].last = 0;
+      rs.regs[r].prev = 0;
+      rs.regs[r].runs = 0;
+    }
+    it = streams.insert(make_pair(k, rs)).first;
+  }
+
+  for (int i = 0; i < numEvents; i++) {
+    Stream &s = it->second.regs[ev[i].reg];
+    //a read ends the gap of the faults it uses, only writes in a row
+    //(or the reads of a single instruction) are kept as one run
+    if (s.type != ev[i].type || (s.type == Read && s.last != stamp)) {
+      close(s);
+      s.type = ev[i].type;
+    }
+    s.last = stamp;
+  }
+  events += numEvents;
+
+  uint64_t &end = ends[key(thread, scope, 0)];
+  if (stamp + 1 > end)
+    end = stamp + 1;
+}
+
+/*
+ * "M5FIRLV1", the core names, the host milliseconds of the run, the ends
+ * of each thread and scope and the non empty streams, all as varints
+ * (thread and scope are stored plus one).
+ */
+void
+RegLiveness::write(const std::string &path, const std::vector<std::string> &coreNames)
+{
+  Time now;
+  now.setTimer();
+  double seconds = now - start;
+
+  std::vector<uint8_t> out;
+  const char magic[] = "M5FIRLV1";
+  out.insert(out.end(), magic, magic + 8);
+
+  putVarint(out, coreNames.size());
+  for (size_t i = 0; i < coreNames.size(); i++) {
+    putVarint(out, coreNames[i].size());
+    out.insert(out.end(), coreNames[i].begin(), coreNames[i].end());
+  }
+  putVarint(out, (uint64_t)(seconds * 1000));
+
+  putVarint(out, ends.size());
+  for (std::map<uint64_t, uint64_t>::iterator it = ends.begin(); it != ends.end(); ++it) {
+    putVarint(out, it->first >> 40);
+    putVarint(out, (it->first >> 20) & 0xfffff);
+    putVarint(out, it->second);
+  }
+
+  uint64_t numStreams = 0;
+  for (std::map<uint64_t, RegStreams>::iterator it = streams.begin(); it != streams.end(); ++it)
+    for (int r = 0; r < NumRegs; r++) {
+      close(it->second.regs[r]);
+      if (it->second.regs[r].runs)
+	numStreams++;
+    }
+  putVarint(out, numStreams);
+  for (std::map<uint64_t, RegStreams>::iterator it = streams.begin(); it != streams.end(); ++it)
+    for (int r = 0; r < NumRegs; r++) {
+      Stream &s = it->second.regs[r];
+      if (!s.runs)
+	continue;
+      putVarint(out, it->first >> 40);
+      putVarint(out, (it->first >> 20) & 0xfffff);
+      putVarint(out, it->first & 0xfffff);
+      putVarint(out, r);
+      putVarint(out, s.runs);
+      putVarint(out, s.data.size());
+      out.insert(out.end(), s.data.begin(), s.data.end());
+    }
+
+  ofstream f(path.c_str(), ios::binary);
+  if (!f)
+    fatal("RegLiveness: unable to open %s\n", path);
+  f.write((const char *)&out[0], out.size());
+}
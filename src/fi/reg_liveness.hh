@@ -0,0 +1,85 @@
+#ifndef __FI_REG_LIVENESS_HH__
+#define __FI_REG_LIVENESS_HH__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "arch/registers.hh"
+#include "base/time.hh"
+#include "base/types.hh"
+
+/*
+ * Register liveness profile of a golden run. Every access of a thread to
+ * an architectural integer or float register is stamped with the counter
+ * a register fault of the same scope is timed with, minus one: a fault at
+ * timing t is applied before the instruction stamped t. Writes in a row
+ * are kept as a single run, only the stamp of its last access and whether
+ * it reads or writes are stored (as a varint of the distance to the
+ * previous run); reads only share a run within an instruction.
+ *
+ * A fault at t is live if the first run whose last stamp is >= t reads the
+ * register, and dead (overwritten or never read again) otherwise. Faults
+ * of the same register and value before the same run are equivalent.
+ *
+ * Streams are kept per thread (or all threads), scope core (or all cores)
+ * and the physical core whose registers are accessed. util/fi_prune.py
+ * reads the profile to drop the dead faults of a fault file.
+ */
+class RegLiveness
+{
+  public:
+    static const int NumRegs = TheISA::NumIntArchRegs + TheISA::NumFloatArchRegs;
+    enum Access { Read = 0, Write = 1 };
+
+    /* an access of one instruction, reg is a flat index (floats after the integers) */
+    struct Event
+    {
+      int reg;
+      Access type;
+    };
+
+  private:
+    struct Stream
+    {
+      int type;        // kind of the open run, -1 before the first access
+      uint64_t last;   // stamp of the last access of the open run
+      uint64_t prev;   // last stamp of the previous run
+      uint64_t runs;
+      std::vector<uint8_t> data;
+    };
+
+    struct RegStreams
+    {
+      Stream regs[NumRegs];
+    };
+
+    // key() of thread, scope and core
+    std::map<uint64_t, RegStreams> streams;
+    // one past the last stamp seen for each thread and scope
+    std::map<uint64_t, uint64_t> ends;
+    uint64_t events;
+    Time start;
+
+    static uint64_t key(int thread, int scope, int core)
+    { return ((uint64_t)(thread + 1) << 40) | ((uint64_t)(scope + 1) << 20) | core; }
+
+    static void putVarint(std::vector<uint8_t> &out, uint64_t v);
+    static void close(Stream &s);
+
+  public:
+    RegLiveness();
+
+    /* records the accesses of an instruction to the streams of the thread
+     * (-1 for the streams of all threads) and scope core (-1 for all cores)
+     */
+    void record(int thread, int scope, int core, uint64_t stamp,
+		const Event *ev, int numEvents);
+
+    uint64_t numEvents() const { return events; }
+
+    /* writes the profile, core ids are the indices of coreNames */
+    void write(const std::string &path, const std::vector<std::string> &coreNames);
+};
+
+#endif // __FI_REG_LIVENESS_HH__
@@ -1,11 +1,13 @@
+#include "arch/decoder.hh"
 #include "base/types.hh"
+#include "cpu/thread_context.hh"
 #include "fi/faultq.hh"
 #include "fi/regdec_injfault.hh"
 #include "fi/fi_system.hh"
 
 using namespace std;
 
-RegisterDecodingInjectedFault::RegisterDecodingInjectedFault( std::ifstream &os)
+RegisterDecodingInjectedFault::RegisterDecodingInjectedFault( std::istream &os)
 	:O3CPUInjectedFault(os)
 {
 	string s;
@@ -15,6 +17,16 @@ RegisterDecodingInjectedFault::RegisterDecodingInjectedFault( std::ifstream &os)
 	setFaultType(InjectedFault::RegisterDecodingInjectedFault);
 }
 
+RegisterDecodingInjectedFault::RegisterDecodingInjectedFault(const FaultRecord &r, int whereId)
+	:O3CPUInjectedFault(r, whereId)
+{
+	setSrcOrDst(r.regType ? DstRegisterInjectedFault : SrcRegisterInjectedFault);
+	setRegToChange((int)r.arg0);
+	setChangeToReg((int)r.arg1);
+	fi_system->decodeStageInjectedFaultQueue.insert(this);
+	setFaultType(InjectedFault::RegisterDecodingInjectedFault);
+}
+
 
 
 RegisterDecodingInjectedFault::~RegisterDecodingInjectedFault()
@@ -46,8 +58,35 @@ RegisterDecodingInjectedFault::dump() const
   }
 }
 
+/*
+ * Decodes the machine instruction again outside of the decode cache, which
+ * gives an instruction of its own, with the register indices of the one it
+ * replaces (another fault may have changed them already).
+ */
+StaticInstPtr
+RegisterDecodingInjectedFault::clone(ThreadContext *tc, const StaticInstPtr &staticInst)
+{
+  bool keep = getOccurrence() != 1;
+  if (keep) {
+    CloneMap::iterator it = clones.find(staticInst.get());
+    if (it != clones.end())
+      return it->second.second;
+  }
+
+  assert(!staticInst->isMicroop() && !staticInst->isMacroop());
+  StaticInstPtr copy = tc->getDecoderPtr()->decodeInst(staticInst->machInst);
+  for (int i = 0; i < staticInst->numSrcRegs(); i++)
+    copy->_srcRegIdx[i] = staticInst->_srcRegIdx[i];
+  for (int i = 0; i < staticInst->numDestRegs(); i++)
+    copy->_destRegIdx[i] = staticInst->_destRegIdx[i];
+
+  if (keep)
+    clones[staticInst.get()] = std::make_pair(staticInst, copy);
+  return copy;
+}
+
 StaticInstPtr
-RegisterDecodingInjectedFault::process(StaticInstPtr staticInst)
+RegisterDecodingInjectedFault::process(ThreadContext *tc, StaticInstPtr staticInst)
 {
   int src = (int )staticInst->numSrcRegs() ;
   int dest= (int) staticInst->numDestRegs();
@@ -62,6 +101,7 @@ RegisterDecodingInjectedFault::process(StaticInstPtr staticInst)
   if (getSrcOrDst() == RegisterDecodingInjectedFault::SrcRegisterInjectedFault) {
     int rTc = getRegToChange();
       if (rTc < staticInst->numSrcRegs()) {
+	staticInst = clone(tc, staticInst);
 	staticInst->_srcRegIdx[rTc] = getChangeToReg();
       }
       else{
@@ -71,6 +111,7 @@ RegisterDecodingInjectedFault::process(StaticInstPtr staticInst)
   else {
     int rTc = getRegToChange();
       if (rTc < staticInst->numDestRegs()) {
+	staticInst = clone(tc, staticInst);
 	staticInst->_destRegIdx[rTc] = getChangeToReg();
       }
       else{
@@ -1,6 +1,9 @@
 #ifndef __REGISTER_DECODING_INJECTED_FAULT_HH__
 #define __REGISTER_DECODING_INJECTED_FAULT_HH__
 
+#include <map>
+#include <utility>
+
 #include "config/the_isa.hh"
 #include "base/types.hh"
 #include "fi/faultq.hh"
@@ -32,19 +35,33 @@ private:
   void setChangeToReg(int v){_changeToReg = v;}
   void setRegToChange(int v) {_regToChange =v;}
 
+  /*
+   * The decoded instructions are shared by the decode cache, so the fault
+   * never changes them: it corrupts a private copy instead. An intermittent
+   * or permanent fault keeps the copy it made of every instruction it hit
+   * (holding the original too, so its address is not reused) and hands the
+   * same copy to the later instances of that instruction.
+   */
+  typedef std::map<const StaticInst *, std::pair<StaticInstPtr, StaticInstPtr> > CloneMap;
+  CloneMap clones;
+
+  StaticInstPtr clone(ThreadContext *tc, const StaticInstPtr &staticInst);
+
 
 public:
 
-  RegisterDecodingInjectedFault( std::ifstream &os);
+  RegisterDecodingInjectedFault( std::istream &os);
+  RegisterDecodingInjectedFault(const FaultRecord &r, int whereId);
   ~RegisterDecodingInjectedFault();
 
   virtual const char *description() const;
   
   void dump() const;
   
-  StaticInstPtr process(StaticInstPtr inst); // StaticInstPtr contains the user visible
+  StaticInstPtr process(ThreadContext *tc, StaticInstPtr inst); // StaticInstPtr contains the user visible
 					      // Destination/source register
-					      //so set them to the desired one.
+					      //so set them to the desired one
+					      //(of a copy, see clone()).
     
   RegisterDecodingInjectedFaultType
   getSrcOrDst() const { return _srcOrDst;}
@@ -49,6 +49,15 @@ class AbstractMemory(MemObject):
     file = Param.String('', "Memory-mapped file")
     null = Param.Bool(False, "Do not store data, always return zero")
     zero = Param.Bool(False, "Initialize memory with zeros")
+    delta_checkpoints = Param.Bool(False, "After the first full image, "
+                                   "checkpoint only the pages written since")
+    raw_checkpoints = Param.Bool(False, "Checkpoint the memory uncompressed, "
+                                 "it is then mapped copy on write on restore")
+    chunked_checkpoints = Param.Bool(False, "Checkpoint the memory as "
+                                     "chunks compressed in parallel, "
+                                     "leaving out the zero pages")
+    checkpoint_threads = Param.Int(0, "Threads compressing and decompressing "
+                                   "the chunks, 0 for one per host cpu")
 
     # All memories are passed to the global physical memory, and
     # certain memories may be excluded from the global address map,
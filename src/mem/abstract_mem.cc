@@ -49,8 +49,10 @@
 #include <unistd.h>
 #include <zlib.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -59,6 +61,7 @@
 #include "debug/LLSC.hh"
 #include "debug/MemoryAccess.hh"
 #include "mem/abstract_mem.hh"
+#include "mem/chunked_image.hh"
 #include "mem/packet_access.hh"
 #include "sim/system.hh"
 
@@ -72,6 +75,13 @@ AbstractMemory::AbstractMemory(const Params *p) :
     if (size() % TheISA::PageBytes != 0)
         panic("Memory Size not divisible by page size\n");
 
+    //ALTERCODE
+    pageShift = TheISA::PageShift;
+    cptConsumer = -1;
+    accessSeq = 0;
+    timeline = NULL;
+    //~ALTERCODE
+
     if (params()->null)
         return;
 
@@ -104,8 +114,75 @@ AbstractMemory::AbstractMemory(const Params *p) :
     //If requested, initialize all the memory to 0
     if (p->zero)
         memset(pmemAddr, 0, size());
+
+    //ALTERCODE
+    if (p->delta_checkpoints)
+        cptConsumer = addDirtyConsumer();
+    //~ALTERCODE
+}
+
+//ALTERCODE
+void
+AbstractMemory::notifyWatched(Addr addr, unsigned size, bool write)
+{
+    std::map<Addr, AccessWatcher *>::iterator it = watched.lower_bound(addr);
+    while (it != watched.end() && it->first < addr + size) {
+        AccessWatcher *w = it->second;
+        Addr a = it->first;
+        watched.erase(it++);
+        w->accessed(a, write, accessSeq);
+    }
+}
+
+int
+AbstractMemory::addDirtyConsumer()
+{
+    size_t words = ((size() >> pageShift) + 63) / 64;
+    if (dirtyMap.empty())
+        dirtyMap.resize(words, 0);
+    else
+        collectDirty();
+    dirtyConsumers.push_back(std::vector<uint64_t>(words, 0));
+    return dirtyConsumers.size() - 1;
+}
+
+// Merge the pages written since the last collection into every consumer
+void
+AbstractMemory::collectDirty()
+{
+    for (size_t w = 0; w < dirtyMap.size(); w++) {
+        if (!dirtyMap[w])
+            continue;
+        for (size_t c = 0; c < dirtyConsumers.size(); c++)
+            dirtyConsumers[c][w] |= dirtyMap[w];
+        dirtyMap[w] = 0;
+    }
+}
+
+void
+AbstractMemory::getDirty(int consumer, std::vector<Addr> &pages)
+{
+    collectDirty();
+    const std::vector<uint64_t> &map = dirtyConsumers[consumer];
+    for (size_t w = 0; w < map.size(); w++) {
+        uint64_t bits = map[w];
+        while (bits) {
+            int b = __builtin_ctzll(bits);
+            pages.push_back(w * 64 + b);
+            bits &= bits - 1;
+        }
+    }
 }
 
+void
+AbstractMemory::clearDirty(int consumer)
+{
+    collectDirty();
+    std::fill(dirtyConsumers[consumer].begin(),
+              dirtyConsumers[consumer].end(), 0);
+}
+//~ALTERCODE
+
 
 AbstractMemory::~AbstractMemory()
 {
@@ -353,6 +430,10 @@ AbstractMemory::access(PacketPtr pkt)
 
     uint8_t *hostAddr = pmemAddr + pkt->getAddr() - range.start;
 
+    //ALTERCODE
+    accessSeq++;
+    //~ALTERCODE
+
     if (pkt->cmd == MemCmd::SwapReq) {
         TheISA::IntReg overwrite_val;
         bool overwrite_mem;
@@ -382,9 +463,14 @@ AbstractMemory::access(PacketPtr pkt)
                 panic("Invalid size for conditional read/write\n");
         }
 
-        if (overwrite_mem)
+        if (overwrite_mem) {
             std::memcpy(hostAddr, &overwrite_val, pkt->getSize());
+            markDirty(pkt->getAddr(), pkt->getSize());
+        }
 
+        //ALTERCODE
+        noteAccess(pkt->getAddr(), pkt->getSize(), false);
+        //~ALTERCODE
         assert(!pkt->req->isInstFetch());
         TRACE_PACKET("Read/Write");
         numOther[pkt->req->masterId()]++;
@@ -395,6 +481,9 @@ AbstractMemory::access(PacketPtr pkt)
         }
         if (pmemAddr)
             memcpy(pkt->getPtr<uint8_t>(), hostAddr, pkt->getSize());
+        //ALTERCODE
+        noteAccess(pkt->getAddr(), pkt->getSize(), false);
+        //~ALTERCODE
         TRACE_PACKET(pkt->req->isInstFetch() ? "IFetch" : "Read");
         numReads[pkt->req->masterId()]++;
         bytesRead[pkt->req->masterId()] += pkt->getSize();
@@ -402,8 +491,13 @@ AbstractMemory::access(PacketPtr pkt)
             bytesInstRead[pkt->req->masterId()] += pkt->getSize();
     } else if (pkt->isWrite()) {
         if (writeOK(pkt)) {
-            if (pmemAddr)
+            if (pmemAddr) {
                 memcpy(hostAddr, pkt->getPtr<uint8_t>(), pkt->getSize());
+                markDirty(pkt->getAddr(), pkt->getSize());
+            }
+            //ALTERCODE
+            noteAccess(pkt->getAddr(), pkt->getSize(), true);
+            //~ALTERCODE
             assert(!pkt->req->isInstFetch());
             TRACE_PACKET("Write");
             numWrites[pkt->req->masterId()]++;
@@ -431,11 +525,18 @@ AbstractMemory::functionalAccess(PacketPtr pkt)
     if (pkt->isRead()) {
         if (pmemAddr)
             memcpy(pkt->getPtr<uint8_t>(), hostAddr, pkt->getSize());
+        //ALTERCODE
+        if (timeline)
+            timeline->record(pkt->getAddr() - range.start, pkt->getSize(),
+                             false, (accessSeq << 1) | 1);
+        //~ALTERCODE
         TRACE_PACKET("Read");
         pkt->makeResponse();
     } else if (pkt->isWrite()) {
-        if (pmemAddr)
+        if (pmemAddr) {
             memcpy(hostAddr, pkt->getPtr<uint8_t>(), pkt->getSize());
+            markDirty(pkt->getAddr(), pkt->getSize());
+        }
         TRACE_PACKET("Write");
         pkt->makeResponse();
     } else if (pkt->isPrint()) {
@@ -463,6 +564,32 @@ AbstractMemory::serialize(ostream &os)
     string filename = name() + ".physmem";
     long _size = range.size();
 
+    //ALTERCODE
+    // Once a full image was written only the pages written since are saved
+    if (cptConsumer >= 0 && !deltaBase.empty()) {
+        filename = name() + ".physmem.delta";
+        SERIALIZE_SCALAR(filename);
+        SERIALIZE_SCALAR(_size);
+        paramOut(os, "delta_base", deltaBase);
+        writeDelta(Checkpoint::dir() + "/" + filename);
+    } else if (params()->raw_checkpoints) {
+        filename = name() + ".physmem.raw";
+        SERIALIZE_SCALAR(filename);
+        SERIALIZE_SCALAR(_size);
+        string thefile = Checkpoint::dir() + "/" + filename;
+        writeRaw(thefile);
+        setDeltaBase(thefile);
+    } else if (params()->chunked_checkpoints) {
+        filename = name() + ".physmem.chunked";
+        SERIALIZE_SCALAR(filename);
+        SERIALIZE_SCALAR(_size);
+        string thefile = Checkpoint::dir() + "/" + filename;
+        writeChunkedImage(thefile, pmemAddr, size(), pageBytes(),
+                          params()->checkpoint_threads);
+        setDeltaBase(thefile);
+    } else {
+    //~ALTERCODE
+
     SERIALIZE_SCALAR(filename);
     SERIALIZE_SCALAR(_size);
 
@@ -488,6 +615,11 @@ AbstractMemory::serialize(ostream &os)
         fatal("Close failed on physical memory checkpoint file '%s'\n",
               filename);
 
+    //ALTERCODE
+    setDeltaBase(thefile);
+    }
+    //~ALTERCODE
+
     list<LockedAddr>::iterator i = lockedAddrList.begin();
 
     vector<Addr> lal_addr;
@@ -507,34 +639,13 @@ AbstractMemory::unserialize(Checkpoint *cp, const string &section)
     if (!pmemAddr)
         return;
 
-    gzFile compressedMem;
-    long *tempPage;
-    long *pmem_current;
-    uint64_t curSize;
-    uint32_t bytesRead;
-    const uint32_t chunkSize = 16384;
-
     string filename;
 
     UNSERIALIZE_SCALAR(filename);
 
     filename = cp->cptDir + "/" + filename;
 
-    // mmap memoryfile
-    int fd = open(filename.c_str(), O_RDONLY);
-    if (fd < 0) {
-        perror("open");
-        fatal("Can't open physical memory checkpoint file '%s'", filename);
-    }
-
-    compressedMem = gzdopen(fd, "rb");
-    if (compressedMem == NULL)
-        fatal("Insufficient memory to allocate compression state for %s\n",
-                filename);
-
     // unmap file that was mmapped in the constructor
-    // This is done here to make sure that gzip and open don't muck with our
-    // nice large space of memory before we reallocate it
     munmap((char*)pmemAddr, size());
 
     long _size;
@@ -543,6 +654,20 @@ AbstractMemory::unserialize(Checkpoint *cp, const string &section)
         fatal("Memory size has changed! size %lld, param size %lld\n",
               _size, params()->range.size());
 
+    //ALTERCODE
+    // A delta checkpoint holds the pages written since its base image
+    string base;
+    bool delta = cp->find(section, "delta_base", base);
+    string image = delta ? base : filename;
+
+    // An uncompressed image is mapped copy on write instead of read, its
+    // pages are only faulted in when touched and are shared through the
+    // page cache by all the simulations restoring it
+    if (hasSuffix(image, ".raw")) {
+        mapRaw(image);
+    } else {
+    //~ALTERCODE
+
     pmemAddr = (uint8_t *)mmap(NULL, size(),
         PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
 
@@ -551,6 +676,54 @@ AbstractMemory::unserialize(Checkpoint *cp, const string &section)
         fatal("Could not mmap physical memory!\n");
     }
 
+    //ALTERCODE
+    if (hasSuffix(image, ".chunked"))
+        readChunkedImage(image, pmemAddr, size(),
+                         params()->checkpoint_threads);
+    else
+        readImage(image);
+    }
+
+    // any page may differ from what the consumers saw before
+    setDirty(range.start, size());
+    if (delta) {
+        setDeltaBase(base);
+        readDelta(filename);
+    } else {
+        setDeltaBase(filename);
+    }
+    //~ALTERCODE
+
+    vector<Addr> lal_addr;
+    vector<int> lal_cid;
+    arrayParamIn(cp, section, "lal_addr", lal_addr);
+    arrayParamIn(cp, section, "lal_cid", lal_cid);
+    for(int i = 0; i < lal_addr.size(); i++)
+        lockedAddrList.push_front(LockedAddr(lal_addr[i], lal_cid[i]));
+}
+
+//ALTERCODE
+void
+AbstractMemory::readImage(const string &filename)
+{
+    gzFile compressedMem;
+    long *tempPage;
+    long *pmem_current;
+    uint64_t curSize;
+    uint32_t bytesRead;
+    const uint32_t chunkSize = 16384;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        fatal("Can't open physical memory checkpoint file '%s'", filename);
+    }
+
+    compressedMem = gzdopen(fd, "rb");
+    if (compressedMem == NULL)
+        fatal("Insufficient memory to allocate compression state for %s\n",
+                filename);
+
     curSize = 0;
     tempPage = (long*)malloc(chunkSize);
     if (tempPage == NULL)
@@ -579,11 +752,142 @@ AbstractMemory::unserialize(Checkpoint *cp, const string &section)
     if (gzclose(compressedMem))
         fatal("Close failed on physical memory checkpoint file '%s'\n",
               filename);
+}
 
-    vector<Addr> lal_addr;
-    vector<int> lal_cid;
-    arrayParamIn(cp, section, "lal_addr", lal_addr);
-    arrayParamIn(cp, section, "lal_cid", lal_cid);
-    for(int i = 0; i < lal_addr.size(); i++)
-        lockedAddrList.push_front(LockedAddr(lal_addr[i], lal_cid[i]));
+// the following delta checkpoints are against this image
+void
+AbstractMemory::setDeltaBase(const string &filename)
+{
+    if (cptConsumer < 0)
+        return;
+    char *path = realpath(filename.c_str(), NULL);
+    deltaBase = path ? path : "";
+    free(path);
+    clearDirty(cptConsumer);
+}
+
+bool
+AbstractMemory::hasSuffix(const string &filename, const string &suffix)
+{
+    return filename.size() >= suffix.size() &&
+        filename.compare(filename.size() - suffix.size(), suffix.size(),
+                         suffix) == 0;
+}
+
+// The pages that are all zero are left as holes of a sparse file
+void
+AbstractMemory::writeRaw(const string &filename)
+{
+    // a memory restored from an image of that name still maps the old one
+    unlink(filename.c_str());
+    int fd = creat(filename.c_str(), 0664);
+    if (fd < 0) {
+        perror("creat");
+        fatal("Can't open physical memory checkpoint file '%s'\n", filename);
+    }
+
+    Addr bytes = pageBytes();
+    for (Addr off = 0; off < size(); off += bytes) {
+        const uint64_t *w = (const uint64_t *)(pmemAddr + off);
+        Addr i = 0;
+        while (i < bytes / sizeof(uint64_t) && !w[i])
+            i++;
+        if (i == bytes / sizeof(uint64_t))
+            continue;
+        if (pwrite(fd, pmemAddr + off, bytes, off) != (ssize_t)bytes)
+            fatal("Write failed on physical memory checkpoint file '%s'\n",
+                  filename);
+    }
+
+    if (ftruncate(fd, size()) || close(fd))
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              filename);
+}
+
+void
+AbstractMemory::mapRaw(const string &filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        fatal("Can't open physical memory checkpoint file '%s'", filename);
+    }
+
+    off_t _size = lseek(fd, 0, SEEK_END);
+    if (_size != (off_t)size())
+        fatal("Physical memory checkpoint file '%s' has %d bytes, "
+              "expected %d\n", filename, _size, size());
+
+    pmemAddr = (uint8_t *)mmap(NULL, size(), PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (pmemAddr == (void *)MAP_FAILED) {
+        perror("mmap");
+        fatal("Could not mmap physical memory checkpoint file '%s'\n",
+              filename);
+    }
+}
+
+// A delta file holds the index of every page written since the base
+// image, each followed by the page
+void
+AbstractMemory::writeDelta(const string &filename)
+{
+    vector<Addr> pages;
+    getDirty(cptConsumer, pages);
+
+    int fd = creat(filename.c_str(), 0664);
+    if (fd < 0) {
+        perror("creat");
+        fatal("Can't open physical memory checkpoint file '%s'\n", filename);
+    }
+
+    gzFile compressedMem = gzdopen(fd, "wb");
+    if (compressedMem == NULL)
+        fatal("Insufficient memory to allocate compression state for %s\n",
+                filename);
+
+    Addr bytes = pageBytes();
+    for (size_t i = 0; i < pages.size(); i++) {
+        uint64_t page = pages[i];
+        if (gzwrite(compressedMem, &page, sizeof(page)) != sizeof(page) ||
+            gzwrite(compressedMem, pmemAddr + page * bytes, bytes) != (int)bytes)
+            fatal("Write failed on physical memory checkpoint file '%s'\n",
+                  filename);
+    }
+
+    if (gzclose(compressedMem))
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              filename);
+}
+
+void
+AbstractMemory::readDelta(const string &filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        fatal("Can't open physical memory checkpoint file '%s'", filename);
+    }
+
+    gzFile compressedMem = gzdopen(fd, "rb");
+    if (compressedMem == NULL)
+        fatal("Insufficient memory to allocate compression state for %s\n",
+                filename);
+
+    Addr bytes = pageBytes();
+    uint64_t page;
+    while (gzread(compressedMem, &page, sizeof(page)) == sizeof(page)) {
+        if (page >= (size() >> pageShift) ||
+            gzread(compressedMem, pmemAddr + page * bytes, bytes) != (int)bytes)
+            fatal("Physical memory checkpoint file '%s' is corrupt\n",
+                  filename);
+        setDirty(range.start + page * bytes, bytes);
+    }
+
+    if (gzclose(compressedMem))
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              filename);
 }
+//~ALTERCODE
@@ -49,6 +49,11 @@
 #ifndef __ABSTRACT_MEMORY_HH__
 #define __ABSTRACT_MEMORY_HH__
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mem/access_timeline.hh"
 #include "mem/mem_object.hh"
 #include "params/AbstractMemory.hh"
 #include "sim/stats.hh"
@@ -67,6 +72,21 @@ class AbstractMemory : public MemObject
 {
  //ALTERCODE
   friend class MemoryInjectedFault;
+
+  public:
+
+    /**
+     * Observer of the bytes watched with watch(). accessed() is called
+     * on the next access() (functional accesses do not count) that reads
+     * or writes one of them, with the sequence number of that access in
+     * this memory, and the byte is no longer watched.
+     */
+    class AccessWatcher
+    {
+      public:
+        virtual ~AccessWatcher() {}
+        virtual void accessed(Addr addr, bool write, uint64_t seq) = 0;
+    };
   //~ALTERCODE
   
   protected:
@@ -173,6 +193,58 @@ class AbstractMemory : public MemObject
      */
     System *_system;
 
+    //ALTERCODE
+    // Pages written since the consumers last collected them, one bit
+    // per page. It stays empty (and writes skip it) until a consumer of
+    // the dirty set registers.
+    std::vector<uint64_t> dirtyMap;
+    // Dirty set of every consumer, merged from dirtyMap when collected
+    std::vector<std::vector<uint64_t> > dirtyConsumers;
+    unsigned pageShift;
+    int cptConsumer;
+    // Full image (absolute path) the memory equals, apart from the pages
+    // in the dirty set of the checkpoint consumer
+    std::string deltaBase;
+
+    void
+    markDirty(Addr addr, unsigned size)
+    {
+        if (dirtyMap.empty())
+            return;
+        Addr first = (addr - range.start) >> pageShift;
+        Addr last = (addr + size - 1 - range.start) >> pageShift;
+        for (Addr p = first; p <= last; p++)
+            dirtyMap[p >> 6] |= ULL(1) << (p & 63);
+    }
+
+    // Watched bytes and their watcher. It stays empty (and accesses
+    // skip it) unless someone watches.
+    std::map<Addr, AccessWatcher *> watched;
+    uint64_t accessSeq;
+    // Records the accesses if set, an access is stamped with twice its
+    // sequence number, a functional read after it with one more
+    AccessTimeline *timeline;
+
+    void
+    noteAccess(Addr addr, unsigned size, bool write)
+    {
+        if (!watched.empty())
+            notifyWatched(addr, size, write);
+        if (timeline)
+            timeline->record(addr - range.start, size, write, accessSeq << 1);
+    }
+
+    void notifyWatched(Addr addr, unsigned size, bool write);
+    void collectDirty();
+    void readImage(const std::string &filename);
+    void writeRaw(const std::string &filename);
+    void mapRaw(const std::string &filename);
+    static bool hasSuffix(const std::string &filename,
+                          const std::string &suffix);
+    void setDeltaBase(const std::string &filename);
+    void readDelta(const std::string &filename);
+    void writeDelta(const std::string &filename);
+    //~ALTERCODE
 
   private:
 
@@ -245,6 +317,40 @@ class AbstractMemory : public MemObject
      */
     bool isInAddrMap() const { return inAddrMap; }
 
+    //ALTERCODE
+    /**
+     * Host memory backing this memory, NULL for a null memory.
+     */
+    const uint8_t *hostAddr() const { return pmemAddr; }
+
+    /** Size of the pages the dirty set is kept for. */
+    Addr pageBytes() const { return ULL(1) << pageShift; }
+
+    /**
+     * Register a consumer of the dirty set and return its id. Every
+     * consumer sees the page indices (from the start of the memory)
+     * written by accesses, swaps or functional writes since its own last
+     * clearDirty().
+     */
+    int addDirtyConsumer();
+    void getDirty(int consumer, std::vector<Addr> &pages);
+    void clearDirty(int consumer);
+    void setDirty(Addr addr, unsigned size) { markDirty(addr, size); }
+
+    /**
+     * Watch the byte at addr until its next access, a byte has a single
+     * watcher.
+     */
+    void watch(Addr addr, AccessWatcher *w) { watched[addr] = w; }
+
+    /**
+     * Number of accesses (not functional ones) served so far, and the
+     * timeline that records them (NULL to stop recording).
+     */
+    uint64_t getAccessSeq() const { return accessSeq; }
+    void setTimeline(AccessTimeline *t) { timeline = t; }
+    //~ALTERCODE
+
     /**
      * Perform an untimed memory access and update all the state
      * (e.g. locked addresses) and statistics accordingly. The packet
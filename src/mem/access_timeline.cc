@@ -0,0 +1,164 @@
+#include <algorithm>
+
+#include "base/misc.hh"
+#include "mem/access_timeline.hh"
+
+using namespace std;
+
+void
+AccessTimeline::putVarint(std::vector<uint8_t> &out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+uint64_t
+AccessTimeline::getVarint(const std::vector<uint8_t> &in, size_t &pos)
+{
+    uint64_t v = 0;
+    for (int shift = 0; pos < in.size(); shift += 7) {
+        uint8_t b = in[pos++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (b < 0x80)
+            break;
+    }
+    return v;
+}
+
+void
+AccessTimeline::close(Line &l)
+{
+    if (l.type < 0)
+        return;
+    putVarint(l.data, ((l.last - l.prev) << 1) | (l.type == Write));
+    putVarint(l.data, (l.offset << 7) | l.len);
+    l.prev = l.last;
+    l.type = -1;
+}
+
+void
+AccessTimeline::recordLine(Addr line, unsigned offset, unsigned len,
+                           int type, uint64_t stamp)
+{
+    LineMap::iterator it = lines.find(line);
+    if (it == lines.end()) {
+        Line l;
+        l.last = l.prev = 0;
+        l.type = -1;
+        l.offset = l.len = 0;
+        it = lines.insert(make_pair(line, l)).first;
+    }
+
+    Line &l = it->second;
+    if (l.type != type || l.offset != offset || l.len != len) {
+        runs++;
+        close(l);
+        l.type = type;
+        l.offset = offset;
+        l.len = len;
+    }
+    l.last = stamp;
+}
+
+void
+AccessTimeline::record(Addr addr, unsigned size, bool write, uint64_t stamp)
+{
+    int type = write ? Write : Read;
+    while (size) {
+        unsigned offset = addr & (LineBytes - 1);
+        unsigned len = min<Addr>(size, LineBytes - offset);
+        recordLine(addr >> LineShift, offset, len, type, stamp);
+        addr += len;
+        size -= len;
+    }
+}
+
+AccessTimeline::Next
+AccessTimeline::next(Addr addr, uint64_t stamp) const
+{
+    LineMap::const_iterator it = lines.find(addr >> LineShift);
+    if (it == lines.end())
+        return None;
+
+    const Line &l = it->second;
+    unsigned b = addr & (LineBytes - 1);
+    uint64_t last = 0;
+    size_t pos = 0;
+    while (pos < l.data.size()) {
+        uint64_t v = getVarint(l.data, pos);
+        uint64_t bytes = getVarint(l.data, pos);
+        last += v >> 1;
+        unsigned offset = bytes >> 7;
+        if (last >= stamp && offset <= b && b < offset + (bytes & 0x7f))
+            return (v & 1) ? Write : Read;
+    }
+    if (l.type >= 0 && l.last >= stamp && l.offset <= b && b < l.offset + l.len)
+        return (Next)l.type;
+    return None;
+}
+
+void
+AccessTimeline::write(std::ostream &os)
+{
+    std::vector<Addr> order;
+    for (LineMap::iterator it = lines.begin(); it != lines.end(); ++it) {
+        close(it->second);
+        order.push_back(it->first);
+    }
+    sort(order.begin(), order.end());
+
+    std::vector<uint8_t> out;
+    Addr prev = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        const Line &l = lines[order[i]];
+        putVarint(out, order[i] - prev + 1);
+        putVarint(out, l.data.size());
+        out.insert(out.end(), l.data.begin(), l.data.end());
+        prev = order[i];
+        if (out.size() >= (1 << 20)) {
+            os.write((const char *)&out[0], out.size());
+            out.clear();
+        }
+    }
+    putVarint(out, 0);
+    os.write((const char *)&out[0], out.size());
+}
+
+void
+AccessTimeline::read(std::istream &is)
+{
+    lines.clear();
+    Addr line = 0;
+    while (true) {
+        uint64_t v = 0;
+        int shift = 0;
+        int c;
+        // the varints of the line header are read a byte at a time
+        std::vector<uint64_t> header;
+        while (header.size() < 2) {
+            if ((c = is.get()) == EOF)
+                panic("AccessTimeline: truncated timeline\n");
+            v |= (uint64_t)(c & 0x7f) << shift;
+            shift += 7;
+            if (c < 0x80) {
+                header.push_back(v);
+                v = 0;
+                shift = 0;
+                if (header[0] == 0)
+                    return;
+            }
+        }
+
+        line += header[0] - 1;
+        Line &l = lines[line];
+        l.last = l.prev = 0;
+        l.type = -1;
+        l.offset = l.len = 0;
+        l.data.resize(header[1]);
+        if (header[1] && !is.read((char *)&l.data[0], header[1]))
+            panic("AccessTimeline: truncated timeline\n");
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef __MEM_ACCESS_TIMELINE_HH__
+#define __MEM_ACCESS_TIMELINE_HH__
+
+#include <iostream>
+#include <vector>
+
+#include "base/hashmap.hh"
+#include "base/types.hh"
+
+/*
+ * Timeline of the accesses to a memory, kept only for the cache lines
+ * that are accessed. Each line keeps its accesses as runs: accesses in a
+ * row of the same kind to the same bytes of the line are one run, of which
+ * only the stamp of the last access is stored. A run is a varint of the
+ * distance to the previous run and its kind, and a varint of the first
+ * byte and the number of bytes it touches.
+ *
+ * next() tells what a byte corrupted just before a stamp meets first: a
+ * read (the corruption is used), a write or nothing (it is masked).
+ */
+class AccessTimeline
+{
+  public:
+    static const unsigned LineShift = 6;
+    static const Addr LineBytes = ULL(1) << LineShift;
+
+    enum Next { None, Read, Write };
+
+  private:
+    struct Line
+    {
+        uint64_t last;   // stamp of the last access of the open run
+        uint64_t prev;   // last stamp of the previous run
+        int8_t type;     // Read or Write of the open run, -1 before the first
+        uint8_t offset;  // bytes of the open run
+        uint8_t len;
+        std::vector<uint8_t> data;
+    };
+
+    typedef m5::hash_map<Addr, Line> LineMap;
+    LineMap lines;
+    uint64_t runs;
+
+    static void putVarint(std::vector<uint8_t> &out, uint64_t v);
+    static uint64_t getVarint(const std::vector<uint8_t> &in, size_t &pos);
+    static void close(Line &l);
+    void recordLine(Addr line, unsigned offset, unsigned len, int type,
+                    uint64_t stamp);
+
+  public:
+    AccessTimeline() : runs(0) {}
+
+    /**
+     * Record an access of size bytes at addr (from the start of the
+     * memory), stamps never decrease.
+     */
+    void record(Addr addr, unsigned size, bool write, uint64_t stamp);
+
+    /** First access at or after stamp that touches the byte at addr. */
+    Next next(Addr addr, uint64_t stamp) const;
+
+    size_t numLines() const { return lines.size(); }
+    uint64_t numRuns() const { return runs; }
+
+    /** Lines in the order of their address, then a zero. */
+    void write(std::ostream &os);
+    void read(std::istream &is);
+};
+
+#endif // __MEM_ACCESS_TIMELINE_HH__
@@ -0,0 +1,271 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "base/misc.hh"
+#include "mem/chunked_image.hh"
+
+using namespace std;
+
+namespace {
+
+// State shared by the workers of one image, they take the chunks in turn
+struct ChunkedImage
+{
+    int fd;
+    uint8_t *mem;
+    const uint8_t *file;
+    uint64_t size;
+    uint64_t pageBytes;
+    uint64_t chunkBytes;
+    uint64_t numChunks;
+    uint64_t *index;
+    ChunkedImageEntry *table;
+
+    volatile uint64_t nextChunk;
+    pthread_mutex_t offsetLock;
+    uint64_t nextOffset;
+    volatile bool failed;
+
+    bool
+    stored(uint64_t page) const
+    {
+        return index[page / 64] & (ULL(1) << (page % 64));
+    }
+};
+
+bool
+zeroPage(const uint8_t *page, uint64_t bytes)
+{
+    const uint64_t *w = reinterpret_cast<const uint64_t *>(page);
+    for (uint64_t i = 0; i < bytes / sizeof(uint64_t); i++)
+        if (w[i])
+            return false;
+    return true;
+}
+
+void *
+compressChunks(void *arg)
+{
+    ChunkedImage &img = *static_cast<ChunkedImage *>(arg);
+    vector<uint8_t> pages(img.chunkBytes);
+    vector<uint8_t> out(compressBound(img.chunkBytes));
+
+    uint64_t c;
+    while (!img.failed &&
+           (c = __sync_fetch_and_add(&img.nextChunk, 1)) < img.numChunks) {
+        uint64_t start = c * img.chunkBytes;
+        uint64_t end = min(start + img.chunkBytes, img.size);
+        uint64_t len = 0;
+        for (uint64_t p = start; p < end; p += img.pageBytes) {
+            if (zeroPage(img.mem + p, img.pageBytes))
+                continue;
+            // a chunk holds a whole number of index words, no other
+            // worker writes this one
+            uint64_t page = p / img.pageBytes;
+            img.index[page / 64] |= ULL(1) << (page % 64);
+            memcpy(&pages[len], img.mem + p, img.pageBytes);
+            len += img.pageBytes;
+        }
+        if (!len)
+            continue;
+
+        uLongf outLen = out.size();
+        if (compress2(&out[0], &outLen, &pages[0], len, Z_BEST_SPEED) != Z_OK) {
+            img.failed = true;
+            break;
+        }
+
+        pthread_mutex_lock(&img.offsetLock);
+        uint64_t offset = img.nextOffset;
+        img.nextOffset += outLen;
+        pthread_mutex_unlock(&img.offsetLock);
+
+        img.table[c].offset = offset;
+        img.table[c].length = outLen;
+        if (pwrite(img.fd, &out[0], outLen, offset) != (ssize_t)outLen)
+            img.failed = true;
+    }
+    return NULL;
+}
+
+void *
+decompressChunks(void *arg)
+{
+    ChunkedImage &img = *static_cast<ChunkedImage *>(arg);
+    vector<uint8_t> pages(img.chunkBytes);
+
+    uint64_t c;
+    while (!img.failed &&
+           (c = __sync_fetch_and_add(&img.nextChunk, 1)) < img.numChunks) {
+        const ChunkedImageEntry &e = img.table[c];
+        if (!e.length)
+            continue;
+
+        uint64_t start = c * img.chunkBytes;
+        uint64_t end = min(start + img.chunkBytes, img.size);
+        uLongf len = pages.size();
+        if (uncompress(&pages[0], &len, img.file + e.offset, e.length) != Z_OK) {
+            img.failed = true;
+            break;
+        }
+
+        uint64_t off = 0;
+        for (uint64_t p = start; p < end && off < len; p += img.pageBytes) {
+            if (!img.stored(p / img.pageBytes))
+                continue;
+            memcpy(img.mem + p, &pages[off], img.pageBytes);
+            off += img.pageBytes;
+        }
+    }
+    return NULL;
+}
+
+void
+runWorkers(void *(*worker)(void *), ChunkedImage &img, int threads)
+{
+    if (threads <= 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = max(1, (int)min<uint64_t>(threads, img.numChunks));
+
+    img.nextChunk = 0;
+    img.failed = false;
+    vector<pthread_t> tids(threads);
+    int started = 0;
+    for (; started < threads; started++)
+        if (pthread_create(&tids[started], NULL, worker, &img))
+            break;
+    // without any thread the work is done here
+    if (!started)
+        worker(&img);
+    for (int i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+}
+
+} // anonymous namespace
+
+void
+writeChunkedImage(const string &filename, const uint8_t *mem, uint64_t size,
+                  uint64_t pageBytes, int threads)
+{
+    ChunkedImage img;
+    img.mem = const_cast<uint8_t *>(mem);
+    img.file = NULL;
+    img.size = size;
+    img.pageBytes = pageBytes;
+    // whole index words per chunk
+    uint64_t chunkPages = max<uint64_t>(ChunkedImageChunkBytes / pageBytes / 64, 1) * 64;
+    img.chunkBytes = chunkPages * pageBytes;
+    img.numChunks = (size + img.chunkBytes - 1) / img.chunkBytes;
+
+    uint64_t pages = size / pageBytes;
+    vector<uint64_t> index((pages + 63) / 64, 0);
+    vector<ChunkedImageEntry> table(img.numChunks);
+    memset(&table[0], 0, table.size() * sizeof(ChunkedImageEntry));
+    img.index = &index[0];
+    img.table = &table[0];
+
+    ChunkedImageHeader header;
+    memcpy(header.magic, ChunkedImageMagic, sizeof(header.magic));
+    header.version = ChunkedImageVersion;
+    header.pageBytes = pageBytes;
+    header.chunkBytes = img.chunkBytes;
+    header.size = size;
+    header.numChunks = img.numChunks;
+
+    uint64_t indexOffset = sizeof(header);
+    uint64_t tableOffset = indexOffset + index.size() * sizeof(uint64_t);
+    img.nextOffset = tableOffset + table.size() * sizeof(ChunkedImageEntry);
+
+    img.fd = creat(filename.c_str(), 0664);
+    if (img.fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s': %s\n",
+              filename, strerror(errno));
+
+    pthread_mutex_init(&img.offsetLock, NULL);
+    runWorkers(compressChunks, img, threads);
+    pthread_mutex_destroy(&img.offsetLock);
+    if (img.failed)
+        fatal("Write failed on physical memory checkpoint file '%s'\n",
+              filename);
+
+    size_t indexBytes = index.size() * sizeof(uint64_t);
+    size_t tableBytes = table.size() * sizeof(ChunkedImageEntry);
+    if (pwrite(img.fd, &header, sizeof(header), 0) != sizeof(header) ||
+        pwrite(img.fd, &index[0], indexBytes, indexOffset) != (ssize_t)indexBytes ||
+        pwrite(img.fd, &table[0], tableBytes, tableOffset) != (ssize_t)tableBytes)
+        fatal("Write failed on physical memory checkpoint file '%s'\n",
+              filename);
+
+    if (close(img.fd))
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              filename);
+}
+
+void
+readChunkedImage(const string &filename, uint8_t *mem, uint64_t size,
+                 int threads)
+{
+    struct stat st;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s': %s\n",
+              filename, strerror(errno));
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(ChunkedImageHeader))
+        fatal("Physical memory checkpoint file '%s' is corrupt\n", filename);
+
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        fatal("Can't map physical memory checkpoint file '%s': %s\n",
+              filename, strerror(errno));
+
+    const ChunkedImageHeader &header =
+        *static_cast<const ChunkedImageHeader *>(base);
+    if (memcmp(header.magic, ChunkedImageMagic, sizeof(header.magic)) ||
+        header.version != ChunkedImageVersion)
+        fatal("Physical memory checkpoint file '%s' is not a version %d "
+              "chunked image\n", filename, ChunkedImageVersion);
+    if (header.size != size)
+        fatal("Physical memory checkpoint file '%s' has %d bytes, "
+              "expected %d\n", filename, header.size, size);
+
+    ChunkedImage img;
+    img.fd = -1;
+    img.mem = mem;
+    img.file = static_cast<const uint8_t *>(base);
+    img.size = size;
+    img.pageBytes = header.pageBytes;
+    img.chunkBytes = header.chunkBytes;
+    img.numChunks = header.numChunks;
+
+    uint64_t pages = size / img.pageBytes;
+    uint64_t indexBytes = (pages + 63) / 64 * sizeof(uint64_t);
+    uint64_t tableOffset = sizeof(header) + indexBytes;
+    if (img.pageBytes == 0 || img.chunkBytes % (img.pageBytes * 64) ||
+        img.numChunks != (size + img.chunkBytes - 1) / img.chunkBytes ||
+        tableOffset + img.numChunks * sizeof(ChunkedImageEntry) >
+        (uint64_t)st.st_size)
+        fatal("Physical memory checkpoint file '%s' is corrupt\n", filename);
+    img.index = (uint64_t *)(img.file + sizeof(header));
+    img.table = (ChunkedImageEntry *)(img.file + tableOffset);
+    for (uint64_t c = 0; c < img.numChunks; c++)
+        if (img.table[c].offset + img.table[c].length > (uint64_t)st.st_size)
+            fatal("Physical memory checkpoint file '%s' is truncated\n",
+                  filename);
+
+    // the chunks are read once, in any order
+    madvise(base, st.st_size, MADV_WILLNEED);
+    runWorkers(decompressChunks, img, threads);
+    munmap(base, st.st_size);
+    if (img.failed)
+        fatal("Physical memory checkpoint file '%s' is corrupt\n", filename);
+}
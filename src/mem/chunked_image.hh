@@ -0,0 +1,54 @@
+#ifndef __MEM_CHUNKED_IMAGE_HH__
+#define __MEM_CHUNKED_IMAGE_HH__
+
+#include <string>
+
+#include "base/types.hh"
+
+/*
+ * Chunked memory image of a checkpoint. The memory is cut in chunks of
+ * ChunkedImageChunkBytes, the pages of a chunk that are not all zero are
+ * deflated together by a pool of worker threads and written at the end of
+ * the file as they complete. The page index tells which pages are stored,
+ * the chunk table where the data of every chunk is, so the chunks are
+ * inflated in parallel on restore.
+ *
+ * Layout: ChunkedImageHeader, the page index (one bit per page, in 64 bit
+ * words), numChunks ChunkedImageEntry, the deflated chunks. All values are
+ * little endian.
+ */
+
+static const char ChunkedImageMagic[8] = {'M', '5', 'P', 'M', 'C', 'H', 'K', '\0'};
+static const uint32_t ChunkedImageVersion = 1;
+static const uint64_t ChunkedImageChunkBytes = ULL(4) << 20;
+
+struct ChunkedImageHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t pageBytes;
+    uint64_t chunkBytes;
+    uint64_t size;
+    uint64_t numChunks;
+};
+
+struct ChunkedImageEntry
+{
+    uint64_t offset;  // of the deflated chunk in the file
+    uint64_t length;  // 0 if all the pages of the chunk are zero
+};
+
+/**
+ * Write the size bytes at mem as a chunked image, compressing with the
+ * given number of threads (0: one per host cpu).
+ */
+void writeChunkedImage(const std::string &filename, const uint8_t *mem,
+                       uint64_t size, uint64_t pageBytes, int threads);
+
+/**
+ * Fill mem, which has to be zero, from a chunked image of size bytes.
+ */
+void readChunkedImage(const std::string &filename, uint8_t *mem,
+                      uint64_t size, int threads);
+
+#endif // __MEM_CHUNKED_IMAGE_HH__
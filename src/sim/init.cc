@@ -39,10 +39,6 @@
 #include <list>
 #include <string>
 
-#include <fstream>
-#include <dmtcpaware.h>
-
-
 
 #include "base/cprintf.hh"
 #include "base/misc.hh"
@@ -240,50 +236,6 @@ const char * __attribute__((weak)) m5MainCommands[] = {
  * Start up the M5 simulator.  This mostly vectors into the python
  * main function.
  */
-bool copyFile (const char SRC[], const char DEST[])
-{
-    std::ifstream src; // the source file
-    std::ofstream dest; // the destination file
- 
-    src.open (SRC, std::ios::binary); // open in binary to prevent jargon at the end of the buffer
-    dest.open (DEST, std::ios::binary); // same again, binary
-    if (!src.is_open() || !dest.is_open())
-        return false; // could not be copied
- 
-    dest << src.rdbuf (); // copy the content
-    dest.close (); // close destination file
-    src.close (); // close source file
- 
-    return true; // file copied successfully
-}
-
-
-void before(){
-	cout<<"DMTCP:: Starting Checkpointing Process\n";
-}
-
-
-void after(){
-	stringstream ss;
-	char* new_name = new char[100];
-	
-	string s;
-	const DmtcpLocalStatus* my_status;
-	my_status=dmtcpGetLocalStatus();
-	sprintf(new_name,"ckpt%d.dmtcp",my_status->numCheckpoints);
-	ifstream ifile(new_name);
-	if(ifile){
-	  ifile.close();
-	  remove(new_name);
-	}
-	  
-	if(!(rename(my_status->checkpointFilename,new_name)))
-		cout<<"Renamed File\n";
-	else
-		cout<<"Error \n";
-}
-
-
 int
 m5Main(int argc, char **argv)
 {
@@ -304,18 +256,6 @@ m5Main(int argc, char **argv)
     // bunch of python statements.
     
     
-    int dmtcp_attach = dmtcpInstallHooks(before,after,NULL);    
-    
-    if(dmtcp_attach!=1){
-      cout<<"DMTCP:: Error in installing HOOKS\n";
-      cout<<"I am going to continue Hoping to restart from a checkpoint\n";
-    }
-    else{
-      cout<<"DMTCP:Hooks installed successfully\n";
-    }
- 
-    
-    
     while (*command) {
         result = PyRun_String(*command, Py_file_input, dict, dict);
         if (!result) {
@@ -70,7 +70,6 @@
 #include "sim/system.hh"
 #include "sim/vptr.hh"
 
-#include <dmtcpaware.h>
 #include "fi/fi_system.hh"
 
 using namespace std;
@@ -245,6 +244,7 @@ void fi_activate_inst(ThreadContext *tc, uint64_t threadid)
     fi_system->fi_activation[_tmpAddr] = fi_system->vectorpos;
     fi_system->threadList.push_back(new ThreadEnabledFault(threadid));
     (*(fi_system->threadList[ fi_system->vectorpos ] )).setMagicInstVirtualAddr(MagicInstVirtualAddr);
+    fi_system->rebase_addr_events(fi_system->threadList[ fi_system->vectorpos ]);
     (*(fi_system->threadList[ fi_system->vectorpos ] )).dump();
     fi_system->vectorpos++;
     if(DTRACE(FaultInjection))
@@ -259,12 +259,15 @@ void fi_activate_inst(ThreadContext *tc, uint64_t threadid)
 	std::cout << "Pc Address:" << MagicInstVirtualAddr << "\n";
       }
       (*(fi_system->threadList[ fi_system->fi_activation[_tmpAddr] ] )).print_time();
+      fi_system->disarm_addr_events(fi_system->threadList[ fi_system->fi_activation[_tmpAddr] ]);
       fi_system->fi_activation[_tmpAddr] = -1;
       if(DTRACE(FaultInjection))
       {
 	std::cout<<"~===Fault Injection Deactivation Instruction===\n";
       }
   }
+  fi_system->update_fi_thread(tc, _tmpAddr);
+  fi_system->invalidate_marks();
 }
 
 void init_fi_system()
@@ -273,19 +276,14 @@ void init_fi_system()
   if(!FullSystem)
      panicFsOnlyPseudoInst("init_fi_system");
   
+  fi_system->reset();
+
+  //checkpoint the freshly initialized system, every experiment restores
+  //from it with its own fault file (see Fi_System::unserialize)
   if(fi_system->getCheck()){
-    int succeed = dmtcpCheckpoint();
-    if(succeed == 1){
-      std::cout<<"!!!FI_SYSTEM!!! Internal checkpoint successfully created terminating...\n";
-      exit(1);
-    }
-    else if(succeed == 2){
-      const DmtcpLocalStatus* my_status = dmtcpGetLocalStatus();
-      std::cout<<"Succesfuuly restored just before Initializing fault Injection " <<my_status->numCheckpoints<<"\n";
-    }
+    std::cout<<"!!!FI_SYSTEM!!! Checkpointing before fault injection starts\n";
+    exitSimLoop("checkpoint");
   }
-  
-  fi_system->reset();
 }
 void get_Pc_address(ThreadContext *tc)
 {
@@ -297,6 +295,7 @@ void get_Pc_address(ThreadContext *tc)
   fi_system->fi_activation_iter = fi_system->fi_activation.find(_tmpAddr);
   if (fi_system->fi_activation_iter != fi_system->fi_activation.end()) {
     (*(fi_system->threadList[ fi_system->fi_activation[_tmpAddr] ] )).setMagicInstVirtualAddr(  tc->pcState().instAddr());
+    fi_system->rebase_addr_events(fi_system->threadList[ fi_system->fi_activation[_tmpAddr] ]);
   }
   else{
       
@@ -51,10 +51,6 @@
 #include "sim/sim_exit.hh"
 #include "sim/sim_object.hh"
 
-//ALTERCODE
-#include <dmtcpaware.h>
-//~ALTERCODE
-
 // For stat reset hack
 #include "sim/stat_control.hh"
 
@@ -495,7 +491,7 @@ Serializable::unserialize(Checkpoint *cp, const string &section)
 void
 Serializable::serializeAll(const string &cpt_dir)
 {
-  /*  string dir = Checkpoint::setDir(cpt_dir);
+    string dir = Checkpoint::setDir(cpt_dir);
     if (mkdir(dir.c_str(), 0775) == -1 && errno != EEXIST)
             fatal("couldn't mkdir %s\n", dir);
 
@@ -508,19 +504,6 @@ Serializable::serializeAll(const string &cpt_dir)
 
     globals.serialize(outstream);
     SimObject::serializeAll(outstream);
-   */
-    
-  /* DMTCP :: CHECKPOINT INTERNAL METHOD */
-  //ALTERCODE
-  int succeed = dmtcpCheckpoint();
-  if(succeed == 1){
-    std::cout<<"Internal checkpoint successfully created \n";
-  }
-  else if(succeed == 2){
-    const DmtcpLocalStatus* my_status = dmtcpGetLocalStatus();
-    std::cout<<"Succesfuuly restored from checkpoint: " <<my_status->numCheckpoints<<"\n";
-  }
-  //~ALTERCODE
 }
 
 void
@@ -36,6 +36,9 @@
 #include "sim/sim_events.hh"
 #include "sim/sim_exit.hh"
 #include "sim/stats.hh"
+//ALTERCODE
+#include "fi/fi_system.hh"
+//~ALTERCODE
 
 using namespace std;
 
@@ -51,6 +54,11 @@ SimLoopExitEvent::SimLoopExitEvent(const std::string &_cause, int c, Tick r)
 void
 SimLoopExitEvent::process()
 {
+    //ALTERCODE
+    if (fi_system)
+        fi_system->sim_loop_exit(cause, code);
+    //~ALTERCODE
+
     // if this got scheduled on a different queue (e.g. the committed
     // instruction queue) then make a corresponding event on the main
     // queue.
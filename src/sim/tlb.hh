@@ -75,6 +75,15 @@ class BaseTLB : public SimObject
      */
     virtual MasterPort* getMasterPort() { return NULL; }
 
+    //ALTERCODE
+    /**
+     * Copy the entries of the TLB of a cpu that is switched out, so the
+     * cpu taking over does not start cold. TLBs that do not implement
+     * it start empty as before.
+     */
+    virtual void takeOverFrom(BaseTLB *old) {}
+    //~ALTERCODE
+
     class Translation
     {
       public:
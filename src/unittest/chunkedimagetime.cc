@@ -0,0 +1,100 @@
+/*
+ * Times checkpointing and restoring a memory image with a single gzip
+ * stream, as AbstractMemory::serialize does by default, and as a chunked
+ * image. The memory is mostly zero pages, like a freshly booted guest.
+ *
+ * Usage: chunkedimagetime [MB [threads]]
+ */
+
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "mem/chunked_image.hh"
+
+using namespace std;
+
+static const uint64_t pageBytes = 8192;
+
+double
+now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+uint8_t *
+allocate(uint64_t size)
+{
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (mem == MAP_FAILED)
+        panic("unable to allocate %d bytes\n", size);
+    return (uint8_t *)mem;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint64_t size = (argc > 1 ? atoi(argv[1]) : 256) * (ULL(1) << 20);
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+    const char *gzName = "chunkedimagetime.gz";
+    const char *chunkedName = "chunkedimagetime.chunked";
+
+    // a quarter of the pages hold compressible data
+    uint8_t *mem = allocate(size);
+    srandom(1);
+    for (uint64_t p = 0; p < size; p += pageBytes) {
+        if (random() % 4)
+            continue;
+        for (uint64_t i = 0; i < pageBytes; i += sizeof(uint32_t)) {
+            uint32_t v = random() % 256;
+            memcpy(mem + p + i, &v, sizeof(v));
+        }
+    }
+
+    double t = now();
+    gzFile gz = gzopen(gzName, "wb");
+    if (!gz || gzwrite(gz, mem, size) != (int)size || gzclose(gz))
+        panic("gzip write failed\n");
+    double gzWrite = now() - t;
+
+    t = now();
+    writeChunkedImage(chunkedName, mem, size, pageBytes, threads);
+    double chunkedWrite = now() - t;
+
+    uint8_t *copy = allocate(size);
+    t = now();
+    gz = gzopen(gzName, "rb");
+    if (!gz || gzread(gz, copy, size) != (int)size || gzclose(gz))
+        panic("gzip read failed\n");
+    double gzRead = now() - t;
+    if (memcmp(mem, copy, size))
+        panic("gzip image differs\n");
+    munmap(copy, size);
+
+    copy = allocate(size);
+    t = now();
+    readChunkedImage(chunkedName, copy, size, threads);
+    double chunkedRead = now() - t;
+    if (memcmp(mem, copy, size))
+        panic("chunked image differs\n");
+    munmap(copy, size);
+
+    unlink(gzName);
+    unlink(chunkedName);
+
+    cprintf("%dMB      write     read\n", size >> 20);
+    cprintf("gzip     %6.3fs  %6.3fs\n", gzWrite, gzRead);
+    cprintf("chunked  %6.3fs  %6.3fs\n", chunkedWrite, chunkedRead);
+    cprintf("speedup  %6.1fx  %6.1fx\n", gzWrite / chunkedWrite,
+            gzRead / chunkedRead);
+    return 0;
+}
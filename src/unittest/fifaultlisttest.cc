@@ -0,0 +1,135 @@
+/*
+ * Checks that the faults created from the records of a binary fault list
+ * (without going through the text format) match the faults read from the
+ * same lines of text.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "fi/fault_list.hh"
+#include "fi/faultq.hh"
+#include "fi/fi_system.hh"
+#include "fi/genfetch_injfault.hh"
+#include "fi/o3struct_injfault.hh"
+#include "fi/reg_injfault.hh"
+#include "unittest/fiparams.hh"
+
+using namespace std;
+
+FaultRecord
+record(uint8_t type, uint8_t timingType, uint64_t timing, uint8_t valueType,
+       uint64_t value, int thread, int core, int occurrence)
+{
+    FaultRecord r;
+    memset(&r, 0, sizeof(r));
+    r.type = type;
+    r.timingType = timingType;
+    r.timing = timing;
+    r.valueType = valueType;
+    r.value = value;
+    r.thread = thread;
+    r.core = core;
+    r.occurrence = occurrence;
+    return r;
+}
+
+void
+write_list(const char *path, const FaultRecord *records, int n, int inst)
+{
+    FaultListHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FaultListMagic, sizeof(h.magic));
+    h.version = FaultListVersion;
+    h.numCores = 1;
+    h.numRecords = n;
+    h.addrRecords = 0;
+    h.instRecords = inst;
+    char core[FaultListCoreNameLen];
+    memset(core, 0, sizeof(core));
+    strcpy(core, "system.cpu");
+
+    FILE *f = fopen(path, "wb");
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(core, sizeof(core), 1, f);
+    fwrite(records, sizeof(FaultRecord), n, f);
+    fclose(f);
+}
+
+// the fault of the queue read from text is the one after its record
+void
+compare(InjectedFaultQueue &q, const char *what)
+{
+    InjectedFault *b = q.head;
+    InjectedFault *t = b ? b->nxt : NULL;
+    if (!t || t->nxt)
+        panic("%s: expected a record and a text fault\n", what);
+    if (b->getFaultType() != t->getFaultType() ||
+        b->getTimingType() != t->getTimingType() ||
+        b->getTiming() != t->getTiming() ||
+        b->getValueType() != t->getValueType() ||
+        b->getValue() != t->getValue() ||
+        b->getAndMask() != t->getAndMask() ||
+        b->getXorMask() != t->getXorMask() ||
+        b->getThreadId() != t->getThreadId() ||
+        b->getWhereId() != t->getWhereId() ||
+        b->getOccurrence() != t->getOccurrence())
+        panic("%s: the record and the text fault differ\n", what);
+}
+
+int
+main()
+{
+    const char *bin = "fifaultlisttest.bin";
+    FaultRecord records[3];
+    records[0] = record(FaultRecord::Register, 2, 1000, 3, 3, 0, 0, 1);
+    records[0].regType = 0;
+    records[0].arg0 = 5;
+    records[1] = record(FaultRecord::O3Struct, 2, 2000, 2, 255, 1, 0, 1);
+    records[1].regType = 2;
+    records[1].arg0 = 3;
+    records[2] = record(FaultRecord::GeneralFetch, 1, 5000, 1, 7, -1, -1, 2);
+    write_list(bin, records, 3, 2);
+
+    Fi_SystemParams *p = makeFiSystemParams();
+    p->input_fi = bin;
+    new Fi_System(p);
+    unlink(bin);
+
+    const char *txt = "fifaultlisttest.faults";
+    ofstream out(txt);
+    out << "RegisterInjectedFault Inst:1000 Flip:3 0 system.cpu 1 0 int 5\n";
+    out << "O3StructInjectedFault Inst:2000 Mask:255 1 system.cpu 1 0 rob 3 0\n";
+    out << "GeneralFetchInjectedFault Tick:5000 Immd:7 all all 2 0\n";
+    out.close();
+    ifstream in(txt);
+    fi_system->getFromFile(in);
+    in.close();
+    unlink(txt);
+
+    compare(fi_system->mainInjectedFaultQueue, "register");
+    compare(fi_system->o3StructInjectedFaultQueue, "structure");
+    compare(fi_system->fetchStageInjectedFaultQueue, "fetch");
+
+    RegisterInjectedFault *rb = reinterpret_cast<RegisterInjectedFault *>(
+        fi_system->mainInjectedFaultQueue.head);
+    RegisterInjectedFault *rt = reinterpret_cast<RegisterInjectedFault *>(rb->nxt);
+    if (rb->getRegister() != rt->getRegister() ||
+        rb->getRegType() != rt->getRegType())
+        panic("register: the record and the text fault differ\n");
+
+    O3StructInjectedFault *sb = reinterpret_cast<O3StructInjectedFault *>(
+        fi_system->o3StructInjectedFaultQueue.head);
+    O3StructInjectedFault *st = reinterpret_cast<O3StructInjectedFault *>(sb->nxt);
+    if (sb->getStruct() != st->getStruct() || sb->getEntry() != st->getEntry() ||
+        sb->getField() != st->getField())
+        panic("structure: the record and the text fault differ\n");
+
+    cprintf("binary records build the same faults as their text\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Checks the masks of the fault value models and measures the cost of
+ * InjectedFault::manifest() on structures of 1 to 8 bytes, next to the
+ * byte loop the masks used to be applied with.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <fstream>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "fi/faultq.hh"
+#include "fi/fi_system.hh"
+#include "unittest/fiparams.hh"
+
+using namespace std;
+
+static const uint64_t iterations = 50000000;
+
+double
+now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// the former InjectedFault::XOR
+template <class T>
+T
+byteLoopXor(T in, uint64_t out)
+{
+    unsigned char *inP = (unsigned char *)&in;
+    unsigned char *outP = (unsigned char *)&out;
+    for (int i = sizeof(T) - 1, j = sizeof(uint64_t) - 1; i >= 0; i--, j--)
+        inP[i] = inP[i] ^ outP[j];
+    return in;
+}
+
+InjectedFault *
+read_fault(const string &what)
+{
+    const char *fname = "fimanifesttime.faults";
+    ofstream out(fname);
+    out << "IEWStageInjectedFault Inst:1000000000 " << what
+        << " 0 system.cpu 1 0\n";
+    out.close();
+
+    ifstream in(fname);
+    fi_system->getFromFile(in);
+    in.close();
+    unlink(fname);
+
+    InjectedFault *f = fi_system->iewStageInjectedFaultQueue.head;
+    while (f->nxt)
+        f = f->nxt;
+    return f;
+}
+
+void
+check(const string &what, uint64_t in, uint64_t expected)
+{
+    uint64_t got = read_fault(what)->manifest(in);
+    if (got != expected)
+        panic("%s of %#x: %#x instead of %#x\n", what, in, got, expected);
+}
+
+template <class T>
+void
+time_manifest(const char *type, InjectedFault *f)
+{
+    T v = 0;
+    double t = now();
+    for (uint64_t i = 0; i < iterations; i++)
+        v = f->manifest((T)(v + i));
+    double word = now() - t;
+
+    t = now();
+    for (uint64_t i = 0; i < iterations; i++)
+        v = byteLoopXor((T)(v + i), f->getXorMask());
+    double loop = now() - t;
+
+    cprintf("%-9s word %6.2f ns  byte loop %6.2f ns  (%d)\n", type,
+            word * 1e9 / iterations, loop * 1e9 / iterations, (int)(v & 1));
+}
+
+int
+main()
+{
+    new Fi_System(makeFiSystemParams());
+
+    check("Flip:1", 0, 0x1);
+    check("Flip:64", 0, ULL(1) << 63);
+    check("Flip:65", 0x5, 0x5);
+    check("Mask:255", 0xf0f0, 0xf00f);
+    check("Immd:42", 0xffff, 42);
+    check("All0", 0x1234, 0);
+    check("All1", 0x1234, ~ULL(0));
+    check("Burst:3:4", 0, 0x3c);
+    check("Burst:63:4", 0, ULL(3) << 62);
+    // the same bits util/fi_faultlist.py draws
+    check("Rand:3:32:7", 0, 0x10800004);
+    check("Rand:5:64:12345", 0, ULL(0x280120000400));
+    if (read_fault("Flip:9")->manifest((uint8_t)0x5) != 0x5)
+        panic("a flip past a narrow structure changed it\n");
+    if (read_fault("Mask:65535")->manifest((uint8_t)0x0f) != 0xf0)
+        panic("a narrow structure does not take the low bits of the mask\n");
+
+    InjectedFault *f = read_fault("Rand:4:64:1");
+    time_manifest<uint8_t>("uint8_t", f);
+    time_manifest<uint16_t>("uint16_t", f);
+    time_manifest<uint32_t>("uint32_t", f);
+    time_manifest<uint64_t>("uint64_t", f);
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * Parameters of a Fi_System built by hand in the fault injection unit
+ * tests: the defaults of Fi_System.py with the campaign, digests,
+ * snapshots, switching, profiles, timelines, watchdog and outcome file
+ * off. Tests override what they exercise before creating the system.
+ */
+
+#ifndef __UNITTEST_FIPARAMS_HH__
+#define __UNITTEST_FIPARAMS_HH__
+
+#include "params/Fi_System.hh"
+
+inline Fi_SystemParams *
+makeFiSystemParams()
+{
+    Fi_SystemParams *params = new Fi_SystemParams;
+    params->name = "fi_system";
+    params->input_fi = "";
+    params->check_before_init = false;
+    params->inst_window = 10000000;
+    params->tick_window = 10000000000ULL;
+    params->campaign = false;
+    params->max_children = 1;
+    params->campaign_results = "";
+    params->digest_interval = 0;
+    params->golden_digests = "";
+    params->record_digests = false;
+    params->snapshot_interval = 0;
+    params->max_snapshots = 4;
+    params->snapshot_budget = 0;
+    params->snapshot_spill = false;
+    params->auto_switch = false;
+    params->switch_warmup = 1000000;
+    params->switch_warmup_ticks = 500000000;
+    params->lockstep_lanes = 0;
+    params->liveness_profile = "";
+    params->mem_uses = "";
+    params->mem_timeline = "";
+    params->record_mem_timeline = false;
+    params->golden_totals = "";
+    params->record_golden_totals = false;
+    params->hang_factor = 0;
+    params->watch_interval = 100000;
+    params->loop_samples = 0;
+    params->loop_window = 64;
+    params->outcome = "";
+    return params;
+}
+
+#endif // __UNITTEST_FIPARAMS_HH__
@@ -0,0 +1,78 @@
+/*
+ * Checks that the probe executions of the lockstep lanes leave the execute
+ * hooks alone: a thread whose instructions are each probed twice (a lane
+ * and the golden run) before they execute counts the same instructions
+ * and takes its execute fault on the same one as a thread without lanes.
+ */
+
+#include <unistd.h>
+
+#include <fstream>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "fi/cpu_threadInfo.hh"
+#include "fi/faultq.hh"
+#include "fi/fi_system.hh"
+#include "unittest/fiparams.hh"
+
+using namespace std;
+
+static const int insts = 20;
+
+// runs the thread and returns the instruction its fault hit (-1 if none)
+int
+run(int core, ThreadEnabledFault &thread, int probes)
+{
+    int hit = -1;
+    for (int i = 0; i < insts; i++) {
+        fi_system->set_probing(true);
+        for (int p = 0; p < probes; p++)
+            fi_system->iew_point(NULL, core, thread, 0, (uint64_t)0);
+        fi_system->set_probing(false);
+        if (fi_system->iew_point(NULL, core, thread, 0, (uint64_t)0) != 0) {
+            if (hit >= 0)
+                panic("the fault hit instructions %d and %d\n", hit, i);
+            hit = i;
+        }
+    }
+    return hit;
+}
+
+int
+main()
+{
+    new Fi_System(makeFiSystemParams());
+
+    const char *fname = "fiprobetest.faults";
+    ofstream out(fname);
+    out << "IEWStageInjectedFault Inst:5 Flip:1 0 system.cpu 1 0\n";
+    out << "IEWStageInjectedFault Inst:5 Flip:1 1 system.cpu 1 0\n";
+    out.close();
+    ifstream in(fname);
+    fi_system->getFromFile(in);
+    in.close();
+    unlink(fname);
+
+    int core = fi_system->get_core_id("system.cpu");
+    ThreadEnabledFault plain(0), laned(1);
+
+    int plainHit = run(core, plain, 0);
+    int lanedHit = run(core, laned, 2);
+
+    uint64_t plainExec =
+        plain.getCounters(ThreadEnabledFault::AllCores)->getInstrExecuted();
+    uint64_t lanedExec =
+        laned.getCounters(ThreadEnabledFault::AllCores)->getInstrExecuted();
+    if (plainExec != insts || lanedExec != plainExec)
+        panic("executed %d instructions with lanes, %d without\n",
+              lanedExec, plainExec);
+    if (plainHit < 0 || lanedHit != plainHit)
+        panic("the fault hit instruction %d with lanes, %d without\n",
+              lanedHit, plainHit);
+    if (fi_system->iewStageInjectedFaultQueue.head)
+        panic("a fault is still queued\n");
+
+    cprintf("lane probes leave the execute counters alone\n");
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Checks that an intermittent Tick timed fault is applied at most once by
+ * a hook when the tick counter of its thread jumps several cycles between
+ * two hooks, and that it is re-armed one cycle after that hook.
+ */
+
+#include <unistd.h>
+
+#include <fstream>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "fi/cpu_threadInfo.hh"
+#include "fi/faultq.hh"
+#include "fi/fi_system.hh"
+#include "unittest/fiparams.hh"
+
+using namespace std;
+
+static const Tick cycle = 500;
+
+// the scan loop of the hooks, with the re-arm of check4reschedule
+int
+hook(int core, ThreadEnabledFault &thread)
+{
+    int applied = 0;
+    InjectedFault *f;
+    while ((f = fi_system->mainInjectedFaultQueue.scan(core, thread, 0))) {
+        if (f->getOccurrence() == 1)
+            fi_system->mainInjectedFaultQueue.remove(f);
+        else
+            f->rearm(cycle, 4);
+        applied++;
+    }
+    return applied;
+}
+
+int
+main()
+{
+    new Fi_System(makeFiSystemParams());
+
+    const char *fname = "firearmtest.faults";
+    ofstream out(fname);
+    out << "RegisterInjectedFault Tick:1000 Flip:1 0 system.cpu 4 0 int 1\n";
+    out.close();
+    ifstream in(fname);
+    fi_system->getFromFile(in);
+    in.close();
+    unlink(fname);
+    InjectedFault *f = fi_system->mainInjectedFaultQueue.head;
+
+    int core = fi_system->get_core_id("system.cpu");
+    ThreadEnabledFault thread(0);
+
+    thread.increaseTicks(core, cycle);
+    if (hook(core, thread) != 0)
+        panic("the fault was applied before its tick\n");
+
+    // ten cycles go by between two hooks
+    thread.increaseTicks(core, 10 * cycle);
+    if (hook(core, thread) != 1)
+        panic("a hook applied the fault more than once\n");
+    if (f->getOccurrence() != 3 || f->getTiming() != 11 * cycle + cycle)
+        panic("re-armed at %d with %d occurrences left\n", f->getTiming(),
+              f->getOccurrence());
+
+    if (hook(core, thread) != 0)
+        panic("the fault was applied again before the next cycle\n");
+
+    for (int i = 0; i < 3; i++) {
+        thread.increaseTicks(core, cycle);
+        if (hook(core, thread) != 1)
+            panic("the fault was not applied once on cycle %d\n", i);
+    }
+    if (fi_system->mainInjectedFaultQueue.head)
+        panic("the fault is still queued after its occurrences\n");
+
+    cprintf("intermittent fault applied once per hook\n");
+    return 0;
+}
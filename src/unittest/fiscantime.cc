@@ -0,0 +1,84 @@
+/*
+ * Measures the cost of InjectedFaultQueue::scan() while nothing is due
+ * for fault queues of 1 up to 1M pending faults. The cost per scan should
+ * stay flat since only the earliest fault of every trigger is compared.
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "fi/cpu_threadInfo.hh"
+#include "fi/faultq.hh"
+#include "fi/fi_system.hh"
+#include "unittest/fiparams.hh"
+
+using namespace std;
+
+volatile int stop = false;
+
+void
+handle_alarm(int signal)
+{
+    stop = true;
+}
+
+void
+do_test(int seconds)
+{
+    stop = false;
+    alarm(seconds);
+}
+
+// Append faults [from, to) to the IEW queue, all of them far in the future
+void
+add_faults(uint64_t from, uint64_t to)
+{
+    const char *fname = "fiscantime.faults";
+    ofstream out(fname);
+    for (uint64_t i = from; i < to; i++) {
+        out << "IEWStageInjectedFault Inst:" << (1000000000000ULL + i)
+            << " Flip:1 0 system.cpu 1 0\n";
+    }
+    out.close();
+
+    ifstream in(fname);
+    fi_system->getFromFile(in);
+    in.close();
+    unlink(fname);
+}
+
+int
+main()
+{
+    new Fi_System(makeFiSystemParams());
+
+    int cpu = fi_system->get_core_id("system.cpu");
+    ThreadEnabledFault thread(0);
+    thread.increaseExecutedInstr(cpu);
+    thread.increaseExecutedInstr(cpu);
+
+    signal(SIGALRM, handle_alarm);
+
+    uint64_t queued = 0;
+    for (uint64_t size = 1; size <= 1000000; size *= 10) {
+        add_faults(queued, size);
+        queued = size;
+
+        uint64_t iterations = 0;
+        do_test(2);
+        while (!stop) {
+            if (fi_system->iewStageInjectedFaultQueue.scan(cpu, thread, 0))
+                panic("no fault should be due\n");
+            thread.increaseExecutedInstr(cpu);
+            iterations += 1;
+        }
+
+        cprintf("%8d queued faults: %f scans/s\n", queued, iterations / 2.0);
+    }
+
+    return 0;
+}
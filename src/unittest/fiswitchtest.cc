@@ -0,0 +1,80 @@
+/*
+ * Checks that the faults of a core are bound to the cpu that took the
+ * core over last (Fi_System::switch_core), as the detailed cpus do in
+ * the detailed window of auto_switch.
+ */
+
+#include <unistd.h>
+
+#include <fstream>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "fi/faultq.hh"
+#include "fi/fi_system.hh"
+#include "unittest/fiparams.hh"
+
+using namespace std;
+
+InjectedFault *
+read_fault(const string &line, InjectedFaultQueue &q)
+{
+    const char *fname = "fiswitchtest.faults";
+    ofstream out(fname);
+    out << line << "\n";
+    out.close();
+
+    ifstream in(fname);
+    fi_system->getFromFile(in);
+    in.close();
+    unlink(fname);
+
+    InjectedFault *f = q.head;
+    while (f->nxt)
+        f = f->nxt;
+    return f;
+}
+
+void
+check(InjectedFault *f, int core, BaseCPU *expected, const char *what)
+{
+    fi_system->set_fault_cpu(f, core);
+    if (f->getCPU() != expected)
+        panic("%s fault bound to %#x instead of %#x\n", what, f->getCPU(),
+              expected);
+}
+
+int
+main()
+{
+    Fi_SystemParams *params = makeFiSystemParams();
+    params->auto_switch = true;
+    new Fi_System(params);
+
+    // stand-ins for the atomic and detailed cpus, only compared
+    char atomic_cpu, detailed_cpu;
+    BaseCPU *atomic = reinterpret_cast<BaseCPU *>(&atomic_cpu);
+    BaseCPU *detailed = reinterpret_cast<BaseCPU *>(&detailed_cpu);
+
+    int core = fi_system->get_core_id("system.cpu");
+    InjectedFault *reg = read_fault("RegisterInjectedFault Inst:1000 Flip:1 0 "
+                                    "system.cpu 1 0 int 1",
+                                    fi_system->mainInjectedFaultQueue);
+    InjectedFault *fetch = read_fault("GeneralFetchInjectedFault Inst:1000 "
+                                      "Flip:1 0 system.cpu 1 0",
+                                      fi_system->fetchStageInjectedFaultQueue);
+
+    fi_system->switch_core(core, atomic);
+    check(reg, core, atomic, "register");
+    check(fetch, core, atomic, "fetch");
+
+    fi_system->switch_core(core, detailed);
+    check(reg, core, detailed, "register");
+    check(fetch, core, detailed, "fetch");
+
+    fi_system->switch_core(core, atomic);
+    check(fetch, core, atomic, "fetch");
+
+    cprintf("faults follow the cpu of their core\n");
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Checks that the return address stack entries warmed from executed calls
+ * (ReturnAddrStack::pushCall, used by BPredUnit::warm) predict the same
+ * return address as the entries fetch pushes.
+ */
+
+#include "arch/types.hh"
+#include "arch/utility.hh"
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "cpu/pred/ras.hh"
+
+using namespace std;
+
+// the state of a call at pc once it has executed: npc is its target
+TheISA::PCState
+executed_call(Addr pc, Addr target)
+{
+    TheISA::PCState call(pc);
+    call.npc(target);
+    return call;
+}
+
+// what predict() does for a return at pc
+Addr
+predict_return(ReturnAddrStack &ras, Addr pc)
+{
+    TheISA::PCState ret = TheISA::buildRetPC(TheISA::PCState(pc), ras.top());
+    ras.pop();
+    return ret.pc();
+}
+
+int
+main()
+{
+    const Addr step = sizeof(TheISA::MachInst);
+    ReturnAddrStack fetched, warmed;
+    fetched.init(16);
+    warmed.init(16);
+
+    // main calls f at 0x1000, f calls g at 0x2010
+    fetched.push(TheISA::PCState(0x1000));
+    warmed.pushCall(executed_call(0x1000, 0x2000));
+    fetched.push(TheISA::PCState(0x2010));
+    warmed.pushCall(executed_call(0x2010, 0x3000));
+
+    Addr from_fetch = predict_return(fetched, 0x3040);
+    Addr from_warm = predict_return(warmed, 0x3040);
+    if (from_warm != 0x2010 + step || from_warm != from_fetch)
+        panic("return from g predicted %#x, fetch predicts %#x\n",
+              from_warm, from_fetch);
+
+    from_fetch = predict_return(fetched, 0x2020);
+    from_warm = predict_return(warmed, 0x2020);
+    if (from_warm != 0x1000 + step || from_warm != from_fetch)
+        panic("return from f predicted %#x, fetch predicts %#x\n",
+              from_warm, from_fetch);
+
+    cprintf("warmed calls predict their return address\n");
+    return 0;
+}
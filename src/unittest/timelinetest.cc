@@ -0,0 +1,90 @@
+/*
+ * Checks AccessTimeline::next() against a plain list of the accesses, for
+ * random accesses to a few lines, before and after a write/read round
+ * trip of the timeline.
+ */
+
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "base/misc.hh"
+#include "mem/access_timeline.hh"
+
+using namespace std;
+
+struct Access
+{
+    Addr addr;
+    unsigned size;
+    bool write;
+    uint64_t stamp;
+};
+
+AccessTimeline::Next
+expected(const vector<Access> &accesses, Addr addr, uint64_t stamp)
+{
+    for (size_t i = 0; i < accesses.size(); i++) {
+        const Access &a = accesses[i];
+        if (a.stamp >= stamp && a.addr <= addr && addr < a.addr + a.size)
+            return a.write ? AccessTimeline::Write : AccessTimeline::Read;
+    }
+    return AccessTimeline::None;
+}
+
+int
+check(const AccessTimeline &tl, const vector<Access> &accesses,
+      uint64_t stamps, Addr bytes)
+{
+    int errors = 0;
+    for (uint64_t s = 0; s <= stamps + 1; s++)
+        for (Addr b = 0; b < bytes; b++)
+            if (tl.next(b, s) != expected(accesses, b, s)) {
+                cprintf("byte %d stamp %d: %d instead of %d\n", b, s,
+                        tl.next(b, s), expected(accesses, b, s));
+                errors++;
+            }
+    return errors;
+}
+
+int
+main()
+{
+    const Addr bytes = 4 * AccessTimeline::LineBytes;
+    const unsigned sizes[] = { 1, 2, 4, 8, 64 };
+    AccessTimeline tl;
+    vector<Access> accesses;
+
+    srandom(1);
+    uint64_t stamp = 0;
+    for (int i = 0; i < 2000; i++) {
+        Access a;
+        a.size = sizes[random() % 5];
+        // repeated accesses to the same bytes make runs
+        if (!accesses.empty() && random() % 2) {
+            a.addr = accesses.back().addr;
+            a.size = accesses.back().size;
+        }
+        else
+            a.addr = (random() % (bytes / a.size)) * a.size;
+        a.write = random() % 3 == 0;
+        stamp += random() % 3;
+        a.stamp = stamp;
+        accesses.push_back(a);
+        tl.record(a.addr, a.size, a.write, a.stamp);
+    }
+
+    int errors = check(tl, accesses, stamp, bytes);
+
+    stringstream ss;
+    tl.write(ss);
+    AccessTimeline copy;
+    copy.read(ss);
+    errors += check(copy, accesses, stamp, bytes);
+
+    cprintf("%d accesses, %d lines, %d runs, %d bytes: %d errors\n",
+            accesses.size(), copy.numLines(), tl.numRuns(), ss.str().size(),
+            errors);
+    return errors ? 1 : 0;
+}
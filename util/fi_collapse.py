@@ -0,0 +1,151 @@
+#!/usr/bin/env python
+
+# Groups the equivalent faults of a fault injection input file (text format
+# of src/fi/description) so a campaign simulates one fault per class.
+#
+# Two transient faults with the same value are equivalent if they hit
+# - the same integer/float register of the same thread and scope (Inst
+#   timed) before the same access of the golden run, from the register
+#   liveness profile (--fi-liveness-profile, src/fi/reg_liveness.hh), or
+# - the same physical byte before the same access of the memory, from the
+#   memory uses of a run that observed the faults (--fi-mem-uses).
+# Every other fault is a class of its own.
+#
+# The first fault of each class is written one per line to the output and
+# the classes to out.classes ("<id in the output> <size> <ids in the input>").
+# --weigh adds up the campaign results of the output weighted by the size of
+# the classes.
+#
+# Usage: fi_collapse.py -o reps.txt [-p profile] [-m mem_uses.txt] faults.txt
+#        fi_collapse.py --weigh reps.txt.classes fi_campaign.txt
+
+import optparse
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import fi_faultlist
+import fi_prune
+
+def read_mem_uses(path):
+    uses = {}
+    for line in open(path):
+        tok = line.split()
+        if len(tok) < 4 or tok[0] != 'fault':
+            continue
+        if tok[3] == 'none':
+            uses[int(tok[1])] = None
+        else:
+            uses[int(tok[1])] = (int(tok[3]), ' '.join(tok[5:]))
+    return uses
+
+def class_key(i, fault, profile, uses):
+    cores, records = fi_faultlist.parse(fault)
+    (timing, value, arg0, arg1, thread, core, occ, tcontext, kind,
+     timing_type, value_type, reg_type) = records[0]
+    name = fi_faultlist.TYPES[kind]
+    if occ != 1:
+        return None
+    what = (value_type, value)
+
+    if (name == 'RegisterInjectedFault' and profile and
+        timing_type == fi_faultlist.INST and tcontext == 0 and
+        fi_faultlist.REG_TYPES[reg_type] != 'misc'):
+        reg = arg0 + (fi_prune.NUM_INT_REGS if reg_type == 1 else 0)
+        where = 'all' if core < 0 else cores[core]
+        scope = -1 if where == 'all' else profile.core_id(where)
+        if scope is None or (thread, scope) not in profile.ends:
+            return None
+        t = max(timing, 1)
+        cpus = range(len(profile.cores)) if scope == -1 else [scope]
+        nexts = tuple(profile.next_access(thread, scope, c, reg, t)[0]
+                      for c in cpus)
+        return ('reg', thread, scope, reg, what, nexts)
+
+    if name == 'MemoryInjectedFault' and uses and uses.get(i):
+        addr, use = uses[i]
+        return ('mem', addr, what, use)
+    return None
+
+def collapse(options, path):
+    profile = fi_prune.Profile(options.profile) if options.profile else None
+    uses = read_mem_uses(options.mem_uses) if options.mem_uses else None
+    faults = fi_prune.split_faults(open(path).read().split())
+
+    classes = []
+    index = {}
+    for i, fault in enumerate(faults):
+        key = class_key(i, fault, profile, uses)
+        if key is None:
+            classes.append([i])
+        elif key in index:
+            classes[index[key]].append(i)
+        else:
+            index[key] = len(classes)
+            classes.append([i])
+
+    out = open(options.out, 'w')
+    for c in classes:
+        out.write(' '.join(faults[c[0]]) + '\n')
+    out.close()
+    out = open(options.out + '.classes', 'w')
+    for rep, c in enumerate(classes):
+        out.write('%d %d %s\n' % (rep, len(c), ' '.join(map(str, c))))
+    out.close()
+
+    print("faults: %d classes: %d (%.1fx fewer experiments)" %
+          (len(faults), len(classes),
+           float(len(faults)) / len(classes) if classes else 0))
+
+RESULT = re.compile(r'fault (\d+) .*code (-?\d+) cause "(.*)"')
+
+def weigh(classes_path, results_path):
+    weight = {}
+    for line in open(classes_path):
+        tok = line.split()
+        weight[int(tok[0])] = int(tok[1])
+
+    outcomes = {}
+    done = set()
+    for line in open(results_path):
+        m = RESULT.match(line)
+        if not m or int(m.group(1)) not in weight or int(m.group(1)) in done:
+            continue
+        rep = int(m.group(1))
+        done.add(rep)
+        key = (int(m.group(2)), m.group(3))
+        outcomes[key] = outcomes.get(key, 0) + weight[rep]
+
+    total = sum(outcomes.values())
+    for (code, cause), n in sorted(outcomes.items(), key=lambda o: -o[1]):
+        print("%10d %6.2f%% code %d cause \"%s\"" %
+              (n, 100.0 * n / total, code, cause))
+    print("experiments: %d of %d, faults covered: %d of %d" %
+          (len(done), len(weight), total, sum(weight.values())))
+
+def main():
+    parser = optparse.OptionParser(usage="%prog -o reps.txt [-p profile] "
+                                   "[-m mem_uses.txt] faults.txt\n"
+                                   "       %prog --weigh reps.txt.classes results.txt")
+    parser.add_option("-o", dest="out", default=None,
+                      help="write one fault per class here (and the classes to out.classes)")
+    parser.add_option("-p", dest="profile", default=None,
+                      help="register liveness profile of the golden run")
+    parser.add_option("-m", dest="mem_uses", default=None,
+                      help="memory uses of a run that observed the faults")
+    parser.add_option("--weigh", action="store_true", default=False,
+                      help="weigh the campaign results of the classes")
+    (options, args) = parser.parse_args()
+
+    if options.weigh:
+        if len(args) != 2:
+            parser.error("--weigh needs a classes and a results file")
+        weigh(args[0], args[1])
+    else:
+        if len(args) != 1 or not options.out:
+            parser.error("-o and a fault file are needed")
+        collapse(options, args[0])
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,182 @@
+#!/usr/bin/env python
+
+# Converts a fault injection input file from the text format described in
+# src/fi/description to the binary fault list read by Fi_System
+# (src/fi/fault_list.hh), or dumps a binary fault list back to text.
+#
+# Usage: fi_faultlist.py faults.txt faults.bin
+#        fi_faultlist.py -d faults.bin
+
+import struct
+import sys
+
+MAGIC = b'M5FILST\0'
+VERSION = 1
+CORE_NAME_LEN = 64
+
+HEADER = struct.Struct('<8sIIQQQ')
+RECORD = struct.Struct('<QQqqiiiiBBBB4x')
+
+# FaultRecord::Type, in the order of src/fi/description
+TYPES = ['GeneralFetchInjectedFault',
+         'IEWStageInjectedFault',
+         'MemoryInjectedFault',
+         'OpCodeInjectedFault',
+         'PCInjectedFault',
+         'RegisterInjectedFault',
+         'RegisterDecodingInjectedFault',
+         'CPUInjectedFault',
+         'InjectedFault',
+         'O3CPUInjectedFault',
+         'O3StructInjectedFault']
+
+TICK, INST, ADDR = 1, 2, 3
+TIMINGS = {'Tick': TICK, 'Inst': INST, 'Addr': ADDR}
+VALUES = {'Immd': 1, 'Mask': 2, 'Flip': 3}
+ALL_VALUE = 4
+REG_TYPES = ['int', 'float', 'misc']
+# BaseO3CPU::FiStructure
+STRUCTS = ['intphys', 'floatphys', 'rob', 'iq', 'lsq']
+
+MASK64 = (1 << 64) - 1
+
+# the multi-bit upsets are stored as the xor mask they amount to, drawn as
+# InjectedFault::parseWhat (src/fi/faultq.cc) does
+def burst_mask(bit, k):
+    return sum(1 << (bit - 1 + i) for i in range(k)
+               if bit and bit - 1 + i < 64)
+
+def random_mask(k, n, seed):
+    n = min(n, 64)
+    k = min(k, n)
+    mask = 0
+    while bin(mask).count('1') < k:
+        seed = (seed + 0x9e3779b97f4a7c15) & MASK64
+        z = seed
+        z = ((z ^ (z >> 30)) * 0xbf58476d1ce4e5b9) & MASK64
+        z = ((z ^ (z >> 27)) * 0x94d049bb133111eb) & MASK64
+        z ^= z >> 31
+        mask |= 1 << (z % n)
+    return mask
+
+def parse(tokens):
+    cores = []
+    records = []
+    tokens = iter(tokens)
+    for name in tokens:
+        if name not in TYPES:
+            sys.exit("unknown fault type %s" % name)
+        kind = TYPES.index(name)
+        when, what, thread, where, occ = [next(tokens) for i in range(5)]
+
+        timing_type = TIMINGS.get(when[:4])
+        if timing_type is None:
+            sys.exit("unsupported timing %s" % when)
+        timing = int(when[5:])
+
+        if what in ('All0', 'All1'):
+            value_type, value = ALL_VALUE, int(what[3])
+        elif what[:6] == 'Burst:':
+            bit, k = [int(v) for v in what[6:].split(':')]
+            value_type, value = VALUES['Mask'], burst_mask(bit, k)
+        elif what[:5] == 'Rand:':
+            k, n, seed = [int(v) for v in what[5:].split(':')]
+            value_type, value = VALUES['Mask'], random_mask(k, n, seed)
+        elif what[:4] in VALUES:
+            value_type, value = VALUES[what[:4]], int(what[5:])
+        else:
+            sys.exit("unsupported value %s" % what)
+
+        thread = -1 if thread == 'all' else int(thread)
+        if where == 'all':
+            core = -1
+        else:
+            if where not in cores:
+                if len(where) > CORE_NAME_LEN:
+                    sys.exit("core name %s is too long" % where)
+                cores.append(where)
+            core = cores.index(where)
+
+        tcontext = arg0 = arg1 = reg_type = 0
+        if name != 'InjectedFault':
+            tcontext = int(next(tokens))
+        if name == 'RegisterInjectedFault':
+            reg_type = REG_TYPES.index(next(tokens))
+            arg0 = int(next(tokens))
+        elif name == 'MemoryInjectedFault':
+            arg1 = int(next(tokens))
+            arg0 = int(next(tokens))
+        elif name == 'RegisterDecodingInjectedFault':
+            regdec = next(tokens).split(':')
+            reg_type = 0 if regdec[0] == 'Src' else 1
+            arg0, arg1 = int(regdec[1]), int(regdec[2])
+        elif name == 'O3StructInjectedFault':
+            reg_type = STRUCTS.index(next(tokens))
+            arg0 = int(next(tokens))
+            arg1 = int(next(tokens))
+
+        records.append((timing, value, arg0, arg1, thread, core, int(occ),
+                        tcontext, kind, timing_type, value_type, reg_type))
+    return cores, records
+
+def write(path, cores, records):
+    # Addr timed faults first, then Inst and Tick timed ones by timing;
+    # the sort is stable so faults of equal timing keep their order
+    addr = [r for r in records if r[9] == ADDR]
+    inst = sorted([r for r in records if r[9] == INST], key=lambda r: r[0])
+    tick = sorted([r for r in records if r[9] == TICK], key=lambda r: r[0])
+
+    out = open(path, 'wb')
+    out.write(HEADER.pack(MAGIC, VERSION, len(cores), len(records),
+                          len(addr), len(inst)))
+    for core in cores:
+        out.write(core.encode().ljust(CORE_NAME_LEN, b'\0'))
+    for r in addr + inst + tick:
+        out.write(RECORD.pack(*r))
+    out.close()
+
+def dump(path):
+    data = open(path, 'rb').read()
+    magic, version, ncores, nrecords, naddr, ninst = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("%s is not a version %d fault list" % (path, VERSION))
+    off = HEADER.size
+    cores = []
+    for i in range(ncores):
+        cores.append(data[off:off + CORE_NAME_LEN].rstrip(b'\0').decode())
+        off += CORE_NAME_LEN
+    when = dict((v, k) for k, v in TIMINGS.items())
+    what = dict((v, k) for k, v in VALUES.items())
+    for i in range(nrecords):
+        (timing, value, arg0, arg1, thread, core, occ, tcontext, kind,
+         timing_type, value_type, reg_type) = RECORD.unpack_from(data, off)
+        off += RECORD.size
+        name = TYPES[kind]
+        line = [name, '%s:%d' % (when[timing_type], timing)]
+        if value_type == ALL_VALUE:
+            line.append('All%d' % value)
+        else:
+            line.append('%s:%d' % (what[value_type], value))
+        line.append('all' if thread < 0 else str(thread))
+        line.append('all' if core < 0 else cores[core])
+        line.append(str(occ))
+        if name != 'InjectedFault':
+            line.append(str(tcontext))
+        if name == 'RegisterInjectedFault':
+            line += [REG_TYPES[reg_type], str(arg0)]
+        elif name == 'MemoryInjectedFault':
+            line += [str(arg1), str(arg0)]
+        elif name == 'RegisterDecodingInjectedFault':
+            line.append('%s:%d:%d' % (('Src', 'Dst')[reg_type], arg0, arg1))
+        elif name == 'O3StructInjectedFault':
+            line += [STRUCTS[reg_type], str(arg0), str(arg1)]
+        print(' '.join(line))
+
+if __name__ == '__main__':
+    if len(sys.argv) == 3 and sys.argv[1] == '-d':
+        dump(sys.argv[2])
+    elif len(sys.argv) == 3:
+        cores, records = parse(open(sys.argv[1]).read().split())
+        write(sys.argv[2], cores, records)
+    else:
+        sys.exit("usage: %s faults.txt faults.bin | -d faults.bin" % sys.argv[0])
@@ -0,0 +1,172 @@
+#!/usr/bin/env python
+
+# Drops the register faults of a fault injection input file (text format of
+# src/fi/description) that hit a dead register, using the register liveness
+# profile of the golden run (--fi-liveness-profile, src/fi/reg_liveness.hh).
+#
+# A transient Inst timed integer/float RegisterInjectedFault is dead if the
+# first access of its thread to the register after the fault writes it, or
+# if there is none. Every other fault is kept. The kept faults are written
+# one per line to the output, with a map of their new position to the
+# position in the input file (the fault ids of the campaign results).
+#
+# Usage: fi_prune.py [-o pruned.txt] profile faults.txt
+
+import bisect
+import optparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import fi_faultlist
+
+MAGIC = b'M5FIRLV1'
+NUM_INT_REGS = 32
+
+class Profile(object):
+    def __init__(self, path):
+        self.data = open(path, 'rb').read()
+        self.off = 0
+        if self.data[:8] != MAGIC:
+            sys.exit("%s is not a register liveness profile" % path)
+        self.off = 8
+
+        self.cores = []
+        for i in range(self.varint()):
+            n = self.varint()
+            self.cores.append(self.data[self.off:self.off + n].decode())
+            self.off += n
+        self.seconds = self.varint() / 1000.0
+
+        # (thread, scope) -> one past the last stamp
+        self.ends = {}
+        for i in range(self.varint()):
+            thread, scope = self.varint() - 1, self.varint() - 1
+            self.ends[(thread, scope)] = self.varint()
+
+        # (thread, scope, core, reg) -> last stamps and kinds of the runs
+        self.streams = {}
+        for i in range(self.varint()):
+            thread, scope = self.varint() - 1, self.varint() - 1
+            core, reg, runs = self.varint(), self.varint(), self.varint()
+            self.varint() # length of the runs
+            stamps, kinds = [], []
+            last = 0
+            for r in range(runs):
+                v = self.varint()
+                last += v >> 1
+                stamps.append(last)
+                kinds.append(v & 1)
+            self.streams[(thread, scope, core, reg)] = (stamps, kinds)
+
+    def varint(self):
+        v = shift = 0
+        while True:
+            b = ord(self.data[self.off:self.off + 1])
+            self.off += 1
+            v |= (b & 0x7f) << shift
+            shift += 7
+            if b < 0x80:
+                return v
+
+    # index of the run of the first access at or after t, and whether it
+    # reads the register (-1 and False if there is none)
+    def next_access(self, thread, scope, core, reg, t):
+        stream = self.streams.get((thread, scope, core, reg))
+        if stream is None:
+            return -1, False
+        stamps, kinds = stream
+        i = bisect.bisect_left(stamps, t)
+        if i == len(stamps):
+            return -1, False
+        return i, kinds[i] == 0
+
+    def live_on(self, thread, scope, core, reg, t):
+        return self.next_access(thread, scope, core, reg, t)[1]
+
+    # True/False, or None if the profile does not cover the scope
+    def live(self, thread, where, reg, t):
+        scope = -1 if where == 'all' else self.core_id(where)
+        if scope is None or (thread, scope) not in self.ends:
+            return None
+        cores = range(len(self.cores)) if scope == -1 else [scope]
+        # the core the fault hits is not known ahead for the all cores scope
+        return any(self.live_on(thread, scope, c, reg, t) for c in cores)
+
+    def core_id(self, name):
+        if name in self.cores:
+            return self.cores.index(name)
+        return None
+
+def split_faults(tokens):
+    faults = []
+    for tok in tokens:
+        if tok in fi_faultlist.TYPES or not faults:
+            faults.append([])
+        faults[-1].append(tok)
+    return faults
+
+def classify(profile, fault):
+    cores, records = fi_faultlist.parse(fault)
+    (timing, value, reg, arg1, thread, core, occ, tcontext, kind,
+     timing_type, value_type, reg_type) = records[0]
+    if (fi_faultlist.TYPES[kind] != 'RegisterInjectedFault' or
+        timing_type != fi_faultlist.INST or occ != 1 or tcontext != 0 or
+        fi_faultlist.REG_TYPES[reg_type] == 'misc'):
+        return None, None
+    if reg_type == 1:
+        reg += NUM_INT_REGS
+    where = 'all' if core < 0 else cores[core]
+    # the scan only starts once the counter of the scope is past zero
+    t = max(timing, 1)
+    scope = -1 if where == 'all' else profile.core_id(where)
+    return profile.live(thread, where, reg, t), (thread, scope, t)
+
+def main():
+    parser = optparse.OptionParser(usage="%prog [-o pruned.txt] profile faults.txt")
+    parser.add_option("-o", dest="out", default=None,
+                      help="write the kept faults here (and their map to out.map)")
+    (options, args) = parser.parse_args()
+    if len(args) != 2:
+        parser.error("a profile and a fault file are needed")
+
+    profile = Profile(args[0])
+    faults = split_faults(open(args[1]).read().split())
+
+    kept = []
+    live = dead = unknown = 0
+    saved = 0.0
+    for i, fault in enumerate(faults):
+        state, scope = classify(profile, fault)
+        if state is False:
+            dead += 1
+            thread, core, t = scope
+            end = profile.ends[(thread, core)]
+            if t < end:
+                saved += profile.seconds * (end - t) / end
+            continue
+        if state is None:
+            unknown += 1
+        else:
+            live += 1
+        kept.append(i)
+
+    if options.out:
+        out = open(options.out, 'w')
+        for i in kept:
+            out.write(' '.join(faults[i]) + '\n')
+        out.close()
+        out = open(options.out + '.map', 'w')
+        for new, i in enumerate(kept):
+            out.write('%d %d\n' % (new, i))
+        out.close()
+
+    total = len(faults)
+    print("faults: %d live: %d dead: %d not classified: %d" %
+          (total, live, dead, unknown))
+    print("removed: %.2f%%" % (100.0 * dead / total if total else 0))
+    print("estimated time saved: %.1f s (golden run %.1f s per experiment)" %
+          (saved, profile.seconds))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+
+# Compares the simulation throughput of gem5.fast-nofi (fault hooks compiled
+# out) against a fault injection build on the configs/boot/micro_*.rcS
+# workloads. Both binaries run the same fs.py command line, no fault is
+# injected; host_inst_rate of the first stats dump is compared.
+#
+# Usage: fi_throughput.py [-o outdir] [-w workload]... fi-binary nofi-binary
+#            [-- fs.py options]
+#
+# The Alpha full system files are found through M5_PATH as for fs.py.
+
+import glob
+import os
+import subprocess
+import sys
+from optparse import OptionParser
+
+def stat(path, name):
+    for line in open(path):
+        fields = line.split()
+        if fields and fields[0] == name:
+            return float(fields[1])
+        if line.startswith('---------- End Simulation Statistics'):
+            break
+    return None
+
+def run(binary, outdir, script, extra):
+    cmd = [binary, '--outdir=%s' % outdir, 'configs/example/fs.py',
+           '--script=%s' % script] + extra
+    with open(os.path.join(outdir, 'run.log'), 'w') as log:
+        if subprocess.call(cmd, stdout=log, stderr=subprocess.STDOUT) != 0:
+            sys.exit('%s failed, see %s' % (' '.join(cmd), log.name))
+    stats = os.path.join(outdir, 'stats.txt')
+    return stat(stats, 'host_inst_rate'), stat(stats, 'host_seconds')
+
+def main():
+    parser = OptionParser(usage='%prog [options] fi-binary nofi-binary '
+                          '[-- fs.py options]')
+    parser.add_option('-o', '--outdir', default='fi_throughput',
+                      help='directory the runs write their output to')
+    parser.add_option('-w', '--workload', action='append', default=[],
+                      help='rcS script to run (default: all micro_*.rcS)')
+    (options, args) = parser.parse_args()
+    if len(args) < 2:
+        parser.error('need the fault injection and the nofi binaries')
+
+    fi_bin, nofi_bin, extra = args[0], args[1], args[2:]
+    scripts = options.workload or \
+        sorted(glob.glob(os.path.join('configs', 'boot', 'micro_*.rcS')))
+
+    print '%-24s %14s %14s %8s' % ('workload', 'fi inst/s', 'nofi inst/s',
+                                   'speedup')
+    for script in scripts:
+        name = os.path.splitext(os.path.basename(script))[0]
+        rates = []
+        for variant, binary in (('fi', fi_bin), ('nofi', nofi_bin)):
+            outdir = os.path.join(options.outdir, '%s.%s' % (name, variant))
+            if not os.path.isdir(outdir):
+                os.makedirs(outdir)
+            rates.append(run(binary, outdir, script, extra)[0])
+        if None in rates:
+            print '%-24s no host_inst_rate in stats.txt' % name
+            continue
+        print '%-24s %14.0f %14.0f %7.3fx' % (name, rates[0], rates[1],
+                                             rates[1] / rates[0])
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+
+# Converts the gzipped memory images (.physmem) of a checkpoint to the
+# uncompressed images (.physmem.raw) that AbstractMemory maps copy on write
+# on restore, or back with -z, and updates the filename entries of m5.cpt.
+# All zero pages are left as holes so the raw images stay sparse.
+#
+# Usage: physmem_convert.py [-z] checkpoint_dir
+#
+# Delta images (.physmem.delta) are left alone, their delta_base still
+# names the image of the checkpoint they were taken against.
+
+import gzip
+import os
+import sys
+
+try:
+    import ConfigParser as configparser
+except ImportError:
+    import configparser
+
+CHUNK = 1 << 20
+PAGE = 8192
+
+def to_raw(src, dst):
+    inp = gzip.open(src, 'rb')
+    out = open(dst, 'wb')
+    size = 0
+    while True:
+        data = inp.read(CHUNK)
+        if not data:
+            break
+        for off in range(0, len(data), PAGE):
+            page = data[off:off + PAGE]
+            if page.count(b'\0') != len(page):
+                out.seek(size + off)
+                out.write(page)
+        size += len(data)
+    out.truncate(size)
+    out.close()
+    inp.close()
+
+def to_gzip(src, dst):
+    inp = open(src, 'rb')
+    out = gzip.open(dst, 'wb')
+    while True:
+        data = inp.read(CHUNK)
+        if not data:
+            break
+        out.write(data)
+    out.close()
+    inp.close()
+
+def convert(cpt_dir, compress):
+    path = os.path.join(cpt_dir, 'm5.cpt')
+    cpt = configparser.RawConfigParser()
+    cpt.optionxform = str
+    cpt.read(path)
+
+    src_suffix, dst_suffix = '.physmem', '.physmem.raw'
+    if compress:
+        src_suffix, dst_suffix = dst_suffix, src_suffix
+
+    converted = 0
+    for sec in cpt.sections():
+        if not cpt.has_option(sec, 'filename'):
+            continue
+        name = cpt.get(sec, 'filename')
+        if not name.endswith(src_suffix):
+            continue
+        new = name[:-len(src_suffix)] + dst_suffix
+        print("%s: %s -> %s" % (sec, name, new))
+        if compress:
+            to_gzip(os.path.join(cpt_dir, name), os.path.join(cpt_dir, new))
+        else:
+            to_raw(os.path.join(cpt_dir, name), os.path.join(cpt_dir, new))
+        os.remove(os.path.join(cpt_dir, name))
+        cpt.set(sec, 'filename', new)
+        converted += 1
+
+    if converted:
+        out = open(path, 'w')
+        cpt.write(out)
+        out.close()
+    return converted
+
+if __name__ == '__main__':
+    args = sys.argv[1:]
+    compress = False
+    if args and args[0] == '-z':
+        compress = True
+        args = args[1:]
+    if len(args) != 1:
+        sys.exit("usage: %s [-z] checkpoint_dir" % sys.argv[0])
+    if not convert(args[0], compress):
+        print("no memory image to convert in %s" % args[0])